@@ -25,11 +25,25 @@ THE SOFTWARE.
 #ifndef af_BindToEvent_h_HAS_BEEN_INCLUDED
 #define af_BindToEvent_h_HAS_BEEN_INCLUDED
 
-#include <boost/bind.hpp>
-
-// Define a macro to hide the internals of dealing with boost::bind.
+#include <QtGlobal>
+
+#include "EventSignal.h"
+
+// Define a macro to hide the internals of binding a member function to a
+// delegate. The method is bound at compile time. A plain instance pointer
+// is all that is stored, smart pointers are stored by value. Methods may
+// return a value, which is discarded.
+//
+// Without decltype the macro can not be used in a template where the class
+// of the method depends on a template parameter, spell out
+// makeMethodBinder(&method).template bind<&method>(instance) there.
+#ifdef Q_COMPILER_DECLTYPE
+#define BindToEvent(inClassMethod, inClassInstance) \
+    framework::MethodBinding<decltype(&inClassMethod), &inClassMethod>::bind(inClassInstance)
+#else
 #define BindToEvent(inClassMethod, inClassInstance) \
-    boost::bind(&inClassMethod, inClassInstance, _1)
+    framework::makeMethodBinder(&inClassMethod).bind<&inClassMethod>(inClassInstance)
+#endif
 
 #endif
 
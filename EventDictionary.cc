@@ -0,0 +1,639 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "EventDictionary.h"
+
+// Qt
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThreadStorage>
+
+// System
+#include <cstring>
+
+
+// Namespaces
+using namespace framework;
+
+
+namespace {
+
+//=============================================================================
+// struct Latin1Key
+//
+/// The text of a key passed as a C string, so the atom cache can find it
+/// without converting it to a QString first.
+//=============================================================================
+struct Latin1Key
+{
+    Latin1Key(const char* inText) : text(inText), length(qstrlen(inText)) {}
+
+    bool operator ==(const Latin1Key& other) const
+    {
+        return length == other.length && memcmp(text, other.text, length) == 0;
+    }
+
+    const char* text;
+    uint length;
+};
+
+inline uint
+qHash(const Latin1Key& inKey)
+{
+    uint result = 0;
+    for (uint index = 0; index < inKey.length; ++index) {
+        result = result * 31 + uchar(inKey.text[index]);
+    }
+    return result;
+}
+
+
+//=============================================================================
+// struct AtomCache
+//
+/// The atoms a thread has used, by their text. Only the owning thread
+/// touches it.
+//=============================================================================
+struct AtomCache
+{
+    ~AtomCache()
+    {
+        Q_FOREACH(const Latin1Key& key, literals.keys()) {
+            delete [] key.text;
+        }
+    }
+
+    QHash<QString, const QString*> strings;
+    QHash<Latin1Key, const QString*> literals;  // Owns the text of its keys
+};
+
+
+//=============================================================================
+// struct AtomTable
+//
+/// The atoms of every thread. Atoms live as long as the process, see
+/// EventKey about the growth of the table.
+//=============================================================================
+struct AtomTable
+{
+    QMutex mutex;
+    QHash<QString, const QString*> atoms;
+};
+
+
+//-----------------------------------------------------------------------------
+// atomTable()
+//
+/// Return the shared atom table. Function statics, so static EventKey
+/// constants of other translation units find the table constructed.
+//-----------------------------------------------------------------------------
+AtomTable&
+atomTable()
+{
+    static AtomTable sTable;
+    return sTable;
+}
+
+
+//-----------------------------------------------------------------------------
+// atomCache()
+//
+/// Return the atom cache of the current thread, creating it on first use.
+//-----------------------------------------------------------------------------
+AtomCache*
+atomCache()
+{
+    static QThreadStorage<AtomCache*> sAtomCaches;
+
+    AtomCache* cache = sAtomCaches.localData();
+    if (cache == NULL) {
+        cache = new AtomCache();
+        sAtomCaches.setLocalData(cache);
+    }
+    return cache;
+}
+
+
+//-----------------------------------------------------------------------------
+// sharedAtom()
+//
+/// Look up the atom of a key in the shared table.
+/// \param inKey The key text.
+/// \param inCreate True to intern the text if it has no atom yet.
+/// \result The atom, or NULL if there is none and inCreate is false.
+//-----------------------------------------------------------------------------
+const QString*
+sharedAtom(const QString& inKey, bool inCreate)
+{
+    AtomTable& table = atomTable();
+    QMutexLocker locker(&table.mutex);
+    if (!inCreate)
+        return table.atoms.value(inKey, NULL);
+
+    const QString*& atom = table.atoms[inKey];
+    if (atom == NULL) {
+        atom = new QString(inKey);
+    }
+    return atom;
+}
+
+
+//-----------------------------------------------------------------------------
+// cachedAtom()
+//
+/// Look up the atom of a C string key, in the cache of the thread first.
+/// \param inKey The key text.
+/// \param inCreate True to intern the text if it has no atom yet.
+/// \result The atom, or NULL if there is none and inCreate is false.
+//-----------------------------------------------------------------------------
+const QString*
+cachedAtom(const char* inKey, bool inCreate)
+{
+    AtomCache* cache = atomCache();
+    const QString* atom = cache->literals.value(Latin1Key(inKey), NULL);
+    if (atom == NULL) {
+        atom = sharedAtom(QString::fromLatin1(inKey), inCreate);
+        if (atom != NULL) {
+            cache->literals.insert(Latin1Key(qstrdup(inKey)), atom);
+        }
+    }
+    return atom;
+}
+
+
+//-----------------------------------------------------------------------------
+// cachedAtom()
+//
+/// Look up the atom of a key, in the cache of the thread first.
+/// \param inKey The key text.
+/// \param inCreate True to intern the text if it has no atom yet.
+/// \result The atom, or NULL if there is none and inCreate is false.
+//-----------------------------------------------------------------------------
+const QString*
+cachedAtom(const QString& inKey, bool inCreate)
+{
+    AtomCache* cache = atomCache();
+    const QString* atom = cache->strings.value(inKey, NULL);
+    if (atom == NULL) {
+        atom = sharedAtom(inKey, inCreate);
+        if (atom != NULL) {
+            cache->strings.insert(*atom, atom);
+        }
+    }
+    return atom;
+}
+
+} // namespace
+
+
+//=============================================================================
+// class EventKey
+//
+/// An interned dictionary key.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// EventKey::intern()
+//
+/// Return the atom shared by every key with the text of inKey. Events
+/// are built on any thread. Only the first use of a key on a thread
+/// locks the shared atom table.
+/// \param inKey The key text.
+/// \result The atom of the key.
+//-----------------------------------------------------------------------------
+const QString*
+EventKey::intern(const char* inKey)
+{
+    return cachedAtom(inKey, true);
+}
+
+
+//-----------------------------------------------------------------------------
+// EventKey::intern()
+//
+/// Return the atom shared by every key with the text of inKey.
+/// \param inKey The key text.
+/// \result The atom of the key.
+//-----------------------------------------------------------------------------
+const QString*
+EventKey::intern(const QString& inKey)
+{
+    return cachedAtom(inKey, true);
+}
+
+
+//-----------------------------------------------------------------------------
+// EventKey::find()
+//
+/// Return the atom of a key without interning it. Text without an atom
+/// is looked up in the shared table each time, as it is not cached.
+/// \param inKey The key text.
+/// \result The atom of the key, or NULL if no key has this text.
+//-----------------------------------------------------------------------------
+const QString*
+EventKey::find(const char* inKey)
+{
+    return cachedAtom(inKey, false);
+}
+
+
+//-----------------------------------------------------------------------------
+// EventKey::find()
+//
+/// Return the atom of a key without interning it.
+/// \param inKey The key text.
+/// \result The atom of the key, or NULL if no key has this text.
+//-----------------------------------------------------------------------------
+const QString*
+EventKey::find(const QString& inKey)
+{
+    return cachedAtom(inKey, false);
+}
+
+
+//-----------------------------------------------------------------------------
+// EventKey::toString()
+//
+/// Return the text of the key.
+//-----------------------------------------------------------------------------
+const QString&
+EventKey::toString() const
+{
+    static const QString sEmpty;
+    return mAtom != NULL ? *mAtom : sEmpty;
+}
+
+
+//-----------------------------------------------------------------------------
+// EventKey::atomCount()
+//
+/// Return the number of atoms, one for each distinct key text ever made
+/// into an EventKey. It only grows.
+//-----------------------------------------------------------------------------
+int
+EventKey::atomCount()
+{
+    AtomTable& table = atomTable();
+    QMutexLocker locker(&table.mutex);
+    return table.atoms.size();
+}
+
+
+//=============================================================================
+// class EventDictionary
+//
+/// The payload of an Event.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// EventDictionary::EventDictionary()
+//
+/// Constructor from a hash, for code that still builds its payload as a
+/// QHash<QString, QVariant>.
+/// \param inHash The entries to copy.
+//-----------------------------------------------------------------------------
+EventDictionary::EventDictionary(const QHash<QString, QVariant>& inHash)
+    :   mData(new Data())
+{
+    QHash<QString, QVariant>::const_iterator iter = inHash.constBegin();
+    for ( ; iter != inHash.constEnd(); ++iter) {
+        append(iter.key(), iter.value());
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::sharedEmpty()
+//
+/// Return the entries of empty dictionaries, so constructing one does
+/// not allocate. The table keeps a reference of its own, the first change
+/// to a dictionary copies it.
+//-----------------------------------------------------------------------------
+EventDictionary::Data*
+EventDictionary::sharedEmpty()
+{
+    static const QSharedDataPointer<Data> sEmpty(new Data());
+    return const_cast<Data*>(sEmpty.constData());
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::insert()
+//
+/// Set the value of a key, adding the key if it is not present.
+/// \param inKey The key.
+/// \param inValue The value.
+//-----------------------------------------------------------------------------
+void
+EventDictionary::insert(const EventKey& inKey, const QVariant& inValue)
+{
+    const int index = indexOf(inKey);
+    if (index < 0) {
+        append(inKey, inValue);
+    } else {
+        mData->mEntries[index].value = inValue;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::remove()
+//
+/// Remove a key. The remaining entries keep their order.
+/// \param inKey The key to remove.
+/// \result The number of entries removed, 0 or 1.
+//-----------------------------------------------------------------------------
+int
+EventDictionary::remove(const EventKeyLookup& inKey)
+{
+    const int index = indexOf(inKey);
+    if (index < 0)
+        return 0;
+
+    Data* data = mData.data();
+    for (int next = index + 1; next < data->mEntries.size(); ++next) {
+        data->mEntries[next - 1] = data->mEntries[next];
+    }
+    data->mEntries.resize(data->mEntries.size() - 1);
+
+    if (!data->mIndex.isEmpty()) {
+        rebuildIndex();
+    }
+    return 1;
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::clear()
+//
+/// Remove all entries. The entries are released, not copied, if other
+/// dictionaries share them.
+//-----------------------------------------------------------------------------
+void
+EventDictionary::clear()
+{
+    mData = sharedEmpty();
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::keys()
+//
+/// Return the keys in insertion order.
+//-----------------------------------------------------------------------------
+QList<QString>
+EventDictionary::keys() const
+{
+    QList<QString> result;
+    result.reserve(mData->mEntries.size());
+    for (int index = 0; index < mData->mEntries.size(); ++index) {
+        result.push_back(mData->mEntries[index].key.toString());
+    }
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::toHash()
+//
+/// Return the entries as a QHash<QString, QVariant>.
+//-----------------------------------------------------------------------------
+QHash<QString, QVariant>
+EventDictionary::toHash() const
+{
+    QHash<QString, QVariant> result;
+    result.reserve(mData->mEntries.size());
+    for (int index = 0; index < mData->mEntries.size(); ++index) {
+        result.insert(mData->mEntries[index].key.toString(), mData->mEntries[index].value);
+    }
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::operator ==()
+//
+/// Compare the entries of two dictionaries. The order in which the keys
+/// were added does not matter.
+/// \param other The dictionary to compare with.
+/// \result True if both hold the same keys with equal values.
+//-----------------------------------------------------------------------------
+bool
+EventDictionary::operator ==(const EventDictionary& other) const
+{
+    if (mData->mEntries.size() != other.mData->mEntries.size())
+        return false;
+
+    for (int index = 0; index < mData->mEntries.size(); ++index) {
+        const int otherIndex = other.indexOf(mData->mEntries[index].key);
+        if (otherIndex < 0 || !(other.mData->mEntries[otherIndex].value == mData->mEntries[index].value))
+            return false;
+    }
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::changesFrom()
+//
+/// Return the entries that differ from a previous version of the
+/// dictionary: new keys and changed values in the order of this
+/// dictionary, then the keys that were removed, set to an invalid
+/// QVariant.
+/// \param inPrevious The previous version.
+/// \result The changes, empty if both dictionaries are equal.
+//-----------------------------------------------------------------------------
+EventDictionary
+EventDictionary::changesFrom(const EventDictionary& inPrevious) const
+{
+    EventDictionary result;
+    for (int index = 0; index < mData->mEntries.size(); ++index) {
+        const Entry& entry = mData->mEntries[index];
+        const int previousIndex = inPrevious.indexOf(entry.key);
+        if (previousIndex < 0 || !(inPrevious.mData->mEntries[previousIndex].value == entry.value)) {
+            result.append(entry.key, entry.value);
+        }
+    }
+
+    for (int index = 0; index < inPrevious.mData->mEntries.size(); ++index) {
+        const Entry& entry = inPrevious.mData->mEntries[index];
+        if (indexOf(entry.key) < 0) {
+            result.append(entry.key, QVariant());
+        }
+    }
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::applyChanges()
+//
+/// Update the dictionary with the result of changesFrom(). Keys set to
+/// an invalid QVariant are removed.
+/// \param inChanges The changes.
+//-----------------------------------------------------------------------------
+void
+EventDictionary::applyChanges(const EventDictionary& inChanges)
+{
+    for (int index = 0; index < inChanges.mData->mEntries.size(); ++index) {
+        const Entry& entry = inChanges.mData->mEntries[index];
+        if (entry.value.isValid()) {
+            insert(entry.key, entry.value);
+        } else {
+            remove(entry.key);
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// variantHash()
+//
+/// Hash a value for contentHash(). Values of types without a hash only
+/// contribute their type, which is enough as equal hashes are compared
+/// with operator ==() before they are trusted.
+//-----------------------------------------------------------------------------
+static uint
+variantHash(const QVariant& inValue)
+{
+    const uint typeHash = uint(inValue.userType()) * 2654435761u;
+
+    switch (inValue.type()) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        return typeHash ^ qHash(inValue.toULongLong());
+
+    case QVariant::Double: {
+        const double value = inValue.toDouble();
+        quint64 bits = 0;
+        memcpy(&bits, &value, sizeof(bits));
+        return typeHash ^ qHash(bits);
+    }
+
+    case QVariant::String:
+        return typeHash ^ qHash(inValue.toString());
+
+    case QVariant::ByteArray:
+        return typeHash ^ qHash(inValue.toByteArray());
+
+    case QVariant::StringList: {
+        uint result = typeHash;
+        Q_FOREACH(const QString& value, inValue.toStringList()) {
+            result = result * 31 + qHash(value);
+        }
+        return result;
+    }
+
+    case QVariant::List: {
+        uint result = typeHash;
+        Q_FOREACH(const QVariant& value, inValue.toList()) {
+            result = result * 31 + variantHash(value);
+        }
+        return result;
+    }
+
+    case QVariant::Map: {
+        // Maps are sorted, so their entries hash in a stable order.
+        uint result = typeHash;
+        const QVariantMap map = inValue.toMap();
+        for (QVariantMap::const_iterator iter = map.constBegin(); iter != map.constEnd(); ++iter) {
+            result = result * 31 + (qHash(iter.key()) ^ variantHash(iter.value()));
+        }
+        return result;
+    }
+
+    default:
+        return typeHash;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::contentHash()
+//
+/// Hash the entries, consistent with operator ==(): the entries are
+/// combined regardless of their order. Values of different types that
+/// compare equal, 1 and 1.0 for example, may hash differently.
+/// \result The hash of the keys and values.
+//-----------------------------------------------------------------------------
+uint
+EventDictionary::contentHash() const
+{
+    uint result = uint(mData->mEntries.size());
+    for (int index = 0; index < mData->mEntries.size(); ++index) {
+        const Entry& entry = mData->mEntries[index];
+        result += qHash(entry.key.mAtom) ^ variantHash(entry.value);
+    }
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::append()
+//
+/// Add an entry for a key that is not present.
+/// \param inKey The key.
+/// \param inValue The value.
+/// \result The index of the new entry.
+//-----------------------------------------------------------------------------
+int
+EventDictionary::append(const EventKey& inKey, const QVariant& inValue)
+{
+    Data* data = mData.data();
+    data->mEntries.append(Entry(inKey, inValue));
+
+    const int index = data->mEntries.size() - 1;
+    if (!data->mIndex.isEmpty()) {
+        data->mIndex.insert(inKey.mAtom, index);
+    } else if (data->mEntries.size() > kIndexThreshold) {
+        rebuildIndex();
+    }
+    return index;
+}
+
+
+//-----------------------------------------------------------------------------
+// EventDictionary::rebuildIndex()
+//
+/// Index the entries if there are too many to scan, or drop the index if
+/// there are few enough again.
+//-----------------------------------------------------------------------------
+void
+EventDictionary::rebuildIndex()
+{
+    Data* data = mData.data();
+    data->mIndex.clear();
+    if (data->mEntries.size() <= kIndexThreshold)
+        return;
+
+    data->mIndex.reserve(data->mEntries.size());
+    for (int index = 0; index < data->mEntries.size(); ++index) {
+        data->mIndex.insert(data->mEntries[index].key.mAtom, index);
+    }
+}
@@ -0,0 +1,285 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef AF_NC_EVENT_DICTIONARY_HAS_BEEN_INCLUDED
+#define AF_NC_EVENT_DICTIONARY_HAS_BEEN_INCLUDED
+
+// Qt
+#include <QHash>
+#include <QList>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QString>
+#include <QVariant>
+#include <QVarLengthArray>
+
+
+namespace framework {
+
+//=============================================================================
+// class EventKey
+//
+// An interned dictionary key. Keys with the same text share one atom, so
+// comparing two keys compares two pointers. Each thread caches the atoms
+// it used, so interning a known key hashes the text but takes no lock.
+// Keys used on every event are still best kept in static EventKey
+// constants.
+//
+// Atoms are never released, as any key or dictionary may still point at
+// one, so the atom table grows with the number of distinct key texts ever
+// made into keys. That is a small fixed set for keys written in code.
+// Keys built from data, such as user input or the keys of a received
+// message, grow it without bound: look those up with EventKeyLookup,
+// which never interns, and keep them as values rather than keys.
+// atomCount() tells how many atoms there are.
+//=============================================================================
+class EventKey
+{
+public:
+    EventKey();
+    EventKey(const char* inKey);
+    EventKey(const QString& inKey);
+
+    bool operator ==(const EventKey& other) const;
+    bool operator !=(const EventKey& other) const;
+    const QString& toString() const;
+
+    static int atomCount();
+
+private:
+    friend class EventDictionary;
+    friend class EventKeyLookup;
+    static const QString* intern(const char* inKey);
+    static const QString* intern(const QString& inKey);
+    static const QString* find(const char* inKey);
+    static const QString* find(const QString& inKey);
+
+    const QString* mAtom;                       // NULL for the default constructed key
+};
+
+
+//=============================================================================
+// class EventKeyLookup
+//
+// A key to look up. It finds the atom of its text but never interns it,
+// so probing a dictionary with keys taken from data does not grow the
+// atom table. Text no key was made from has no atom and is in no
+// dictionary.
+//=============================================================================
+class EventKeyLookup
+{
+public:
+    EventKeyLookup(const EventKey& inKey);
+    EventKeyLookup(const char* inKey);
+    EventKeyLookup(const QString& inKey);
+
+private:
+    friend class EventDictionary;
+
+    const QString* mAtom;                       // NULL if the text was never interned
+};
+
+//=============================================================================
+// class inlines
+//=============================================================================
+inline EventKey::EventKey() : mAtom(NULL) {}
+inline EventKey::EventKey(const char* inKey) : mAtom(intern(inKey)) {}
+inline EventKey::EventKey(const QString& inKey) : mAtom(intern(inKey)) {}
+inline bool EventKey::operator ==(const EventKey& other) const { return mAtom == other.mAtom; }
+inline bool EventKey::operator !=(const EventKey& other) const { return mAtom != other.mAtom; }
+
+inline EventKeyLookup::EventKeyLookup(const EventKey& inKey) : mAtom(inKey.mAtom) {}
+inline EventKeyLookup::EventKeyLookup(const char* inKey) : mAtom(EventKey::find(inKey)) {}
+inline EventKeyLookup::EventKeyLookup(const QString& inKey) : mAtom(EventKey::find(inKey)) {}
+
+
+//=============================================================================
+// class EventDictionary
+//
+// The payload of an Event. Entries are kept in insertion order in a
+// small inline array and found by comparing key atoms. Past
+// kIndexThreshold entries an index is built so lookups stay constant
+// time. The interface follows the QHash<QString, QVariant> the dictionary
+// used to be. Only the functions that may add a key intern it, the
+// others look keys up with an EventKeyLookup.
+//
+// The entries are implicitly shared like those of QHash: copying a
+// dictionary, as copying an Event does, only takes a reference, and the
+// entries are copied the first time either copy is changed. As with Qt
+// containers, a reference returned by operator[] is only valid until the
+// next entry is added or the dictionary is copied.
+//=============================================================================
+class EventDictionary
+{
+public:
+    class const_iterator;
+    friend class const_iterator;
+
+    EventDictionary();
+    EventDictionary(const QHash<QString, QVariant>& inHash);
+
+    QVariant& operator[](const EventKey& inKey);
+    const QVariant operator[](const EventKeyLookup& inKey) const;
+    void insert(const EventKey& inKey, const QVariant& inValue);
+    QVariant value(const EventKeyLookup& inKey, const QVariant& inDefault = QVariant()) const;
+    bool contains(const EventKeyLookup& inKey) const;
+    int remove(const EventKeyLookup& inKey);
+    void clear();
+
+    int size() const;
+    int count() const;
+    bool isEmpty() const;
+
+    QList<QString> keys() const;
+    QHash<QString, QVariant> toHash() const;
+
+    // Entries compare regardless of their order.
+    bool operator ==(const EventDictionary& other) const;
+    bool operator !=(const EventDictionary& other) const;
+    uint contentHash() const;
+
+    // Key level changes, removed keys are set to an invalid QVariant.
+    EventDictionary changesFrom(const EventDictionary& inPrevious) const;
+    void applyChanges(const EventDictionary& inChanges);
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator constBegin() const;
+    const_iterator constEnd() const;
+
+private:
+    enum {
+        kInlineEntries = 6,                     // Most events carry a handful of keys
+        kIndexThreshold = 16                    // Past this a linear scan loses to the index
+    };
+
+    struct Entry
+    {
+        Entry() {}
+        Entry(const EventKey& inKey, const QVariant& inValue) : key(inKey), value(inValue) {}
+
+        EventKey key;
+        QVariant value;
+    };
+
+    struct Data : public QSharedData
+    {
+        QVarLengthArray<Entry, kInlineEntries> mEntries;
+        QHash<const QString*, int> mIndex;      // Entry of each atom, empty until the threshold is passed
+    };
+
+    static Data* sharedEmpty();
+
+    int indexOf(const EventKeyLookup& inKey) const;
+    int append(const EventKey& inKey, const QVariant& inValue);
+    void rebuildIndex();
+
+    QSharedDataPointer<Data> mData;             // Shared by the copies until one of them changes
+};
+
+
+//=============================================================================
+// class EventDictionary::const_iterator
+//
+// Walks the entries in insertion order. Provides the key() and value()
+// of QHash::const_iterator.
+//=============================================================================
+class EventDictionary::const_iterator
+{
+public:
+    const_iterator() : mDictionary(NULL), mIndex(0) {}
+    const_iterator(const EventDictionary* inDictionary, int inIndex) : mDictionary(inDictionary), mIndex(inIndex) {}
+
+    const QString& key() const { return mDictionary->mData->mEntries[mIndex].key.toString(); }
+    const QVariant& value() const { return mDictionary->mData->mEntries[mIndex].value; }
+    const QVariant& operator*() const { return value(); }
+
+    const_iterator& operator++() { ++mIndex; return *this; }
+    const_iterator operator++(int) { const_iterator previous(*this); ++mIndex; return previous; }
+    bool operator ==(const const_iterator& other) const { return mIndex == other.mIndex && mDictionary == other.mDictionary; }
+    bool operator !=(const const_iterator& other) const { return !(*this == other); }
+
+private:
+    const EventDictionary* mDictionary;
+    int mIndex;
+};
+
+//=============================================================================
+// class inlines
+//=============================================================================
+inline EventDictionary::EventDictionary() : mData(sharedEmpty()) {}
+inline bool EventDictionary::contains(const EventKeyLookup& inKey) const { return indexOf(inKey) >= 0; }
+inline int EventDictionary::size() const { return mData->mEntries.size(); }
+inline int EventDictionary::count() const { return mData->mEntries.size(); }
+inline bool EventDictionary::isEmpty() const { return mData->mEntries.size() == 0; }
+inline bool EventDictionary::operator !=(const EventDictionary& other) const { return !(*this == other); }
+inline EventDictionary::const_iterator EventDictionary::begin() const { return const_iterator(this, 0); }
+inline EventDictionary::const_iterator EventDictionary::end() const { return const_iterator(this, mData->mEntries.size()); }
+inline EventDictionary::const_iterator EventDictionary::constBegin() const { return begin(); }
+inline EventDictionary::const_iterator EventDictionary::constEnd() const { return end(); }
+
+inline int
+EventDictionary::indexOf(const EventKeyLookup& inKey) const
+{
+    if (inKey.mAtom == NULL)
+        return -1;
+
+    const Data* data = mData.constData();
+    if (!data->mIndex.isEmpty())
+        return data->mIndex.value(inKey.mAtom, -1);
+
+    const Entry* entries = data->mEntries.constData();
+    for (int index = 0; index < data->mEntries.size(); ++index) {
+        if (entries[index].key.mAtom == inKey.mAtom)
+            return index;
+    }
+    return -1;
+}
+
+inline QVariant
+EventDictionary::value(const EventKeyLookup& inKey, const QVariant& inDefault) const
+{
+    const int index = indexOf(inKey);
+    return index < 0 ? inDefault : mData->mEntries[index].value;
+}
+
+inline const QVariant
+EventDictionary::operator[](const EventKeyLookup& inKey) const
+{
+    return value(inKey);
+}
+
+inline QVariant&
+EventDictionary::operator[](const EventKey& inKey)
+{
+    int index = indexOf(inKey);
+    if (index < 0) {
+        index = append(inKey, QVariant());
+    }
+    return mData->mEntries[index].value;
+}
+
+} // namespace framework
+
+#endif // AF_NC_EVENT_DICTIONARY_HAS_BEEN_INCLUDED
@@ -0,0 +1,912 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef AF_NC_EVENT_SIGNAL_HAS_BEEN_INCLUDED
+#define AF_NC_EVENT_SIGNAL_HAS_BEEN_INCLUDED
+
+// Qt
+#include <QtGlobal>
+
+// Boost
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/type_traits/is_function.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_pointer.hpp>
+#include <boost/type_traits/remove_pointer.hpp>
+#include <boost/utility/enable_if.hpp>
+
+// System
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+#ifdef Q_COMPILER_RVALUE_REFS
+#include <utility>
+#endif
+
+
+// Hint the cache about memory that is about to be read.
+#if defined(__GNUC__)
+#define NC_PREFETCH(inAddress) __builtin_prefetch(inAddress)
+#else
+#define NC_PREFETCH(inAddress) ((void)(inAddress))
+#endif
+
+
+namespace framework {
+
+template <typename Arg> class Delegate;
+
+//=============================================================================
+// struct DelegateAccepts
+//
+// Whether a Delegate<Arg> can be made from a Functor. Integers, enums and
+// object pointers are never callable, and plain functions and other delegates
+// must take an argument that Arg converts to. This keeps overloads taking
+// a delegate from competing for arguments they can not use.
+//=============================================================================
+template <typename Functor, typename Arg>
+struct DelegateAccepts
+{
+    static const bool value = !boost::is_integral<Functor>::value
+                           && !boost::is_enum<Functor>::value
+                           && !(boost::is_pointer<Functor>::value
+                                && !boost::is_function<typename boost::remove_pointer<Functor>::type>::value);
+};
+
+template <typename Result, typename Param, typename Arg>
+struct DelegateAccepts<Result (*)(Param), Arg>
+{
+    static const bool value = boost::is_convertible<Arg, Param>::value;
+};
+
+template <typename Param, typename Arg>
+struct DelegateAccepts<Delegate<Param>, Arg>
+{
+    static const bool value = boost::is_convertible<Arg, Param>::value;
+};
+
+
+//=============================================================================
+// class Delegate
+//
+// A callable taking one argument. Functors that fit in a few pointers,
+// which covers bound member functions and plain functions, are stored
+// in place. Larger functors are copied to the heap. Moving or swapping
+// delegates never copies a heap functor.
+//=============================================================================
+template <typename Arg>
+class Delegate
+{
+public:
+    Delegate();
+
+    template <typename Functor>
+    Delegate(Functor inFunctor,
+             typename boost::enable_if_c<DelegateAccepts<Functor, Arg>::value, int>::type = 0);
+
+    Delegate(const Delegate& inOther);
+    ~Delegate();
+
+    Delegate& operator=(const Delegate& inOther);
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    Delegate(Delegate&& ioOther);
+    Delegate& operator=(Delegate&& ioOther);
+#endif
+
+    void swap(Delegate& ioOther);
+
+    /// A delegate calling inMethod on inObject. Only the object pointer
+    /// is stored, the method is part of the type. The result of the
+    /// method, if any, is discarded.
+    template <class T, void (T::*Method)(Arg)>
+    static Delegate fromMethod(T* inObject);
+
+    template <class T, void (T::*Method)(Arg) const>
+    static Delegate fromConstMethod(const T* inObject);
+
+    template <class T, typename Result, Result (T::*Method)(Arg)>
+    static Delegate fromResultMethod(T* inObject);
+
+    template <class T, typename Result, Result (T::*Method)(Arg) const>
+    static Delegate fromConstResultMethod(const T* inObject);
+
+    void operator()(Arg inArg) const;
+    void prefetch() const;
+
+    bool empty() const;
+    void clear();
+
+private:
+    enum { kInlineSize = 4 * sizeof(void*) };
+
+    union Storage
+    {
+        void* object;
+        const void* constObject;
+        char inlineData[kInlineSize];
+        double alignDouble;
+        long long alignLong;
+        void (*alignFunction)();
+    };
+
+    enum ManageOperation
+    {
+        kCopyFunctor,                           // Copy the source into the storage
+        kMoveFunctor,                           // Move the source into the storage, leaving the source destroyed
+        kDestroyFunctor                         // Destroy the storage, the source is NULL
+    };
+
+    typedef void (*Invoker)(const Storage& inStorage, Arg inArg);
+    typedef void (*Manager)(Storage& ioStorage, Storage* ioSource, ManageOperation inOperation);
+
+    template <typename Functor>
+    struct FitsInline
+    {
+        static const bool value = sizeof(Functor) <= kInlineSize
+                               && boost::alignment_of<Functor>::value <= boost::alignment_of<Storage>::value;
+    };
+
+    template <typename Functor>
+    struct InlineFunctor
+    {
+        static void invoke(const Storage& inStorage, Arg inArg)
+        {
+            Functor* functor = const_cast<Functor*>(reinterpret_cast<const Functor*>(inStorage.inlineData));
+            (*functor)(inArg);
+        }
+
+        static void manage(Storage& ioStorage, Storage* ioSource, ManageOperation inOperation)
+        {
+            switch (inOperation) {
+            case kCopyFunctor:
+                new (ioStorage.inlineData) Functor(*reinterpret_cast<const Functor*>(ioSource->inlineData));
+                break;
+
+            case kMoveFunctor: {
+                Functor* source = reinterpret_cast<Functor*>(ioSource->inlineData);
+#ifdef Q_COMPILER_RVALUE_REFS
+                new (ioStorage.inlineData) Functor(std::move(*source));
+#else
+                new (ioStorage.inlineData) Functor(*source);
+#endif
+                source->~Functor();
+            }
+            break;
+
+            case kDestroyFunctor:
+                reinterpret_cast<Functor*>(ioStorage.inlineData)->~Functor();
+                break;
+            }
+        }
+    };
+
+    template <typename Functor>
+    struct HeapFunctor
+    {
+        static void invoke(const Storage& inStorage, Arg inArg)
+        {
+            (*static_cast<Functor*>(inStorage.object))(inArg);
+        }
+
+        static void manage(Storage& ioStorage, Storage* ioSource, ManageOperation inOperation)
+        {
+            switch (inOperation) {
+            case kCopyFunctor:
+                ioStorage.object = new Functor(*static_cast<const Functor*>(ioSource->object));
+                break;
+
+            case kMoveFunctor:
+                ioStorage.object = ioSource->object;
+                ioSource->object = NULL;
+                break;
+
+            case kDestroyFunctor:
+                delete static_cast<Functor*>(ioStorage.object);
+                break;
+            }
+        }
+    };
+
+    template <class T, typename Result, Result (T::*Method)(Arg)>
+    static void invokeMethod(const Storage& inStorage, Arg inArg)
+    {
+        (static_cast<T*>(inStorage.object)->*Method)(inArg);
+    }
+
+    template <class T, typename Result, Result (T::*Method)(Arg) const>
+    static void invokeConstMethod(const Storage& inStorage, Arg inArg)
+    {
+        (static_cast<const T*>(inStorage.constObject)->*Method)(inArg);
+    }
+
+    template <typename Functor>
+    void assign(const Functor& inFunctor, boost::true_type /*inline*/);
+
+    template <typename Functor>
+    void assign(const Functor& inFunctor, boost::false_type /*inline*/);
+
+    void copyFrom(const Delegate& inOther);
+    void moveFrom(Delegate& ioOther);
+
+    Invoker mInvoke;
+    Manager mManage;                            // NULL when the storage is a plain pointer
+    Storage mStorage;
+};
+
+
+//=============================================================================
+// struct MethodBinding
+//
+// Binds a member function known at compile time to an object. A plain
+// object pointer is all the delegate stores. Smart pointers, and anything
+// else that dereferences to the object, are stored by value and keep
+// the object alive with the delegate. The result of the method, if any,
+// is discarded.
+//
+//     MethodBinding<decltype(&Class::method), &Class::method>::bind(object)
+//=============================================================================
+template <typename MethodType, MethodType Method>
+struct MethodBinding;
+
+template <class T, typename Result, typename Arg, Result (T::*Method)(Arg)>
+struct MethodBinding<Result (T::*)(Arg), Method>
+{
+    template <typename Pointer>
+    struct Call
+    {
+        explicit Call(const Pointer& inObject) : mObject(inObject) {}
+        void operator()(Arg inArg) const { ((*mObject).*Method)(inArg); }
+
+        Pointer mObject;
+    };
+
+    static Delegate<Arg> bind(T* inObject)
+    {
+        return Delegate<Arg>::template fromResultMethod<T, Result, Method>(inObject);
+    }
+
+    template <typename Pointer>
+    static Delegate<Arg> bind(const Pointer& inObject,
+                              typename boost::disable_if<boost::is_convertible<Pointer, T*>, int>::type = 0)
+    {
+        return Delegate<Arg>(Call<Pointer>(inObject));
+    }
+};
+
+template <class T, typename Result, typename Arg, Result (T::*Method)(Arg) const>
+struct MethodBinding<Result (T::*)(Arg) const, Method>
+{
+    template <typename Pointer>
+    struct Call
+    {
+        explicit Call(const Pointer& inObject) : mObject(inObject) {}
+        void operator()(Arg inArg) const { ((*mObject).*Method)(inArg); }
+
+        Pointer mObject;
+    };
+
+    static Delegate<Arg> bind(const T* inObject)
+    {
+        return Delegate<Arg>::template fromConstResultMethod<T, Result, Method>(inObject);
+    }
+
+    template <typename Pointer>
+    static Delegate<Arg> bind(const Pointer& inObject,
+                              typename boost::disable_if<boost::is_convertible<Pointer, const T*>, int>::type = 0)
+    {
+        return Delegate<Arg>(Call<Pointer>(inObject));
+    }
+};
+
+
+//=============================================================================
+// class MethodBinder
+//
+// Helper that deduces the type of a member function for compilers without
+// decltype, so the function itself can be bound at compile time:
+//
+//     makeMethodBinder(&Class::method).bind<&Class::method>(object)
+//
+// In a template where the class depends on a template parameter the call
+// must be spelled .template bind<...>(). BindToEvent() wraps this, or
+// MethodBinding where decltype is available.
+//=============================================================================
+template <class T, typename Result, typename Arg>
+struct MethodBinder
+{
+    template <Result (T::*Method)(Arg), typename Pointer>
+    Delegate<Arg> bind(const Pointer& inObject) const
+    {
+        return MethodBinding<Result (T::*)(Arg), Method>::bind(inObject);
+    }
+};
+
+template <class T, typename Result, typename Arg>
+struct ConstMethodBinder
+{
+    template <Result (T::*Method)(Arg) const, typename Pointer>
+    Delegate<Arg> bind(const Pointer& inObject) const
+    {
+        return MethodBinding<Result (T::*)(Arg) const, Method>::bind(inObject);
+    }
+};
+
+template <class T, typename Result, typename Arg>
+inline MethodBinder<T, Result, Arg> makeMethodBinder(Result (T::*)(Arg)) { return MethodBinder<T, Result, Arg>(); }
+
+template <class T, typename Result, typename Arg>
+inline ConstMethodBinder<T, Result, Arg> makeMethodBinder(Result (T::*)(Arg) const) { return ConstMethodBinder<T, Result, Arg>(); }
+
+
+//=============================================================================
+// class Signal
+//
+// A list of delegates called in connection order. The slots are kept in
+// one contiguous vector. Slots connected while the signal is being
+// emitted are added after the emission. Disconnected slots are left in
+// place, skipped at once, and swept out after an emission or once they
+// are half of the slots, so disconnecting does not shift the vector.
+// The slots only ever move by swapping their delegates.
+//
+// Not thread safe. NotificationCenter only emits from its own thread,
+// except for partitioned emissions: the owner holds an Emission and
+// calls emitRange() for disjoint ranges of the slots from other threads.
+//
+// Each slot carries a tag chosen by the owner. The scoped emissions
+// construct a Scope(context, arg, tag) around every call, where the
+// context is the Scope::Context passed to the emission. This lets the
+// owner observe the calls without wrapping the delegates.
+//=============================================================================
+template <typename Arg>
+class Signal
+{
+public:
+    typedef Delegate<Arg> SlotType;
+    typedef unsigned int SlotId;
+
+    Signal();
+
+    SlotId connect(const SlotType& inSlot, unsigned int inTag = 0);
+    void disconnect(SlotId inId);
+    void disconnectAll();
+
+    bool empty() const;
+    int size() const;
+
+    void operator()(Arg inArg);
+
+    template <typename Scope>
+    void emitScoped(Arg inArg, const typename Scope::Context& inContext);
+
+    // Partitioned emission. The slots do not move while an Emission is
+    // alive, so slotCount() and the ranges passed to emitRange() stay valid.
+    class Emission
+    {
+    public:
+        explicit Emission(Signal& inSignal) : mSignal(inSignal) { ++mSignal.mEmitDepth; }
+        ~Emission() { if (--mSignal.mEmitDepth == 0) mSignal.flush(); }
+
+    private:
+        Emission(const Emission& theValue);
+        Emission& operator=(const Emission& theValue);
+
+        Signal& mSignal;
+    };
+    friend class Emission;
+
+    int slotCount() const;
+    void emitRange(Arg inArg, int inBegin, int inEnd) const;
+
+    template <typename Scope>
+    void emitRangeScoped(Arg inArg, const typename Scope::Context& inContext, int inBegin, int inEnd) const;
+
+private:
+    // No copying allowed
+    Signal(const Signal& theValue);
+    Signal& operator=(const Signal& theValue);
+
+    enum { kPrefetchDistance = 8 };             // Slots ahead whose target is pulled into the cache
+
+    struct Slot
+    {
+        Slot() : id(0), tag(0), connected(false) {}
+
+        void swap(Slot& ioOther)
+        {
+            std::swap(id, ioOther.id);
+            std::swap(tag, ioOther.tag);
+            std::swap(connected, ioOther.connected);
+            delegate.swap(ioOther.delegate);
+        }
+
+        SlotId id;
+        unsigned int tag;
+        bool connected;
+        SlotType delegate;
+    };
+
+    typedef std::vector<Slot> SlotList;
+
+    struct SlotIdLess
+    {
+        bool operator()(const Slot& inSlot, SlotId inId) const { return inSlot.id < inId; }
+    };
+
+    struct EmitScope
+    {
+        EmitScope(Signal* inSignal) : mSignal(inSignal) { ++mSignal->mEmitDepth; }
+        ~EmitScope() { if (--mSignal->mEmitDepth == 0) mSignal->flush(); }
+
+        Signal* mSignal;
+    };
+
+    static Slot* findSlot(SlotList& ioSlots, SlotId inId);
+    static void appendSlot(SlotList& ioSlots, Slot& ioSlot);
+    void compact();
+    void flush();
+
+    SlotList mSlots;                            // Ordered by id
+    SlotList mPendingSlots;                     // Connected during an emission
+    SlotId mNextId;
+    int mEmitDepth;
+    int mDisconnectedCount;                     // Disconnected slots still in mSlots or mPendingSlots
+};
+
+
+//-----------------------------------------------------------------------------
+// Delegate
+//-----------------------------------------------------------------------------
+template <typename Arg>
+inline Delegate<Arg>::Delegate()
+    :   mInvoke(NULL),
+        mManage(NULL)
+{
+    mStorage.object = NULL;
+}
+
+template <typename Arg>
+template <typename Functor>
+inline Delegate<Arg>::Delegate(Functor inFunctor,
+                               typename boost::enable_if_c<DelegateAccepts<Functor, Arg>::value, int>::type)
+    :   mInvoke(NULL),
+        mManage(NULL)
+{
+    assign(inFunctor, boost::integral_constant<bool, FitsInline<Functor>::value>());
+}
+
+template <typename Arg>
+inline Delegate<Arg>::Delegate(const Delegate& inOther)
+    :   mInvoke(NULL),
+        mManage(NULL)
+{
+    copyFrom(inOther);
+}
+
+template <typename Arg>
+inline Delegate<Arg>::~Delegate()
+{
+    clear();
+}
+
+template <typename Arg>
+inline Delegate<Arg>&
+Delegate<Arg>::operator=(const Delegate& inOther)
+{
+    if (this != &inOther) {
+        clear();
+        copyFrom(inOther);
+    }
+    return *this;
+}
+
+#ifdef Q_COMPILER_RVALUE_REFS
+template <typename Arg>
+inline Delegate<Arg>::Delegate(Delegate&& ioOther)
+    :   mInvoke(NULL),
+        mManage(NULL)
+{
+    moveFrom(ioOther);
+}
+
+template <typename Arg>
+inline Delegate<Arg>&
+Delegate<Arg>::operator=(Delegate&& ioOther)
+{
+    if (this != &ioOther) {
+        clear();
+        moveFrom(ioOther);
+    }
+    return *this;
+}
+#endif
+
+template <typename Arg>
+inline void
+Delegate<Arg>::swap(Delegate& ioOther)
+{
+    if (this == &ioOther)
+        return;
+
+    Delegate other;
+    other.moveFrom(ioOther);
+    ioOther.moveFrom(*this);
+    moveFrom(other);
+}
+
+template <typename Arg>
+inline void
+swap(Delegate<Arg>& ioLeft, Delegate<Arg>& ioRight)
+{
+    ioLeft.swap(ioRight);
+}
+
+template <typename Arg>
+template <class T, void (T::*Method)(Arg)>
+inline Delegate<Arg>
+Delegate<Arg>::fromMethod(T* inObject)
+{
+    return fromResultMethod<T, void, Method>(inObject);
+}
+
+template <typename Arg>
+template <class T, void (T::*Method)(Arg) const>
+inline Delegate<Arg>
+Delegate<Arg>::fromConstMethod(const T* inObject)
+{
+    return fromConstResultMethod<T, void, Method>(inObject);
+}
+
+template <typename Arg>
+template <class T, typename Result, Result (T::*Method)(Arg)>
+inline Delegate<Arg>
+Delegate<Arg>::fromResultMethod(T* inObject)
+{
+    Delegate result;
+    result.mInvoke = &Delegate::template invokeMethod<T, Result, Method>;
+    result.mStorage.object = inObject;
+    return result;
+}
+
+template <typename Arg>
+template <class T, typename Result, Result (T::*Method)(Arg) const>
+inline Delegate<Arg>
+Delegate<Arg>::fromConstResultMethod(const T* inObject)
+{
+    Delegate result;
+    result.mInvoke = &Delegate::template invokeConstMethod<T, Result, Method>;
+    result.mStorage.constObject = inObject;
+    return result;
+}
+
+template <typename Arg>
+inline void
+Delegate<Arg>::operator()(Arg inArg) const
+{
+    mInvoke(mStorage, inArg);
+}
+
+template <typename Arg>
+inline void
+Delegate<Arg>::prefetch() const
+{
+    // Bound member functions keep only the object pointer. Other
+    // functors live in the delegate itself.
+    if (mManage == NULL && mStorage.object != NULL) {
+        NC_PREFETCH(mStorage.object);
+    }
+}
+
+template <typename Arg>
+inline bool
+Delegate<Arg>::empty() const
+{
+    return mInvoke == NULL;
+}
+
+template <typename Arg>
+inline void
+Delegate<Arg>::clear()
+{
+    if (mManage != NULL) {
+        mManage(mStorage, NULL, kDestroyFunctor);
+    }
+    mInvoke = NULL;
+    mManage = NULL;
+    mStorage.object = NULL;
+}
+
+template <typename Arg>
+template <typename Functor>
+inline void
+Delegate<Arg>::assign(const Functor& inFunctor, boost::true_type)
+{
+    new (mStorage.inlineData) Functor(inFunctor);
+    mInvoke = &InlineFunctor<Functor>::invoke;
+    mManage = &InlineFunctor<Functor>::manage;
+}
+
+template <typename Arg>
+template <typename Functor>
+inline void
+Delegate<Arg>::assign(const Functor& inFunctor, boost::false_type)
+{
+    mStorage.object = new Functor(inFunctor);
+    mInvoke = &HeapFunctor<Functor>::invoke;
+    mManage = &HeapFunctor<Functor>::manage;
+}
+
+template <typename Arg>
+inline void
+Delegate<Arg>::copyFrom(const Delegate& inOther)
+{
+    // The delegate is empty.
+    mInvoke = inOther.mInvoke;
+    mManage = inOther.mManage;
+    if (mManage != NULL) {
+        mManage(mStorage, const_cast<Storage*>(&inOther.mStorage), kCopyFunctor);
+    } else {
+        mStorage = inOther.mStorage;
+    }
+}
+
+template <typename Arg>
+inline void
+Delegate<Arg>::moveFrom(Delegate& ioOther)
+{
+    // The delegate is empty. ioOther is left empty, its functor has been
+    // moved or destroyed by the manager.
+    mInvoke = ioOther.mInvoke;
+    mManage = ioOther.mManage;
+    if (mManage != NULL) {
+        mManage(mStorage, &ioOther.mStorage, kMoveFunctor);
+    } else {
+        mStorage = ioOther.mStorage;
+    }
+
+    ioOther.mInvoke = NULL;
+    ioOther.mManage = NULL;
+    ioOther.mStorage.object = NULL;
+}
+
+
+//-----------------------------------------------------------------------------
+// Signal
+//-----------------------------------------------------------------------------
+template <typename Arg>
+inline Signal<Arg>::Signal()
+    :   mNextId(0),
+        mEmitDepth(0),
+        mDisconnectedCount(0)
+{
+}
+
+template <typename Arg>
+typename Signal<Arg>::SlotId
+Signal<Arg>::connect(const SlotType& inSlot, unsigned int inTag)
+{
+    const SlotId id = mNextId++;
+
+    Slot slot;
+    slot.id = id;
+    slot.tag = inTag;
+    slot.connected = true;
+    slot.delegate = inSlot;
+
+    // Growing mSlots would move the delegate being called.
+    appendSlot(mEmitDepth > 0 ? mPendingSlots : mSlots, slot);
+
+    return id;
+}
+
+template <typename Arg>
+void
+Signal<Arg>::disconnect(SlotId inId)
+{
+    Slot* slot = findSlot(mSlots, inId);
+    if (slot == NULL) {
+        slot = findSlot(mPendingSlots, inId);
+    }
+    if (slot == NULL || !slot->connected)
+        return;
+
+    slot->connected = false;
+    ++mDisconnectedCount;
+
+    // Sweeping once half of the slots are disconnected keeps each
+    // disconnect amortized to the cost of the lookup.
+    if (mEmitDepth == 0 && mDisconnectedCount * 2 > slotCount()) {
+        compact();
+    }
+}
+
+template <typename Arg>
+void
+Signal<Arg>::disconnectAll()
+{
+    mPendingSlots.clear();
+
+    if (mEmitDepth == 0) {
+        mSlots.clear();
+        mDisconnectedCount = 0;
+        return;
+    }
+
+    for (typename SlotList::iterator iter = mSlots.begin(); iter != mSlots.end(); ++iter) {
+        iter->connected = false;
+    }
+    mDisconnectedCount = slotCount();
+}
+
+template <typename Arg>
+inline bool
+Signal<Arg>::empty() const
+{
+    return size() == 0;
+}
+
+template <typename Arg>
+inline int
+Signal<Arg>::size() const
+{
+    return static_cast<int>(mSlots.size() + mPendingSlots.size()) - mDisconnectedCount;
+}
+
+template <typename Arg>
+void
+Signal<Arg>::operator()(Arg inArg)
+{
+    EmitScope scope(this);
+
+    // Slots connected by the callbacks go to mPendingSlots, so the
+    // storage of mSlots does not move while we walk it.
+    emitRange(inArg, 0, slotCount());
+}
+
+template <typename Arg>
+template <typename Scope>
+void
+Signal<Arg>::emitScoped(Arg inArg, const typename Scope::Context& inContext)
+{
+    EmitScope scope(this);
+    emitRangeScoped<Scope>(inArg, inContext, 0, slotCount());
+}
+
+template <typename Arg>
+inline int
+Signal<Arg>::slotCount() const
+{
+    return static_cast<int>(mSlots.size());
+}
+
+template <typename Arg>
+void
+Signal<Arg>::emitRange(Arg inArg, int inBegin, int inEnd) const
+{
+    if (inBegin >= inEnd)
+        return;
+
+    // Walk the slots in order, fetching the objects of the slots a few
+    // steps ahead so large fan-outs are not bound by cache misses.
+    const Slot* slots = &mSlots[0];
+    const int prefetchEnd = inEnd - kPrefetchDistance;
+    for (int index = inBegin; index < inEnd; ++index) {
+        if (index < prefetchEnd) {
+            NC_PREFETCH(&slots[index + kPrefetchDistance]);
+            slots[index + kPrefetchDistance / 2].delegate.prefetch();
+        }
+        if (slots[index].connected) {
+            slots[index].delegate(inArg);
+        }
+    }
+}
+
+template <typename Arg>
+template <typename Scope>
+void
+Signal<Arg>::emitRangeScoped(Arg inArg, const typename Scope::Context& inContext, int inBegin, int inEnd) const
+{
+    // Observed emissions are not tuned, they skip the prefetching.
+    for (int index = inBegin; index < inEnd; ++index) {
+        const Slot& slot = mSlots[index];
+        if (slot.connected) {
+            Scope scope(inContext, inArg, slot.tag);
+            slot.delegate(inArg);
+        }
+    }
+}
+
+template <typename Arg>
+typename Signal<Arg>::Slot*
+Signal<Arg>::findSlot(SlotList& ioSlots, SlotId inId)
+{
+    typename SlotList::iterator iter = std::lower_bound(ioSlots.begin(), ioSlots.end(), inId, SlotIdLess());
+    if (iter == ioSlots.end() || iter->id != inId)
+        return NULL;
+
+    return &*iter;
+}
+
+template <typename Arg>
+void
+Signal<Arg>::appendSlot(SlotList& ioSlots, Slot& ioSlot)
+{
+    // Grow by hand so the delegates are swapped into the new storage
+    // rather than copied, which would copy their heap functors.
+    if (ioSlots.size() == ioSlots.capacity()) {
+        SlotList grown;
+        grown.reserve(std::max<std::size_t>(2 * ioSlots.size(), 4));
+        grown.resize(ioSlots.size());
+        for (std::size_t index = 0; index < ioSlots.size(); ++index) {
+            grown[index].swap(ioSlots[index]);
+        }
+        ioSlots.swap(grown);
+    }
+
+    ioSlots.push_back(Slot());
+    ioSlots.back().swap(ioSlot);
+}
+
+template <typename Arg>
+void
+Signal<Arg>::compact()
+{
+    typename SlotList::iterator write = mSlots.begin();
+    for (typename SlotList::iterator read = mSlots.begin(); read != mSlots.end(); ++read) {
+        if (read->connected) {
+            if (write != read) {
+                write->swap(*read);
+            }
+            ++write;
+        }
+    }
+    mSlots.erase(write, mSlots.end());
+    mDisconnectedCount = 0;
+}
+
+template <typename Arg>
+void
+Signal<Arg>::flush()
+{
+    // Also drops the count of the disconnected pending slots, which are
+    // not appended.
+    if (mDisconnectedCount > 0) {
+        compact();
+    }
+
+    for (typename SlotList::iterator iter = mPendingSlots.begin(); iter != mPendingSlots.end(); ++iter) {
+        if (iter->connected) {
+            appendSlot(mSlots, *iter);
+        }
+    }
+    mPendingSlots.clear();
+}
+
+} // namespace framework
+
+#endif // AF_NC_EVENT_SIGNAL_HAS_BEEN_INCLUDED
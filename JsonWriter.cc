@@ -0,0 +1,163 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "JsonWriter.h"
+
+// System
+#include <cmath>
+
+
+// Namespaces
+using namespace framework;
+
+
+//-----------------------------------------------------------------------------
+// writeString()
+//
+/// Append a quoted and escaped JSON string.
+//-----------------------------------------------------------------------------
+static void
+writeString(const QString& inString, QByteArray& ioJson)
+{
+    static const char kHexDigits[] = "0123456789abcdef";
+
+    const QByteArray utf8 = inString.toUtf8();
+    ioJson.reserve(ioJson.size() + utf8.size() + 2);
+    ioJson.append('"');
+    for (const char* iter = utf8.constData(); *iter != '\0'; ++iter) {
+        const unsigned char c = static_cast<unsigned char>(*iter);
+        switch (c) {
+            case '"':   ioJson.append("\\\"");   break;
+            case '\\':  ioJson.append("\\\\");   break;
+            case '\n':  ioJson.append("\\n");    break;
+            case '\r':  ioJson.append("\\r");    break;
+            case '\t':  ioJson.append("\\t");    break;
+            default:
+                if (c < 0x20) {
+                    ioJson.append("\\u00");
+                    ioJson.append(kHexDigits[c >> 4]);
+                    ioJson.append(kHexDigits[c & 0xf]);
+                } else {
+                    ioJson.append(static_cast<char>(c));
+                }
+                break;
+        }
+    }
+    ioJson.append('"');
+}
+
+
+//-----------------------------------------------------------------------------
+// writeValue()
+//
+/// Append a QVariant as JSON. Maps become objects, lists arrays, numbers
+/// and booleans keep their type and anything else is written as its
+/// string.
+//-----------------------------------------------------------------------------
+static void
+writeValue(const QVariant& inValue, QByteArray& ioJson)
+{
+    switch (inValue.type()) {
+        case QVariant::Invalid:
+            ioJson.append("null");
+            break;
+
+        case QVariant::Bool:
+            ioJson.append(inValue.toBool() ? "true" : "false");
+            break;
+
+        case QVariant::Int:
+        case QVariant::LongLong:
+            ioJson.append(QByteArray::number(inValue.toLongLong()));
+            break;
+
+        case QVariant::UInt:
+        case QVariant::ULongLong:
+            ioJson.append(QByteArray::number(inValue.toULongLong()));
+            break;
+
+        case QVariant::Double: {
+            // JSON has no infinity or NaN.
+            const double value = inValue.toDouble();
+            if (value != value || std::fabs(value) > 1.7976931348623157e308) {
+                ioJson.append("null");
+            } else {
+                ioJson.append(QByteArray::number(value, 'g', 15));
+            }
+        }
+        break;
+
+        case QVariant::Map: {
+            const QVariantMap map = inValue.toMap();
+            ioJson.append('{');
+            for (QVariantMap::const_iterator iter = map.constBegin(); iter != map.constEnd(); ++iter) {
+                if (iter != map.constBegin()) {
+                    ioJson.append(',');
+                }
+                writeString(iter.key(), ioJson);
+                ioJson.append(':');
+                writeValue(iter.value(), ioJson);
+            }
+            ioJson.append('}');
+        }
+        break;
+
+        case QVariant::List:
+        case QVariant::StringList: {
+            const QVariantList list = inValue.toList();
+            ioJson.append('[');
+            for (int index = 0; index < list.size(); ++index) {
+                if (index > 0) {
+                    ioJson.append(',');
+                }
+                writeValue(list.at(index), ioJson);
+            }
+            ioJson.append(']');
+        }
+        break;
+
+        default:
+            writeString(inValue.toString(), ioJson);
+            break;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// toJson()
+//
+/// Write a QVariant as compact JSON. Qt 4 has no JSON support of its own,
+/// and the introspection reports only need maps, lists, strings and
+/// numbers.
+/// \param inValue The value, usually a QVariantMap or QVariantList.
+/// \result UTF-8 encoded JSON.
+//-----------------------------------------------------------------------------
+QByteArray
+framework::toJson(const QVariant& inValue)
+{
+    QByteArray result;
+    writeValue(inValue, result);
+    return result;
+}
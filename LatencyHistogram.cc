@@ -0,0 +1,186 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "LatencyHistogram.h"
+
+// System
+#include <cmath>
+
+
+// Namespaces
+using namespace framework;
+
+
+//=============================================================================
+// class LatencyHistogram
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// LatencyHistogram::LatencyHistogram()
+//
+/// Constructor. The histogram is empty.
+//-----------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram()
+    :   mCount(0),
+        mMinimum(0),
+        mMaximum(0),
+        mTotal(0)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+// LatencyHistogram::record()
+//
+/// Count a duration.
+/// \param inNanoseconds The duration.
+//-----------------------------------------------------------------------------
+void
+LatencyHistogram::record(quint64 inNanoseconds)
+{
+    if (mCounts.isEmpty()) {
+        mCounts.fill(0, kBucketCount);
+    }
+    ++mCounts[bucketIndex(inNanoseconds)];
+
+    if (mCount == 0 || inNanoseconds < mMinimum) {
+        mMinimum = inNanoseconds;
+    }
+    if (inNanoseconds > mMaximum) {
+        mMaximum = inNanoseconds;
+    }
+    mTotal += inNanoseconds;
+    ++mCount;
+}
+
+
+//-----------------------------------------------------------------------------
+// LatencyHistogram::reset()
+//
+/// Forget every recorded duration and release the buckets.
+//-----------------------------------------------------------------------------
+void
+LatencyHistogram::reset()
+{
+    *this = LatencyHistogram();
+}
+
+
+//-----------------------------------------------------------------------------
+// LatencyHistogram::percentile()
+//
+/// Return the duration below which inPercent of the recorded durations
+/// fall. It is the upper end of the bucket holding that rank, but never
+/// more than the longest duration recorded.
+/// \param inPercent The percentile, between 0 and 100.
+/// \result The duration in nanoseconds, 0 if nothing was recorded.
+//-----------------------------------------------------------------------------
+quint64
+LatencyHistogram::percentile(double inPercent) const
+{
+    if (mCount == 0)
+        return 0;
+
+    const double fraction = qBound(0.0, inPercent / 100.0, 1.0);
+    const quint64 rank = qMax(quint64(1), quint64(std::ceil(fraction * double(mCount))));
+
+    quint64 seen = 0;
+    for (int index = 0; index < mCounts.size(); ++index) {
+        seen += mCounts.at(index);
+        if (seen >= rank) {
+            return qBound(mMinimum, bucketLimit(index), mMaximum);
+        }
+    }
+    return mMaximum;
+}
+
+
+//-----------------------------------------------------------------------------
+// LatencyHistogram::toVariantMap()
+//
+/// Summarize the histogram for Python and reports. Durations are in
+/// nanoseconds.
+/// \result count, min, max, mean, p50, p90, p99 and p999.
+//-----------------------------------------------------------------------------
+QVariantMap
+LatencyHistogram::toVariantMap() const
+{
+    QVariantMap result;
+    result["count"] = qulonglong(mCount);
+    result["min"] = qulonglong(mMinimum);
+    result["max"] = qulonglong(mMaximum);
+    result["mean"] = mean();
+    result["p50"] = qulonglong(percentile(50.0));
+    result["p90"] = qulonglong(percentile(90.0));
+    result["p99"] = qulonglong(percentile(99.0));
+    result["p999"] = qulonglong(percentile(99.9));
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// LatencyHistogram::bucketIndex()
+//
+/// Return the bucket counting inValue. Above kExactLimit the bucket is
+/// chosen by the highest set bit and the kSubBucketBits below it.
+//-----------------------------------------------------------------------------
+int
+LatencyHistogram::bucketIndex(quint64 inValue)
+{
+    if (inValue < quint64(kExactLimit))
+        return int(inValue);
+
+#if defined(__GNUC__)
+    int exponent = 63 - __builtin_clzll(inValue);
+#else
+    int exponent = 0;
+    for (quint64 value = inValue; value > 1; value >>= 1) {
+        ++exponent;
+    }
+#endif
+    if (exponent > kMaxExponent)
+        return kBucketCount - 1;
+
+    const int subBucket = int(inValue >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+    return kExactLimit + (exponent - kSubBucketBits - 1) * kSubBucketCount + subBucket;
+}
+
+
+//-----------------------------------------------------------------------------
+// LatencyHistogram::bucketLimit()
+//
+/// Return the largest value counted by a bucket.
+//-----------------------------------------------------------------------------
+quint64
+LatencyHistogram::bucketLimit(int inIndex)
+{
+    if (inIndex < kExactLimit)
+        return quint64(inIndex);
+
+    const int exponent = (inIndex - kExactLimit) / kSubBucketCount + kSubBucketBits + 1;
+    const int subBucket = (inIndex - kExactLimit) % kSubBucketCount;
+    const int shift = exponent - kSubBucketBits;
+    return ((quint64(kSubBucketCount + subBucket) << shift) | ((Q_UINT64_C(1) << shift) - 1));
+}
@@ -0,0 +1,89 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef AF_NC_LATENCY_HISTOGRAM_HAS_BEEN_INCLUDED
+#define AF_NC_LATENCY_HISTOGRAM_HAS_BEEN_INCLUDED
+
+// Qt
+#include <QVariant>
+#include <QVector>
+
+
+namespace framework {
+
+//=============================================================================
+// class LatencyHistogram
+//
+/// Distribution of durations in nanoseconds, kept in log-linear buckets
+/// like an HDR histogram. Durations below kExactLimit are counted exactly,
+/// longer ones in eight buckets per power of two, so a percentile is
+/// reported at most 12.5% above the true value. The buckets are only
+/// allocated once something is recorded.
+//=============================================================================
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(quint64 inNanoseconds);
+    void reset();
+
+    quint64 count() const;
+    quint64 minimum() const;
+    quint64 maximum() const;
+    quint64 total() const;
+    double mean() const;
+    quint64 percentile(double inPercent) const;
+
+    QVariantMap toVariantMap() const;
+
+private:
+    enum {
+        kSubBucketBits = 3,
+        kSubBucketCount = 1 << kSubBucketBits,
+        kExactLimit = 2 * kSubBucketCount,      // Values below are their own bucket
+        kMaxExponent = 47,                      // About 39 hours, longer values are clamped
+        kBucketCount = kExactLimit + (kMaxExponent - kSubBucketBits) * kSubBucketCount
+    };
+
+    static int bucketIndex(quint64 inValue);
+    static quint64 bucketLimit(int inIndex);
+
+    QVector<quint32> mCounts;
+    quint64 mCount;
+    quint64 mMinimum;
+    quint64 mMaximum;
+    quint64 mTotal;
+};
+
+// Inlines
+inline quint64 LatencyHistogram::count() const { return mCount; }
+inline quint64 LatencyHistogram::minimum() const { return mMinimum; }
+inline quint64 LatencyHistogram::maximum() const { return mMaximum; }
+inline quint64 LatencyHistogram::total() const { return mTotal; }
+inline double LatencyHistogram::mean() const { return mCount == 0 ? 0.0 : double(mTotal) / double(mCount); }
+
+} // namespace framework
+
+#endif // AF_NC_LATENCY_HISTOGRAM_HAS_BEEN_INCLUDED
@@ -0,0 +1,68 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef AF_NC_MONOTONIC_CLOCK_HAS_BEEN_INCLUDED
+#define AF_NC_MONOTONIC_CLOCK_HAS_BEEN_INCLUDED
+
+// Qt
+#include <QtGlobal>
+
+// System
+#if defined(Q_OS_MAC)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+
+namespace framework {
+
+//-----------------------------------------------------------------------------
+// monotonicNanoseconds()
+//
+/// Read a clock that never goes backwards, in nanoseconds. The origin is
+/// arbitrary, so only differences between two readings mean anything.
+/// Unlike QTime it is neither truncated to milliseconds nor moved by
+/// changes to the wall clock.
+/// \result The current reading of the clock.
+//-----------------------------------------------------------------------------
+inline quint64
+monotonicNanoseconds()
+{
+#if defined(Q_OS_MAC)
+    static mach_timebase_info_data_t sTimebase;
+    if (sTimebase.denom == 0) {
+        mach_timebase_info(&sTimebase);
+    }
+    return mach_absolute_time() * sTimebase.numer / sTimebase.denom;
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return quint64(now.tv_sec) * Q_UINT64_C(1000000000) + quint64(now.tv_nsec);
+#endif
+}
+
+} // namespace framework
+
+#endif // AF_NC_MONOTONIC_CLOCK_HAS_BEEN_INCLUDED
@@ -26,17 +26,24 @@ THE SOFTWARE.
 #include "NotificationCenter.h"
 
 // Qt
+#include <QAtomicInt>
 #include <QCoreApplication>
+#include <QMutexLocker>
 #include <QMetaObject>
 #include <QMetaMethod>
 #include <QObject>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QSemaphore>
 #include <QSet>
 #include <QtDebug>
 #include <QVector>
 #include <QThread>
+#include <QThreadPool>
 
 // System
 #include <boost/crc.hpp>
+#include <algorithm>
 #include <iostream>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -49,7 +56,10 @@ THE SOFTWARE.
 #include "GilState.h"
 
 // Local
+#include "JsonWriter.h"
+#include "MonotonicClock.h"
 #include "NotificationLogging.h"
+#include "NotificationTrace.h"
 #include "QtForPython.h"
 
 // sip defines ANY to be void; this breaks mm code, which uses the identifier
@@ -72,8 +82,25 @@ ConnectionId NotificationCenter::INVALID_CONNECTION_ID = static_cast<ConnectionI
 
 // Constants
 static const QEvent::Type kNCEventType = (QEvent::Type)(QEvent::User + 1);
+static const QEvent::Type kQueuedSlotEventType = (QEvent::Type)(QEvent::User + 2);
 static const QString kSignalSignature("(const framework::Event&)");
 
+// Layout of the meta object data, see the output of moc
+static const char kMetaClassName[] = "framework::NotificationCenter";
+enum {
+    kMetaRevision = 4,                          // Understood by Qt 4.6 and later
+    kMetaMethodCount = 4,                       // Index of the method count in the header
+    kMetaSignalCount = 13,                      // Index of the signal count in the header
+    kMetaHeaderSize = 14,
+    kMetaMethodSize = 5,                        // signature, parameters, type, tag, flags
+    kMetaSignalFlags = 0x05                     // MethodSignal | AccessProtected
+};
+
+// Dictionary keys of the status events
+static const EventKey kIdKey("id");
+static const EventKey kTypeKey("type");
+static const EventKey kKeyKey("key");
+
 // Set up a logging module
 #ifndef USE_LOCAL_LOGGING
 LOG_THIS_FILE_TO("notification_center");
@@ -141,19 +168,32 @@ EventId::EventId(const EventId& inFrom)
 //-----------------------------------------------------------------------------
 // EventId::registerSelf()
 //
-/// Called by notification center to create a unique event ID. This call
+/// Called by notification center to assign a unique event type. This call
 /// should not be called by the creator of the object.
+/// \param inEventType The event type handed out by the Notification Center.
 //-----------------------------------------------------------------------------
 void
-EventId::registerSelf()
+EventId::registerSelf(int inEventType)
 {
-    // Register for a unique Qt message id.
-    mEventType = QEvent::registerEventType();
+    mEventType = inEventType;
     
     //LOG_INFO("EventId::registerSelf() " << "EventType: " << mEventType);
 }
 
 
+//-----------------------------------------------------------------------------
+// EventId::unregisterSelf()
+//
+/// Called by notification center when the event type has been released
+/// and may be handed to another event.
+//-----------------------------------------------------------------------------
+void
+EventId::unregisterSelf()
+{
+    mEventType = NotificationCenter::INVALID_CONNECTION_ID;
+}
+
+
 //=============================================================================
 // class Event
 //
@@ -167,21 +207,166 @@ EventId::registerSelf()
 /// \param inId An event id.
 //-----------------------------------------------------------------------------
 Event::Event(const EventId& inId)
-    :   id(inId)
+    :   id(inId),
+        key(0),
+        hasKey(false),
+        serial(0),
+        parentSerial(0),
+        rootSerial(0),
+        cascadeDepth(0),
+        contentHash(0),
+        mPayloadType(NULL),
+        mDictionaryFilled(false)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+// Event::Event()
+//
+/// An event without an id. Only needed by QMetaType, which default
+/// constructs the events of queued signal connections.
+//-----------------------------------------------------------------------------
+Event::Event()
+    :   key(0),
+        hasKey(false),
+        serial(0),
+        parentSerial(0),
+        rootSerial(0),
+        cascadeDepth(0),
+        contentHash(0),
+        mPayloadType(NULL),
+        mDictionaryFilled(false)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+// Event::Event()
+//
+/// Constructor for a parametric event. Only the listeners connected
+/// with the same key, and those connected without a key, receive it.
+/// \param inId An event id.
+/// \param inKey The listener key.
+//-----------------------------------------------------------------------------
+Event::Event(const EventId& inId, quint64 inKey)
+    :   id(inId),
+        key(inKey),
+        hasKey(true),
+        serial(0),
+        parentSerial(0),
+        rootSerial(0),
+        cascadeDepth(0),
+        contentHash(0),
+        mPayloadType(NULL),
+        mDictionaryFilled(false)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+// Event::ensureDictionary()
+//
+/// Fill the dictionary from the payload of a typed event. Called by the
+/// Notification Center before the event reaches a listener that reads
+/// the dictionary. Entries already in the dictionary are kept.
+//-----------------------------------------------------------------------------
+void
+Event::ensureDictionary() const
+{
+    if (mDictionaryFilled)
+        return;
+
+    mDictionaryFilled = true;
+    fillDictionary(dictionary);
+}
+
+
+//-----------------------------------------------------------------------------
+// Event::clone()
+//
+/// Return a heap allocated copy of the event, for posting an event the
+/// caller owns. Subclasses carrying their own data override this.
+//-----------------------------------------------------------------------------
+Event*
+Event::clone() const
+{
+    return new Event(*this);
+}
+
+
+//-----------------------------------------------------------------------------
+// Event::fillDictionary()
+//
+/// Add the payload of the event to the dictionary. Untyped events carry
+/// no payload beyond the dictionary itself.
+/// \param outDictionary The dictionary to fill.
+//-----------------------------------------------------------------------------
+void
+Event::fillDictionary(EventDictionary& outDictionary) const
+{
+    Q_UNUSED(outDictionary);
+}
+
+
+//=============================================================================
+// class LazyEvent
+//
+/// An event that builds its dictionary only when a listener reads it.
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// LazyEvent::LazyEvent()
+//
+/// Constructor from an event id and the builder of its dictionary.
+/// \param inId An event id.
+/// \param inBuilder Called at most once, at dispatch time.
+//-----------------------------------------------------------------------------
+LazyEvent::LazyEvent(const EventId& inId, const EventPayloadBuilder& inBuilder)
+    :   Event(inId),
+        mBuilder(inBuilder)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+// LazyEvent::clone()
+//
+/// Return a heap allocated copy of the event.
+//-----------------------------------------------------------------------------
+Event*
+LazyEvent::clone() const
+{
+    return new LazyEvent(*this);
+}
+
+
+//-----------------------------------------------------------------------------
+// LazyEvent::fillDictionary()
+//
+/// Run the builder.
+/// \param outDictionary The dictionary to fill.
+//-----------------------------------------------------------------------------
+void
+LazyEvent::fillDictionary(EventDictionary& outDictionary) const
 {
+    if (!mBuilder.empty()) {
+        mBuilder(outDictionary);
+    }
 }
 
 
+namespace framework {
+
 //=============================================================================
 // class NCEvent
 //
 /// Used internally by the Notification Center to wrap and dispatch
 /// Notification Center events using the Qt synchronous and
 /// asynchronous messaging systems. It will clean up QEvent data that
-/// was passed into it.
+/// was passed into it. The event is owned outright, a QEvent is never
+/// shared, so there is no reference count to maintain.
 //=============================================================================
-typedef boost::shared_ptr<Event> EventRef;
-
 class NCEvent : public QEvent
 {
 public:
@@ -190,22 +375,35 @@ public:
     // NCEvent::NCEvent()
     //
     /// Constructor using pointer to callback data.
+    /// \param inCenter The Notification Center the event is posted to.
     /// \param inEvent The event. Ownership is passed to the custom event
     /// and will be deleted.
     //-----------------------------------------------------------------------------
-    explicit NCEvent(Event* inEvent)
+    NCEvent(NotificationCenter* inCenter, Event* inEvent)
         :   QEvent(kNCEventType),
-            mEvent(inEvent)
+            mCenter(inCenter),
+            mEvent(inEvent),
+            mPostTime(monotonicNanoseconds())
     {
     }
 
     //-----------------------------------------------------------------------------
     // NCEvent::~NCEvent()
     //
-    /// Delete custom data if ownership was passed to the object.
+    /// Delete custom data if ownership was passed to the object. A
+    /// deduplicated event removed from the queue without being dispatched
+    /// is forgotten by the center first. The cascade the event continued
+    /// may close once it is gone.
     //-----------------------------------------------------------------------------
     ~NCEvent()
     {
+        if (mEvent != NULL && mEvent->contentHash != 0) {
+            mCenter->releaseContent(*mEvent);
+        }
+        if (mEvent != NULL && !mCycleHistory.isEmpty()) {
+            mCenter->releaseQueuedCascade(mEvent->rootSerial);
+        }
+        delete mEvent;
     }
 
 
@@ -214,46 +412,265 @@ public:
     //
     /// Return the internal event data.
     //-----------------------------------------------------------------------------
-    EventRef 
+    Event* 
     getEvent() const
     {
         return mEvent;
     }
 
-    #ifdef DEBUG
-        int mTime;        // Used to profile performance.
-    #endif
+    //-----------------------------------------------------------------------------
+    // NCEvent::postTime()
+    //
+    /// Return when the event was posted, in monotonicNanoseconds().
+    //-----------------------------------------------------------------------------
+    quint64
+    postTime() const
+    {
+        return mPostTime;
+    }
+
+    //-----------------------------------------------------------------------------
+    // NCEvent::setCycleHistory()
+    //
+    /// Keep the path of the cascade the event continues, from the dispatch
+    /// that posted it to the root.
+    //-----------------------------------------------------------------------------
+    void
+    setCycleHistory(const CycleHistory& inHistory)
+    {
+        mCycleHistory = inHistory;
+    }
+
+    //-----------------------------------------------------------------------------
+    // NCEvent::cycleHistory()
+    //
+    /// Return the path of the cascade the event continues, NULL if the
+    /// event started a cascade of its own.
+    //-----------------------------------------------------------------------------
+    const CycleHistory*
+    cycleHistory() const
+    {
+        return mCycleHistory.isEmpty() ? NULL : &mCycleHistory;
+    }
 
 private:
     NCEvent(const NCEvent& );
     NCEvent& operator=(const NCEvent& );
 
-    boost::shared_ptr<Event> mEvent;
+    NotificationCenter* mCenter;
+    Event* mEvent;
+    quint64 mPostTime;
+    CycleHistory mCycleHistory;
+};
+
+} // namespace framework
+
+
+//-----------------------------------------------------------------------------
+// struct ListenerTimer
+//
+/// Adds the time until it goes out of scope to the profile of a
+/// listener. Does nothing without a profile.
+//-----------------------------------------------------------------------------
+struct ListenerTimer
+{
+    explicit ListenerTimer(ListenerProfile* inProfile)
+        :   mProfile(inProfile),
+            mStart(mProfile != NULL ? monotonicNanoseconds() : 0)
+    {
+    }
+
+    ~ListenerTimer()
+    {
+        if (mProfile != NULL) {
+            mProfile->record(monotonicNanoseconds() - mStart);
+        }
+    }
+
+    ListenerProfile* mProfile;
+    quint64 mStart;
+};
+
+
+#ifndef DISABLE_PYTHON
+//-----------------------------------------------------------------------------
+// struct TimedGilState
+//
+/// Takes the GIL like python_gil::GilState and records how long that took,
+/// unless the event has no latency.
+//-----------------------------------------------------------------------------
+struct TimedGilState
+{
+    explicit TimedGilState(EventLatency* outLatency)
+        :   mStart(monotonicNanoseconds())
+    {
+        if (outLatency != NULL) {
+            outLatency->gilWait.record(monotonicNanoseconds() - mStart);
+        }
+    }
+
+    quint64 mStart;
+    python_gil::GilState mGilState;
+};
+#endif
+
+
+//-----------------------------------------------------------------------------
+// findListenerProfile()
+//
+/// Return the profile of a connection, or NULL if it has none or if
+/// inProfiles is NULL.
+//-----------------------------------------------------------------------------
+static ListenerProfile*
+findListenerProfile(const ListenerProfileMap* inProfiles, ConnectionId inConnection)
+{
+    if (inProfiles == NULL)
+        return NULL;
+
+    ListenerProfileMap::const_iterator iter = inProfiles->constFind(inConnection);
+    return iter != inProfiles->constEnd() ? iter.value().get() : NULL;
+}
+
+
+//-----------------------------------------------------------------------------
+// struct CallbackScope
+//
+/// Records the call of a callback listener while tracing is on, and times
+/// it while listeners are profiled. The slots of the callback signals are
+/// tagged with their ConnectionId. The context is the profile table, NULL
+/// unless listeners are profiled.
+//-----------------------------------------------------------------------------
+struct CallbackScope
+{
+    typedef const ListenerProfileMap* Context;
+
+    CallbackScope(Context inProfiles, const Event& inEvent, unsigned int inConnection)
+        :
+#ifndef NC_DISABLE_TRACE
+            mTrace(TRACE_LISTENER_BEGIN, TRACE_LISTENER_END, inEvent.id.getHash(), inConnection, CONNECTION_TYPE_BOOST),
+#endif
+            mTimer(findListenerProfile(inProfiles, inConnection))
+    {
+        Q_UNUSED(inEvent);
+    }
+
+#ifndef NC_DISABLE_TRACE
+    TraceScope mTrace;
+#endif
+    ListenerTimer mTimer;
 };
 
 
+//-----------------------------------------------------------------------------
+// pythonCallableName()
+//
+/// Return the qualified name of a python method, Class.method, for
+/// profiling reports.
+//-----------------------------------------------------------------------------
+static std::string
+pythonCallableName(PyObject* inObject)
+{
+    std::string result;
+
+#ifndef DISABLE_PYTHON
+    python_gil::GilState gilstate;
+
+    PyObject* name = PyObject_GetAttrString(inObject, "__name__");
+    if (name != NULL && PyString_Check(name)) {
+        result = PyString_AsString(name);
+    }
+    Py_XDECREF(name);
+
+    PyObject* owner = PyObject_GetAttrString(inObject, "im_class");
+    if (owner != NULL) {
+        PyObject* ownerName = PyObject_GetAttrString(owner, "__name__");
+        if (ownerName != NULL && PyString_Check(ownerName)) {
+            result = std::string(PyString_AsString(ownerName)) + "." + result;
+        }
+        Py_XDECREF(ownerName);
+    }
+    Py_XDECREF(owner);
+
+    // Callables without these attributes just have no name.
+    PyErr_Clear();
+#else
+    Q_UNUSED(inObject);
+#endif
+
+    return result.empty() ? DEFAULT_CALLBACK_NAME : result;
+}
+
+
+//-----------------------------------------------------------------------------
+// pythonFunctionName()
+//
+/// Return the qualified name of a connected python method, for the
+/// profiles started after it was connected.
+//-----------------------------------------------------------------------------
+static std::string
+pythonFunctionName(const PythonFunctionInfoRef& inFunction)
+{
+#ifndef DISABLE_PYTHON
+    if (inFunction && inFunction->isValid()) {
+        python_gil::GilState gilstate;
+        PyObject* method = PyMethod_New(inFunction->functionMethod,
+                                        inFunction->functionSelf,
+                                        inFunction->functionClass);
+        if (method != NULL) {
+            const std::string result = pythonCallableName(method);
+            Py_DECREF(method);
+            return result;
+        }
+        PyErr_Clear();
+    }
+#else
+    Q_UNUSED(inFunction);
+#endif
+
+    return DEFAULT_CALLBACK_NAME;
+}
+
+
 //=============================================================================
 // class NotificationCenter
 //
 /// The Notification Center allows the free form connection of notifiers
 /// and observers.
 ///
-/// To enable runtime debug output in development builds, create a file
-/// named af_notification_center_debug in tmp.
+/// Posting, dispatching, connecting and disconnecting are recorded by
+/// NotificationTrace, see NotificationTrace.h.
+///
+/// To print failed connections and other diagnostics in development
+/// builds, create a file named af_notification_center_debug in tmp.
 /// For example: touch /tmp/af_notification_center_debug.
-/// This will cause the Notification Center to output a verbose
-/// activity stream to the console.
 //
 //=============================================================================
 
 // Set up our own events that we use to broadcast status.
 framework::EventId NotificationCenter::EventRegistered("com.mightytoad.ApplicationFramework.NotificationCenter.EventRegistered");
+framework::EventId NotificationCenter::EventUnregistered("com.mightytoad.ApplicationFramework.NotificationCenter.EventUnregistered");
 framework::EventId NotificationCenter::EventConnected("com.mightytoad.ApplicationFramework.NotificationCenter.EventConnected");
 framework::EventId NotificationCenter::EventDisconnected("com.mightytoad.ApplicationFramework.NotificationCenter.EventDisconnected");
 
 // Set the default event coalescing quantuum
 static const int kCoalesceInterval = 20;  // in milliseconds
 
+
+
+//-----------------------------------------------------------------------------
+// lastEventSerial()
+//
+/// The last serial stamped on an event. Shared by every Notification
+/// Center, so serials are unique in the process and link posts to
+/// dispatches in the trace.
+//-----------------------------------------------------------------------------
+static QAtomicInt&
+lastEventSerial()
+{
+    static QAtomicInt sLastSerial(0);
+    return sLastSerial;
+}
+
 //-----------------------------------------------------------------------------
 // NotificationCenter::NotificationCenter()
 //
@@ -261,6 +678,15 @@ static const int kCoalesceInterval = 20;  // in milliseconds
 //-----------------------------------------------------------------------------
 NotificationCenter::NotificationCenter()
     :   mConnectionIdCount(0)
+    ,   mDeadMetaStrings(0)
+    ,   mDispatchDepth(0)
+    ,   mSealed(false)
+    ,   mPlansStale(false)
+    ,   mDisconnectCount(0)
+    ,   mListenerProfiling(false)
+    ,   mMaxCascadeDepth(0)
+    ,   mMaxCascadeFanOut(0)
+    ,   mMaxCycleRepeats(0)
     ,   mCoalesceInterval(kCoalesceInterval)
     ,   mTimerId(0)
     ,   mDebugOutput(false)
@@ -269,8 +695,14 @@ NotificationCenter::NotificationCenter()
     struct stat info;
     mDebugOutput = stat("/tmp/af_notification_center_debug", &info) == 0;
 
+    // Registered events become signals of the meta object, whose
+    // queued connections copy the event.
+    qRegisterMetaType<framework::Event>("framework::Event");
+    initMetaObject();
+
     // Register our own events
     registerEvent(EventRegistered);
+    registerEvent(EventUnregistered);
     registerEvent(EventConnected);
     registerEvent(EventDisconnected);
 
@@ -288,6 +720,10 @@ NotificationCenter::NotificationCenter()
 //-----------------------------------------------------------------------------
 NotificationCenter::~NotificationCenter()
 {
+    // Events still queued release their content while the center is
+    // alive, QObject would only delete them once it is gone.
+    QCoreApplication::removePostedEvents(this, kNCEventType);
+
 #ifdef NC_COALESCE_EVENTS
     // Shut down the event coalescing timer
     killTimer(mTimerId);
@@ -303,9 +739,9 @@ NotificationCenter::~NotificationCenter()
         LOG_WARN("Notification Center: " << mConnectionMap.size() 
             << " active connections during shutdown."); 
 
-        ConnectionMap disconnectUs = mConnectionMap;
+        const ConnectionMap disconnectUs = mConnectionMap;
         
-        ConnectionMap::iterator iter = disconnectUs.begin();
+        ConnectionMap::const_iterator iter = disconnectUs.begin();
         for ( ; iter != disconnectUs.end(); ++iter) {
 
             const ConnectionInfo& connectionInfo = iter.value();
@@ -313,18 +749,25 @@ NotificationCenter::~NotificationCenter()
             LOG_WARN("active connection" 
                   << std::endl
                   << "      "
-                  << "EventId: " << qPrintable(connectionInfo.eventId.mStringId) 
+                  << "EventId: " << qPrintable(eventIdForHash(connectionInfo.eventHash).mStringId) 
                   << std::endl
                   << "      "
-                  << "ConnectId: " << connectionInfo.connectionId 
+                  << "ConnectId: " << iter.key() 
                   << std::endl
                   << "      "
                   << "ConnectionType: " 
                   << qPrintable(connectionTypeToString(connectionInfo.type)) << std::endl);
                   
-            disconnect(connectionInfo.connectionId);
+            disconnect(iter.key());
         }        
     }
+
+    // The relays live in the threads of their receivers.
+    Q_FOREACH(const QPointer<QObject>& relay, mSlotRelays) {
+        if (!relay.isNull()) {
+            relay->deleteLater();
+        }
+    }
 }
 
 
@@ -341,16 +784,7 @@ NotificationCenter::timerEvent(QTimerEvent* inEvent)
 
 #ifdef NC_COALESCE_EVENTS
     Q_FOREACH(const EventPriorityPair& eventPair, mCoalesceList) {
-    
-        // Create the QEvent to send
-        NCEvent* theEvent = new NCEvent(eventPair.first);
-
-#ifdef DEBUG
-        // Stamp the event with the start time
-        theEvent->mTime = QTime::currentTime().elapsed();
-#endif    
-
-        QCoreApplication::postEvent(this, theEvent, eventPair.second);
+        QCoreApplication::postEvent(this, eventPair.first, eventPair.second);
     }
 
     // All pending events have been processed.
@@ -387,29 +821,41 @@ NotificationCenter::registeredEvents() const
 // NotificationCenter::registerEvent()
 //
 /// Register and event ID with the event registry.
+/// Every call adds a publisher reference to the event and should be
+/// balanced by a call to unregisterEvent() once the publisher goes away.
 /// \param inEventId Event ID to add to the event registry
 /// \result True if the event was registered, false if it has been registered.
 //-----------------------------------------------------------------------------
 bool
 NotificationCenter::registerEvent(const EventId& inEventId)
 {
-    if (mDebugOutput) {
-        LOG_INFO("NotificationCenter::registerEvent() ----> "
-                  << "EventId: " << inEventId);
-    }
+    NC_TRACE(TRACE_REGISTER, inEventId.getHash(), 0);
+
+    // Registered events show up in the snapshot before anything else
+    // happens to them.
+    statisticsFor(inEventId);
 
     bool result = true;
 
+    // Every registration holds the event until it is unregistered.
+    ++mPublisherCounts[inEventId.getHash()];
+
     // Check and see if this event is already in the registry
     EventRegistry::iterator iter = mEventRegistry.find(inEventId.getHash());
     if (iter == mEventRegistry.end()) {
-        // We did not find a registered event.
+        // We did not find a registered event. Hand out a released
+        // event type if there is one, otherwise ask Qt for a new one.
+        const int eventType = mFreeEventTypes.isEmpty() ? QEvent::registerEventType()
+                                                        : mFreeEventTypes.takeLast();
+
         // Register the event
         EventId& localEvent = const_cast<EventId&>(inEventId);
-        localEvent.registerSelf();
+        localEvent.registerSelf(eventType);
 
         // Add the event to the list of events available.
         mEventRegistry[inEventId.getHash()] = localEvent;
+        addEventSignal(localEvent);
+        NotificationTrace::nameEvent(inEventId.getHash(), inEventId.getStringId());
 
         // Check the deferred event list and make the connections to anyone waiting for
         // this particular event.
@@ -417,7 +863,7 @@ NotificationCenter::registerEvent(const EventId& inEventId)
 
         // Send a notification about the event registration.
         Event* event = new Event(EventRegistered);
-        event->dictionary["id"] = inEventId.mStringId;
+        event->dictionary[kIdKey] = inEventId.mStringId;
         postEvent(event);
 
     } else {
@@ -435,1185 +881,3772 @@ NotificationCenter::registerEvent(const EventId& inEventId)
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::emitDynamicSignal()
+// NotificationCenter::unregisterEvent()
 //
-/// Dynamic signal invocation mechanism.
+/// Release a publisher reference taken by registerEvent(). Once the last
+/// publisher and the last listener are gone, the event is removed from
+/// the registry, all of its state is freed and its event type is reused
+/// by the next registration.
+/// \param inEventId Event ID to release.
+/// \result True if a registration was released.
 //-----------------------------------------------------------------------------
 bool
-NotificationCenter::emitDynamicSignal(const QString& inSignal, void** inArgs)
+NotificationCenter::unregisterEvent(const EventId& inEventId)
 {
-    bool result = false;
+    NC_TRACE(TRACE_UNREGISTER, inEventId.getHash(), 0);
 
-    // Get the signal signature and id
-    const QByteArray theSignal = QMetaObject::normalizedSignature(inSignal.toLatin1());
-    const int signalId = mQtSignalIndices.value(theSignal, -1);
+    EventReferenceMap::iterator iter = mPublisherCounts.find(inEventId.getHash());
+    if (iter == mPublisherCounts.end()) {
+        if (mDebugOutput) {
+            LOG_WARN("NotificationCenter::unregisterEvent() event not registered ----> "
+                      << "EventId: " << inEventId);
+        }
+        return false;
+    }
 
-    if (signalId >= 0) {
+    if (--iter.value() == 0) {
+        mPublisherCounts.erase(iter);
 
-		if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::emitDynamicSignal() ----> "
-                      << "signal: " << theSignal.data()
-                      << "     "
-                      << "signalId: " << signalId);
-        }
+        // Listeners may still hold the event. If so, it is released
+        // when the last of them disconnects.
+        releaseEventIfUnused(inEventId.getHash());
 
-        QMetaObject::activate(this,
-                              metaObject(),
-                              signalId + metaObject()->methodCount(),
-                              inArgs);
-        result = true;
-    } else {
-        if (mDebugOutput) {
-            LOG_ERROR("NotificationCenter::emitDynamicSignal() failed ----> "
-                      << "signal: " << theSignal.data()
-                      << "     "
-                      << "signalId: " << signalId);
+        // Mirror registerSelf() on the caller's copy if it has been released.
+        if (!mEventRegistry.contains(inEventId.getHash())) {
+            const_cast<EventId&>(inEventId).unregisterSelf();
         }
     }
 
-    return result;
+    return true;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::connectDynamicSignal()
+// NotificationCenter::resolveQtSlot()
 //
-/// Internal notification center event handling.
-/// \param ioInfo The ConnectionInfo
-/// \result True if the connection was made.
+/// Find the slot of a Qt connection in the meta object of its receiver.
+/// \param inId The EventId the slot is connected to.
+/// \param inInfo The QtConnectionInfo
+/// \result The index of the slot, or -1 if it can not receive the event.
 //-----------------------------------------------------------------------------
-bool
-NotificationCenter::connectDynamicSignal(ConnectionInfo& ioInfo)
+int
+NotificationCenter::resolveQtSlot(const EventId& inId, const QtConnectionInfo& inInfo) const
 {
-    Q_ASSERT(ioInfo.qtObject != NULL);
+    // The receiver may have been destroyed while the connection waited
+    // for its event.
+    if (inInfo.receiver.isNull())
+        return -1;
+
+    // Get the signal name and normalize it. The slot was normalized when
+    // the connection was made.
+    const QByteArray convertStr = (inId.getStringId() + kSignalSignature).toAscii();
+    const QByteArray theSignal = QMetaObject::normalizedSignature(convertStr.data());
+    const QByteArray& theSlot = inInfo.slot;
 
-    // Get the slot and signal names and normalize them.
-    const QByteArray& convertStr = ioInfo.qtSignal.toAscii();
-    QByteArray theSignal = QMetaObject::normalizedSignature(convertStr.data());
-    QByteArray theSlot = QMetaObject::normalizedSignature(ioInfo.qtMethod.toAscii());
-    
     if (!QMetaObject::checkConnectArgs(theSignal, theSlot)) {
-        if (mDebugOutput) { 
-            LOG_ERROR("NotificationCenter::connectDynamicSignal() checkConnectArgs() failed ----> "
+        if (mDebugOutput) {
+            LOG_ERROR("NotificationCenter::resolveQtSlot() checkConnectArgs() failed ----> "
                       << "signal: " << theSignal.data()
                       << "     "
                       << "slot: " << theSlot.data());
 
 #ifdef NC_VERBOSE
-            // Dump all the notification center object info
-			dumpMethods();
-            
             // Dump all the target object info
-			dumpConnectionMethods(ioInfo);
+			dumpConnectionMethods(inInfo);
 #endif
         }
-        return false;
+        return -1;
     }
 
-    const int slotId = ioInfo.qtObject->metaObject()->indexOfSlot(theSlot);
-    if (slotId < 0) {
+    const int slotIndex = inInfo.receiver->metaObject()->indexOfSlot(theSlot);
+    if (slotIndex < 0) {
         if (mDebugOutput) {
-            LOG_ERROR("NotificationCenter::connectDynamicSignal() indexOfSlot() failed ----> "
-                      << "slotId: " << slotId
-                      << "     "
+            LOG_ERROR("NotificationCenter::resolveQtSlot() indexOfSlot() failed ----> "
                       << "signal: " << theSignal.data()
                       << "     "
                       << "slot: " << theSlot.data());
 
 #ifdef NC_VERBOSE
             // Dump all the target object info
-			dumpConnectionMethods(ioInfo);
+			dumpConnectionMethods(inInfo);
 #endif
         }
-        return false;
     }
 
-    int signalId = mQtSignalIndices.value(theSignal, -1);
-    if (signalId < 0) {
-        signalId = mQtSignalIndices.size();
-        mQtSignalIndices[theSignal] = signalId;
-
-        // Set up the conection info
-        ioInfo.qtSignal = const_cast<char *>(convertStr.data());
-    }
-	
-    return QMetaObject::connect(this,
-    							signalId + metaObject()->methodCount(),
-    							ioInfo.qtObject,
-    							slotId);
+    return slotIndex;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::event()
+// class QueuedSlotEvent
 //
-/// Internal notification center event handling. If the event is in the
-/// UserEvent space, we attempt to handle it.
+/// A slot call queued to the thread of its receiver, along with a copy of
+/// the event.
 //-----------------------------------------------------------------------------
-bool
-NotificationCenter::event(QEvent* inEvent)
+class QueuedSlotEvent : public QEvent
 {
-    bool result = false;
-
-    if (inEvent->type() >= QEvent::User) {
-        result = handleCustomEvent(inEvent);
-    } else {
-        result = QObject::event(inEvent);
+public:
+    QueuedSlotEvent(const QtSlotInvoker& inInvoker, Event* inEvent)
+        :   QEvent(kQueuedSlotEventType),
+            mInvoker(inInvoker),
+            mEvent(inEvent)
+    {
     }
 
-    return result;
-}
+    virtual ~QueuedSlotEvent()
+    {
+        delete mEvent;
+    }
+
+    void deliver() const
+    {
+        void* args[2] = { 0, mEvent };
+        mInvoker(args);
+    }
+
+private:
+    QtSlotInvoker mInvoker;
+    Event* mEvent;
+};
 
 
-#ifndef DISABLE_PYTHON
 //-----------------------------------------------------------------------------
-// NotificationCenter::callPythonFunctor()
+// class QueuedSlotRelay
+//
+/// Runs the slot calls queued to the thread it lives in.
 //-----------------------------------------------------------------------------
-struct callPythonFunctor
+class QueuedSlotRelay : public QObject
 {
-    callPythonFunctor(Event* inEvent)
-        :   mEvent(inEvent)
+public:
+    virtual bool event(QEvent* inEvent)
     {
+        if (inEvent->type() == kQueuedSlotEventType) {
+            static_cast<QueuedSlotEvent*>(inEvent)->deliver();
+            return true;
+        }
+
+        return QObject::event(inEvent);
     }
+};
 
-    void operator()(PythonFunctionInfoRef inPythonFunctionInfo)
-    {
-        if (inPythonFunctionInfo->isValid()) {
-            // Create the puthon method from the saved properties.
-            PyObject* pyMethod = PyMethod_New(inPythonFunctionInfo->functionMethod,
-                                              inPythonFunctionInfo->functionSelf,
-                                              inPythonFunctionInfo->functionClass);
-            if (pyMethod != NULL) {
-                QHash<QString, QVariant> source = mEvent->dictionary;
-                PyObject* dict = QtForPython_HashToPython(source);
-                PyObject* arglist = NULL;
-                if (dict == NULL) {
-                    LOG_ERROR(mEvent->id.getStringId().toStdString() <<
-                              " : event dictionary can not be translated to python ");
-                    arglist = PyTuple_New(1);
-                    PyTuple_SetItem(arglist, 0, PyDict_New());
-                } else {
-                    // Create the argument list, place dict in tuple
-                    arglist = Py_BuildValue("(O)", dict);
-                }
-                
-                Q_ASSERT(arglist != NULL);
-                    
-                // Attempt to call the callback
-                PyObject* pyResult = PyEval_CallObject(pyMethod, arglist);
-                if (pyResult == NULL && PyErr_Occurred()) {
-                    //Error is handled here because there may be no higher
-                    //handler for notification callback
-                    PyErr_Print();
-                    PyErr_Clear();
-                }
-                
-                Py_XDECREF(pyResult);
 
-                // We are done with the argument and the method
-                Py_DECREF(arglist);
-                Py_XDECREF(dict);
-                Py_DECREF(pyMethod);
-            }
+//-----------------------------------------------------------------------------
+// NotificationCenter::queueSlotCall()
+//
+/// Call a slot from the thread of its receiver, as a queued connection
+/// would. The event is copied since the caller's is gone by then.
+/// \param inInvoker The slot to call.
+/// \param inThread The thread of the receiver.
+/// \param inEvent The event to deliver.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::queueSlotCall(const QtSlotInvoker& inInvoker, QThread* inThread, const Event& inEvent)
+{
+    QPointer<QObject>& relay = mSlotRelays[inThread];
+    if (relay.isNull()) {
+        relay = new QueuedSlotRelay();
+        relay->moveToThread(inThread);
+        QObject::connect(inThread, SIGNAL(finished()), relay, SLOT(deleteLater()));
+    }
+
+    QCoreApplication::postEvent(relay, new QueuedSlotEvent(inInvoker, inEvent.clone()));
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::emitQtSlots()
+//
+/// Call the Qt slots of an event. Receivers living in this thread are
+/// called directly, the others from their own thread.
+/// \param inInvokers The slots of the event.
+/// \param inEvent The event to deliver.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::emitQtSlots(const QtSlotInvokerList& inInvokers, const Event& inEvent)
+{
+    void* args[2] = { 0, const_cast<Event*>(&inEvent) };
+    QThread* currentThread = thread();
+
+    // The list is not updated until the dispatch returns, so once a
+    // listener disconnects anything each slot is checked first.
+    const unsigned int disconnectCount = mDisconnectCount;
+    const QtSlotInvoker* invoker = inInvokers.constData();
+    const QtSlotInvoker* end = invoker + inInvokers.size();
+    for ( ; invoker != end; ++invoker) {
+        NC_PREFETCH(invoker + 4);
+        if (mDisconnectCount != disconnectCount && !mQtConnections.contains(invoker->connection))
+            continue;
+
+        QObject* receiver = invoker->receiver.data();
+        if (receiver == NULL)
+            continue;
+
+        if (receiver->thread() == currentThread) {
+            NC_TRACE_SCOPE_ARG(TRACE_LISTENER_BEGIN, TRACE_LISTENER_END, inEvent.id.getHash(), invoker->connection, CONNECTION_TYPE_QT);
+            ListenerTimer timer(listenerProfile(invoker->connection));
+            (*invoker)(args);
+        } else {
+            queueSlotCall(*invoker, receiver->thread(), inEvent);
         }
     }
+}
 
-    Event* mEvent;
-};
-#endif
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::handleCustomEvent()
+// NotificationCenter::initMetaObject()
 //
-/// Internal notification center event handling.
-///
-/// We take the event ID from the event passed in and check for
-/// connected boost and Qt slots. If we find either, we manually
-/// invoke the signal.
+/// Set up the meta object of the Notification Center. It starts out as
+/// a QObject without methods of its own, addEventSignal() appends a
+/// signal for each registered event.
 //-----------------------------------------------------------------------------
-bool
-NotificationCenter::handleCustomEvent(QEvent* inQtEvent)
+void
+NotificationCenter::initMetaObject()
 {
-    // We only care about a single type of custom event.
-    if (inQtEvent->type() != kNCEventType)
-        return false;
+    // The class name, followed by the empty string used for the return
+    // type, tag and parameter names of every signal.
+    mMetaStrings = QByteArray(kMetaClassName, sizeof(kMetaClassName));
+    mMetaStrings.append('\0');
+
+    static const uint kHeader[kMetaHeaderSize] = {
+        kMetaRevision,
+        0,                                      // classname
+        0, 0,                                   // classinfo
+        0, kMetaHeaderSize,                     // methods
+        0, 0,                                   // properties
+        0, 0,                                   // enums/sets
+        0, 0,                                   // constructors
+        0,                                      // flags
+        0                                       // signalCount
+    };
 
-    if (mDebugOutput) {
-        LOG_INFO("NotificationCenter Manager: handleCustomEvent() ----> "
-                  << "Type:" << (int)inQtEvent->type());
+    mMetaData.reserve(kMetaHeaderSize + 1);
+    for (int index = 0; index < kMetaHeaderSize; ++index) {
+        mMetaData.push_back(kHeader[index]);
     }
+    mMetaData.push_back(0);                     // eod
 
-    // Get the NotificationCenter event out of the QEvent
-#ifdef DEBUG
-    NCEvent* customEvent = dynamic_cast<NCEvent *>(inQtEvent);
-    Q_ASSERT(customEvent != NULL);
-#else
-    NCEvent* customEvent = static_cast<NCEvent *>(inQtEvent);
-#endif
+    mMetaObject.d.superdata = &QObject::staticMetaObject;
+    mMetaObject.d.stringdata = mMetaStrings.constData();
+    mMetaObject.d.data = mMetaData.constData();
+    mMetaObject.d.extradata = NULL;
+}
 
-    EventRef event = customEvent->getEvent();
-    if (event.get() == NULL) {
-        // No custom event data.
-        return false;
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::addEventSignal()
+//
+/// Give a registered event its signal, "<string id>(framework::Event)".
+/// An event that is released and registered again gets its old signal
+/// back, along with the connections made to it. Otherwise the signal of
+/// a released event that nothing is connected to any more is renamed for
+/// the new event, so the meta object only grows with the number of
+/// events alive at the same time. Signals are never removed, so the
+/// indices of the others stay valid.
+/// \param inId The EventId.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::addEventSignal(const EventId& inId)
+{
+    SignalIndexMap::const_iterator iter = mSignalIndices.constFind(inId.getHash());
+    if (iter != mSignalIndices.constEnd()) {
+        mReleasedSignals.removeOne(iter.value());
+        return;
     }
 
-    // We get the event type and attempt to retrieve the event
-    // registration info.  The info will contain a list of all
-    // connected boost::slots and all connected Qt::slots.
-    EventMap::iterator eventIter = mEvents.find(event->id);
-    if (eventIter != mEvents.end()) {
+    const QByteArray convertStr = (inId.getStringId() + kSignalSignature).toAscii();
+    const QByteArray signature = QMetaObject::normalizedSignature(convertStr.data());
 
-        // Get the callback info pair from the iterator
-        const EventCallbackInfo& callbackInfo = eventIter.value();
+    int index = takeReleasedSignal();
+    if (index >= 0) {
+        // The old signature stays in the string data until it is compacted.
+        uint& signatureOffset = mMetaData[kMetaHeaderSize + index * kMetaMethodSize];
+        mDeadMetaStrings += qstrlen(mMetaStrings.constData() + signatureOffset) + 1;
+        signatureOffset = mMetaStrings.size();
+        mMetaStrings.append(signature);
+        mMetaStrings.append('\0');
 
-        // Handle the boost signals
-        if (!callbackInfo.boostSignal->empty()) {
-            (*callbackInfo.boostSignal)(*event);
-        }
+        mSignalIndices.remove(mEventSignals.at(index).eventHash);
+        mEventSignals[index] = EventSignalInfo(inId.getHash());
 
-        // Handle the Qt signals
-        if (!callbackInfo.qtSlotSignature.isEmpty()) {
-            QVector<void *> args(2, 0);
-            args[0] = 0;
-            args[1] = event.get();
-            emitDynamicSignal(callbackInfo.qtSlotSignature, args.data());
+        if (mDeadMetaStrings > mMetaStrings.size() / 2) {
+            compactMetaStrings();
         }
+    } else {
+        const uint signatureOffset = mMetaStrings.size();
+        mMetaStrings.append(signature);
+        mMetaStrings.append('\0');
 
-#ifndef DISABLE_PYTHON
-        if (!callbackInfo.pythonFunctionList.empty()) {
-            python_gil::GilState gilstate;
-            // Handle the python callables
-            std::for_each(callbackInfo.pythonFunctionList.begin(),
-                          callbackInfo.pythonFunctionList.end(),
-                          callPythonFunctor(event.get()));
-        }
-#endif
+        // Replace the end marker with the signal.
+        const uint emptyOffset = sizeof(kMetaClassName);
+        mMetaData.back() = signatureOffset;
+        mMetaData << emptyOffset << emptyOffset << emptyOffset << kMetaSignalFlags;
+        mMetaData.push_back(0);                 // eod
+
+        ++mMetaData[kMetaMethodCount];
+        ++mMetaData[kMetaSignalCount];
+
+        index = mEventSignals.size();
+        mEventSignals.push_back(EventSignalInfo(inId.getHash()));
     }
 
-#ifdef DEBUG
-    if (mDebugOutput)
-        LOG_INFO("Event dispatch time: " << QTime::currentTime().elapsed() - customEvent->mTime);
-#endif
+    mMetaObject.d.stringdata = mMetaStrings.constData();
+    mMetaObject.d.data = mMetaData.constData();
 
-    return true;
+    mSignalIndices.insert(inId.getHash(), index);
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::postEvent()
+// NotificationCenter::takeReleasedSignal()
 //
-/// Helper method to create an event and post the event
-/// using just an EventId. This is useful if you are posting
-/// an event with no dictionary entries.
-/// \param inId The EventId to create an event for.
-/// \param inPostType The type in which to post the event.
-/// \sa PostType.
+/// Find the signal of a released event that has no receivers left.
+/// Receivers may still be connected to a released event, waiting for it
+/// to be registered again, so their signal is kept.
+/// \result The signal index, or -1 if there is none.
 //-----------------------------------------------------------------------------
-void
-NotificationCenter::postEvent(const EventId& inId, PostType inPostType)
+int
+NotificationCenter::takeReleasedSignal()
 {
-	postEvent(new Event(inId), inPostType);
+    for (int position = mReleasedSignals.size() - 1; position >= 0; --position) {
+        const int index = mReleasedSignals.at(position);
+        if (receivers(eventSignalCode(index).constData()) == 0) {
+            mReleasedSignals.removeAt(position);
+            return index;
+        }
+    }
+    return -1;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::postEvent()
+// NotificationCenter::compactMetaStrings()
 //
-/// Helper method to create an event and post the event
-/// using just an EventId. This is useful if you are posting
-/// an event with no dictionary entries.
-/// \param inEvent A pointer to an event object.
-/// \param inPriority The priority in which the event will be handled.
-/// \param inPostType The type in which to post the event.
+/// Drop the signatures of renamed signals from the string data of the
+/// meta object.
 //-----------------------------------------------------------------------------
 void
-NotificationCenter::postEvent(const EventId& inId,
-                              PostPriority inPriority,
-                              PostType inPostType)
+NotificationCenter::compactMetaStrings()
 {
-	postEvent(new Event(inId), inPriority, inPostType);
+    QByteArray strings(kMetaClassName, sizeof(kMetaClassName));
+    strings.append('\0');
+
+    for (int index = 0; index < mEventSignals.size(); ++index) {
+        uint& signatureOffset = mMetaData[kMetaHeaderSize + index * kMetaMethodSize];
+        const char* signature = mMetaStrings.constData() + signatureOffset;
+        signatureOffset = strings.size();
+        strings.append(signature);
+        strings.append('\0');
+    }
+
+    mMetaStrings = strings;
+    mDeadMetaStrings = 0;
 }
 
 
+//-----------------------------------------------------------------------------
+// NotificationCenter::eventSignalCode()
+//
+/// Return the signature of an event signal with its SIGNAL() code in
+/// front, as QObject::receivers() expects it.
+/// \param inIndex The signal index.
+//-----------------------------------------------------------------------------
+QByteArray
+NotificationCenter::eventSignalCode(int inIndex) const
+{
+    QByteArray code("2");
+    code.append(mMetaStrings.constData() + mMetaData.at(kMetaHeaderSize + inIndex * kMetaMethodSize));
+    return code;
+}
+
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::postEvent()
+// NotificationCenter::emitEventSignal()
 //
-/// Post an event to the notification center event queue. 
-//  The event must be allocated on the heap as the
-/// event queue will take ownership of the event. 
-/// Events are processed in the order that they are posted.
-/// If the event is posted with a post type of POST_NOW,
-/// all events in the queue will be posted and then
-/// the event will be posted synchronously.
-/// \param inEvent A pointer to an event object.
-/// \param inPostType The type in which to post the event.
-/// \sa PostType.
+/// Emit the signal of an event. Qt returns at once if nothing is
+/// connected to it.
+///
+/// Typed and lazy events only fill their dictionary for signals connected
+/// with QObject::connect(), as QMetaObject::connect(), which QSignalSpy
+/// uses, is not reported to the sender. Such receivers can call
+/// Event::ensureDictionary() themselves.
+///
+/// Queued receivers get a copy of the event as a plain Event, so the
+/// payload of a typed event and the builder of a lazy event are lost.
+/// Only the dictionary, filled before the copy for receivers connected
+/// with QObject::connect(), reaches them.
+/// \param inEvent The event to deliver.
+/// \result True if a receiver is connected with QObject::connect().
 //-----------------------------------------------------------------------------
-void
-NotificationCenter::postEvent(Event* inEvent, PostType inPostType)
+bool
+NotificationCenter::emitEventSignal(const Event& inEvent)
 {
-    Q_ASSERT(inEvent != NULL);
+    const int index = mSignalIndices.value(inEvent.id.getHash(), -1);
+    if (index < 0)
+        return false;
 
-    if (mDebugOutput) {
-        LOG_INFO("NotificationCenter Manager: postEvent() ----> "
-                  << "EventId: "   << inEvent->id);
+    const bool connected = mEventSignals.at(index).connected;
+    if (connected) {
+        inEvent.ensureDictionary();
     }
-    
-    QThread* currentThread = QThread::currentThread();
-    QThread* receiverThread = this->thread();
-    if (inPostType == POST_SOON || currentThread != receiverThread) {
-#ifdef NC_COALESCE_EVENTS
-        mCoalesceList.push_back(qMakePair(inEvent, PRIORITY_NORMAL));
-#else        
-        // Create the QEvent to send
-        NCEvent* ncEvent = new NCEvent(inEvent);
 
-#ifdef DEBUG
-        // Stamp the event with the start time
-        ncEvent->mTime = QTime::currentTime().elapsed();
-#endif    
-        QCoreApplication::postEvent(this, ncEvent);
-#endif // NC_COALESCE_EVENTS
-    } else {
-    
-        // Create the QEvent to send
-        NCEvent* ncEvent = new NCEvent(inEvent);
+    void* args[2] = { 0, const_cast<Event*>(&inEvent) };
+    QMetaObject::activate(this, &mMetaObject, index, args);
+    return connected;
+}
 
-    #ifdef DEBUG
-        // Stamp the event with the start time
-        ncEvent->mTime = QTime::currentTime().elapsed();
-    #endif    
-    
-        // Process all events in the queue.
-        QCoreApplication::sendPostedEvents();
-        
-        // Now post the event synchronously and wait for return.
-        QCoreApplication::sendEvent(this, ncEvent);
 
-        // Delete the event.
-        delete ncEvent;
-    }    
+//-----------------------------------------------------------------------------
+// NotificationCenter::metaObject()
+//
+/// The meta object with the event signals.
+//-----------------------------------------------------------------------------
+const QMetaObject*
+NotificationCenter::metaObject() const
+{
+    return &mMetaObject;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::postEvent()
+// NotificationCenter::qt_metacast()
+//-----------------------------------------------------------------------------
+void*
+NotificationCenter::qt_metacast(const char* inClassName)
+{
+    if (inClassName != NULL && qstrcmp(inClassName, kMetaClassName) == 0)
+        return static_cast<void*>(this);
+
+    return QObject::qt_metacast(inClassName);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::qt_metacall()
 //
-/// Post an event to the notification center event queue. 
-//  The event must be allocated on the heap as the
-/// event queue will take ownership of the event. 
-/// Events are processed in the order that they are posted.
-/// The event priority can be any value between INT_MAX and INT_MIN.
-/// \param inEvent A pointer to an event object.
-/// \param inPriority The priority in which the event will be handled.
-/// \param inPostType The type in which to post the event.
+/// Invoking an event signal through the meta object emits it, as it does
+/// for moc generated signals.
 //-----------------------------------------------------------------------------
-void
-NotificationCenter::postEvent(Event* inEvent, 
-                              PostPriority inPriority,
-                              PostType inPostType)
+int
+NotificationCenter::qt_metacall(QMetaObject::Call inCall, int inIndex, void** inArgs)
 {
-    Q_ASSERT(inEvent != NULL);
-    Q_ASSERT(inPostType != POST_NOW);
+    inIndex = QObject::qt_metacall(inCall, inIndex, inArgs);
+    if (inIndex < 0)
+        return inIndex;
 
-    if (mDebugOutput) {
-        LOG_INFO("NotificationCenter Manager: postEvent() ----> "
-                  << "EventId: "   << inEvent->id
-                  << " Priority: " << inPriority
-                  << " PostType: " << inPostType);
+    if (inCall == QMetaObject::InvokeMetaMethod) {
+        if (inIndex < mEventSignals.size()) {
+            QMetaObject::activate(this, &mMetaObject, inIndex, inArgs);
+        }
+        inIndex -= mEventSignals.size();
     }
-#ifdef NC_COALESCE_EVENTS
-    mCoalesceList.push_back(qMakePair(inEvent, inPriority));
-#else
-    // Create the QEvent to send
-    NCEvent* theEvent = new NCEvent(inEvent);
 
-#ifdef DEBUG
-    // Stamp the event with the start time
-    theEvent->mTime = QTime::currentTime().elapsed();
-#endif    
-    QCoreApplication::postEvent(this, theEvent, inPriority);
-#endif // NC_COALESCE_EVENTS
+    return inIndex;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::connectToQtSlot()
+// NotificationCenter::connectNotify()
 //
-/// Connect the event ID to the callback.
-/// \param inId The event ID used to make the connection.
-/// \param inReceiver The object that owns the slot.
-/// \param inSlot The callback to be signalled.
-/// \param inName The name (doesn't appear to do anything).
+/// Note the event signals connected with QObject::connect(), so typed
+/// and lazy events fill their dictionary for them.
+/// \param inSignal The signal, with its SIGNAL() code in front.
 //-----------------------------------------------------------------------------
-ConnectionId
-NotificationCenter::connect(const EventId& inId, 
-                            QObject* inReceiver, 
-                            const char* inSlot, 
-                            const std::string& inName)
+void
+NotificationCenter::connectNotify(const char* inSignal)
 {
-    Q_UNUSED(inName);
-    
-    if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::connect() trying to connect qt slot ----> "
-                      << "EventId: " << inId
-                      << "     "
-                      << "StringId: " << inId.getStringId().toStdString());
-    }
+    QObject::connectNotify(inSignal);
 
-    // Save the id before we increment it.
-    int result = mConnectionIdCount;
+    if (inSignal == NULL || *inSignal == '\0')
+        return;
 
-    ConnectionInfo& infoRef = addConnectionInfo(CONNECTION_TYPE_QT, inId);
+    const int index = mMetaObject.indexOfSignal(inSignal + 1) - mMetaObject.methodOffset();
+    if (index >= 0 && index < mEventSignals.size()) {
+        mEventSignals[index].connected = true;
+    }
+}
 
-    // Create the event string. We append the event signature to the string
-    // used to create the EventId.
-    infoRef.qtSignal = inId.getStringId() + kSignalSignature;
 
-    // Store the slot info
-    infoRef.qtMethod = inSlot;
+//-----------------------------------------------------------------------------
+// NotificationCenter::disconnectNotify()
+//
+/// Note the event signals whose last receiver connected with
+/// QObject::connect() went away through QObject::disconnect(). Qt does
+/// not report receivers that are destroyed, so their signal is still
+/// taken as connected.
+/// \param inSignal The signal, with its SIGNAL() code in front.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::disconnectNotify(const char* inSignal)
+{
+    QObject::disconnectNotify(inSignal);
 
-    // Store the QObject
-    infoRef.qtObject = inReceiver;
+    if (inSignal == NULL || *inSignal == '\0')
+        return;
 
-    // Try to locate the EventId in the registry.
-    EventRegistry::iterator iter = mEventRegistry.find(inId.getHash());
-    if (iter == mEventRegistry.end()) {
-        addDeferredEvent(inId, infoRef);
-    } else {
-        if (!connectQtEvent(inId, infoRef)) {
+    const int index = mMetaObject.indexOfSignal(inSignal + 1) - mMetaObject.methodOffset();
+    if (index >= 0 && index < mEventSignals.size()) {
+        mEventSignals[index].connected = receivers(inSignal) > 0;
+    }
+}
 
-            // Remove the info from the map.
-            mConnectionMap.remove(mConnectionIdCount - 1);
 
-            result = NotificationCenter::INVALID_CONNECTION_ID;
-        }
-    }
+//-----------------------------------------------------------------------------
+// NotificationCenter::event()
+//
+/// Internal notification center event handling. If the event is in the
+/// UserEvent space, we attempt to handle it.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::event(QEvent* inEvent)
+{
+    bool result = false;
 
-    // Send a notification about the connection
-    Event* event = new Event(EventConnected);
-    event->dictionary["id"] = inId.mStringId;
-    event->dictionary["type"] = QString("CONNECTION_TYPE_QT");
-    postEvent(event);            
+    if (inEvent->type() >= QEvent::User) {
+        result = handleCustomEvent(inEvent);
+    } else {
+        result = QObject::event(inEvent);
+    }
 
     return result;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::connect()
+// callPythonMethod()
 //
-/// Connect the event ID to the callback.
-/// \param inId The event ID used to make the connection.
-/// \param inCallback The callback to be signalled.
-/// \param inName The name (doesn't appear to do anything).
+/// Call a bound python method with the dictionary of the event. The
+/// caller holds the GIL.
 //-----------------------------------------------------------------------------
-ConnectionId
-NotificationCenter::connect(const EventId& inId, 
-                            EventCallbackType inCallback, 
-                            const std::string& inName)
+static void
+callPythonMethod(PyObject* inMethod, const Event& inEvent)
 {
-    Q_UNUSED(inName);
+    PyObject* dict = QtForPython_DictionaryToPython(inEvent.dictionary);
+    PyObject* arglist = NULL;
+    if (dict == NULL) {
+        LOG_ERROR(inEvent.id.getStringId().toStdString() <<
+                  " : event dictionary can not be translated to python ");
+        arglist = PyTuple_New(1);
+        PyTuple_SetItem(arglist, 0, PyDict_New());
+    } else {
+        // Create the argument list, place dict in tuple
+        arglist = Py_BuildValue("(O)", dict);
+    }
     
-   if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::connect() trying to connect boost callback ----> "
-                      << "EventId: " << inId);
+    Q_ASSERT(arglist != NULL);
+        
+    // Attempt to call the callback
+    PyObject* pyResult = PyEval_CallObject(inMethod, arglist);
+    if (pyResult == NULL && PyErr_Occurred()) {
+        //Error is handled here because there may be no higher
+        //handler for notification callback
+        PyErr_Print();
+        PyErr_Clear();
     }
+    
+    Py_XDECREF(pyResult);
 
-    // Save the id before we increment it.
-    const int result = mConnectionIdCount;
-
-    // Set up the connection info
-    ConnectionInfo& infoRef = addConnectionInfo(CONNECTION_TYPE_BOOST, inId);
-
-    // Try to locate the EventId in the registry.
-    EventRegistry::iterator iter = mEventRegistry.find(inId.getHash());
-    if (iter == mEventRegistry.end()) {
-        infoRef.boostCallbackType = inCallback;
-        addDeferredEvent(inId, infoRef);
-    } else {
-        // This event is located in the registry.  This means it has a good chance of
-        // being invoked by someone, so we can connect the signals.
+    // We are done with the argument
+    Py_DECREF(arglist);
+    Py_XDECREF(dict);
+}
 
-        // Check for and connect any deferred events
-        checkForAndConnectDeferredEvents(inId);
 
-        // We will either find a signal or create a new one to connect to.
-        EventCallbackRefType signal;
 
-        // Check and see if we already have callbacks attached to this event ID.
-        EventMap::const_iterator eventIter = mEvents.find(inId);
-        if (eventIter == mEvents.end()) {
-            // There are no boost callbacks yet attached.  We need to create the
-            // signal to be connected to.
-            signal = EventCallbackRefType(new EventCallbackSignal());
+//-----------------------------------------------------------------------------
+// struct QtSlotCallback
+//
+/// Calls a keyed Qt slot as an EventCallbackType.
+//-----------------------------------------------------------------------------
+struct QtSlotCallback
+{
+    QtSlotCallback(const QtSlotInvoker& inInvoker)
+        :   mInvoker(inInvoker)
+    {
+    }
+
+    void operator()(const Event& inEvent) const
+    {
+        void* args[2] = { 0, const_cast<Event*>(&inEvent) };
+        mInvoker(args);
+    }
+
+    QtSlotInvoker mInvoker;
+};
+
+
+//-----------------------------------------------------------------------------
+// struct PythonCallback
+//
+/// Calls a keyed python callable as an EventCallbackType.
+//-----------------------------------------------------------------------------
+struct PythonCallback
+{
+    PythonCallback(const PythonInvokerRef& inInvoker)
+        :   mInvoker(inInvoker)
+    {
+    }
+
+    void operator()(const Event& inEvent) const
+    {
+#ifndef DISABLE_PYTHON
+        python_gil::GilState gilstate;
+        (*mInvoker)(inEvent);
+#else
+        Q_UNUSED(inEvent);
+#endif
+    }
+
+    PythonInvokerRef mInvoker;
+};
+
+#ifndef DISABLE_PYTHON
+//-----------------------------------------------------------------------------
+// NotificationCenter::callPythonFunctor()
+//-----------------------------------------------------------------------------
+struct callPythonFunctor
+{
+    callPythonFunctor(const Event* inEvent)
+        :   mEvent(inEvent)
+    {
+    }
+
+    void operator()(const PythonFunctionInfoRef& inPythonFunctionInfo)
+    {
+        // Skip callables disconnected earlier in this dispatch.
+        if (inPythonFunctionInfo->connected && inPythonFunctionInfo->isValid()) {
+            // Create the puthon method from the saved properties.
+            PyObject* pyMethod = PyMethod_New(inPythonFunctionInfo->functionMethod,
+                                              inPythonFunctionInfo->functionSelf,
+                                              inPythonFunctionInfo->functionClass);
+            if (pyMethod != NULL) {
+                NC_TRACE_SCOPE_ARG(TRACE_LISTENER_BEGIN, TRACE_LISTENER_END,
+                                   mEvent->id.getHash(), inPythonFunctionInfo->connection, CONNECTION_TYPE_PYTHON);
+                ListenerTimer timer(inPythonFunctionInfo->profile.get());
+                callPythonMethod(pyMethod, *mEvent);
+
+                // We are done with the method
+                Py_DECREF(pyMethod);
+            }
+        }
+    }
+
+    const Event* mEvent;
+};
+#endif
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::handleCustomEvent()
+//
+/// Internal notification center event handling.
+///
+/// We take the event out of the QEvent passed in and dispatch it.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::handleCustomEvent(QEvent* inQtEvent)
+{
+    // We only care about a single type of custom event.
+    if (inQtEvent->type() != kNCEventType)
+        return false;
+
+    // Get the NotificationCenter event out of the QEvent
+#ifdef DEBUG
+    NCEvent* customEvent = dynamic_cast<NCEvent *>(inQtEvent);
+    Q_ASSERT(customEvent != NULL);
+#else
+    NCEvent* customEvent = static_cast<NCEvent *>(inQtEvent);
+#endif
+
+    const Event* event = customEvent->getEvent();
+    if (event == NULL) {
+        // No custom event data.
+        return false;
+    }
+
+    EventLatency* latency = latencyFor(event->id.getHash());
+    if (latency != NULL) {
+        latency->queue.record(monotonicNanoseconds() - customEvent->postTime());
+    }
+
+    // The counters of an event released while it was queued are gone.
+    EventStatisticsMap::iterator statisticsIter = mEventStatistics.find(event->id.getHash());
+    if (statisticsIter != mEventStatistics.end()) {
+        ++statisticsIter.value().dequeued;
+    }
+
+    // Copies posted from now on are queued again.
+    if (event->contentHash != 0) {
+        releaseContent(*event);
+    }
+
+    dispatchEvent(*event, customEvent->cycleHistory());
+
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::dispatchEvent()
+//
+/// Call the listeners of an event and record how long they took.
+/// \param inEvent The event to deliver.
+/// \param inHistory The path of the cascade a queued event continues,
+/// NULL for other events.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::dispatchEvent(const Event& inEvent, const CycleHistory* inHistory)
+{
+    NC_TRACE_SCOPE_ARG(TRACE_DISPATCH_BEGIN, TRACE_DISPATCH_END, inEvent.id.getHash(), 0, inEvent.serial);
+
+    // State events are delivered with their changes, in the order they
+    // are dispatched, and not at all if nothing changed.
+    StateEventMap::iterator stateIter = mStateEvents.find(inEvent.id.getHash());
+    if (stateIter != mStateEvents.end() && !takeStateChanges(inEvent, stateIter.value())) {
+        ++statisticsFor(inEvent.id).unchanged;
+        return;
+    }
+
+    ++statisticsFor(inEvent.id).dispatched;
+
+    // Kept before the listeners run, so those connecting from them
+    // receive this event. Late listeners of a state event need all of
+    // the state rather than the last changes.
+    StickyEventMap::iterator stickyIter = mStickyEvents.find(inEvent.id.getHash());
+    if (stickyIter != mStickyEvents.end()) {
+        stickyIter.value() = StickyEventRef(inEvent.clone());
+        if (stateIter != mStateEvents.end()) {
+            stickyIter.value()->dictionary = stateIter.value();
+        }
+    }
+
+    const quint64 start = monotonicNanoseconds();
+    beginCascade(inEvent, start, inHistory);
+    deliverEvent(inEvent);
+
+    // Listeners may have dispatched other events, so look the entry up
+    // only now.
+    const quint64 end = monotonicNanoseconds();
+    EventLatency* latency = latencyFor(inEvent.id.getHash());
+    if (latency != NULL) {
+        latency->dispatch.record(end - start);
+    }
+    endCascade(end);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::deliverEvent()
+//
+/// Call the listeners of an event.
+///
+/// We take the event ID and check for connected boost and Qt slots.
+/// If we find either, we manually invoke the signal.
+/// \param inEvent The event to deliver.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::deliverEvent(const Event& inEvent)
+{
+    // Qt connections made to the signal of the event.
+    const bool signalled = emitEventSignal(inEvent);
+
+    // Nobody listens, so there is nothing to look up. Receivers of the
+    // signal are listeners too.
+    if (!mayHaveListeners(inEvent.id.getHash())) {
+        if (!signalled) {
+            ++mEventStatistics[inEvent.id.getHash()].dropped;
+        }
+        return;
+    }
+
+    // A sealed center dispatches from its compiled plans. After a topology
+    // change they are recompiled, but never under a running dispatch.
+    if (mSealed && mPlansStale && !isDispatching()) {
+        compileDispatchPlans();
+    }
+
+    if (mSealed && !mPlansStale) {
+        DispatchPlanMap::const_iterator planIter = mDispatchPlans.constFind(inEvent.id.getHash());
+        if (planIter != mDispatchPlans.constEnd()) {
+            DispatchScope scope(this);
+            if (planIter.value().needsDictionary) {
+                inEvent.ensureDictionary();
+            }
+            dispatchPlan(planIter.value(), inEvent);
+
+            // Keyed listeners are not part of the plan.
+            if (inEvent.hasKey) {
+                EventMap::const_iterator eventIter = mEvents.constFind(inEvent.id.getHash());
+                if (eventIter != mEvents.constEnd()) {
+                    dispatchKeyed(eventIter.value(), inEvent);
+                }
+            }
+        }
+    } else {
+        // We get the event type and attempt to retrieve the event
+        // registration info.  The info will contain a list of all
+        // connected boost::slots and all connected Qt::slots.
+        EventMap::const_iterator eventIter = mEvents.constFind(inEvent.id.getHash());
+        if (eventIter != mEvents.constEnd()) {
+
+            // Listeners that connect or disconnect from their callbacks only
+            // queue the change, so the entry stays put until we return.
+            DispatchScope scope(this);
+            const EventCallbackInfo& callbackInfo = eventIter.value();
+
+            // Typed events only build their dictionary for listeners
+            // that read it.
+            if (needsDictionary(callbackInfo)) {
+                inEvent.ensureDictionary();
+            }
+
+            // Handle the boost signals
+            if (callbackInfo.boostSignal && !callbackInfo.boostSignal->empty()) {
+                emitCallbacks(*callbackInfo.boostSignal, inEvent);
+            }
+
+            // Handle the Qt slots
+            if (!callbackInfo.qtInvokers.isEmpty()) {
+                emitQtSlots(callbackInfo.qtInvokers, inEvent);
+            }
+
+#ifndef DISABLE_PYTHON
+            if (!callbackInfo.pythonFunctionList.empty()) {
+                TimedGilState gilstate(latencyFor(inEvent.id.getHash()));
+                // Handle the python callables
+                std::for_each(callbackInfo.pythonFunctionList.begin(),
+                              callbackInfo.pythonFunctionList.end(),
+                              callPythonFunctor(&inEvent));
+            }
+#endif
+
+            // Handle the listeners of the key
+            if (inEvent.hasKey) {
+                dispatchKeyed(callbackInfo, inEvent);
+            }
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::sendEvent()
+//
+/// Dispatch a caller owned event synchronously. Unlike posting with
+/// POST_NOW, the event is neither copied nor wrapped in a QEvent, so it
+/// can live on the stack. Events already posted to the center are
+/// delivered first, as they are for POST_NOW.
+///
+/// From another thread the event is cloned and posted instead, as it can
+/// only be dispatched on the thread of the center.
+/// \param inEvent The event to deliver.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::sendEvent(const Event& inEvent)
+{
+    NC_TRACE(TRACE_SEND, inEvent.id.getHash(), 0);
+
+    if (QThread::currentThread() != thread()) {
+        postEvent(inEvent.clone(), POST_SOON);
+        return;
+    }
+
+    // The changes of a state event replace its dictionary, so a copy is
+    // dispatched and the event of the caller is left alone.
+    const Event* event = &inEvent;
+    QScopedPointer<Event> changes;
+    if (isStateEvent(inEvent.id)) {
+        changes.reset(inEvent.clone());
+        event = changes.data();
+    }
+
+    if (!admitEvent(*event, false))
+        return;
+
+    // Process the events in the queue.
+    QCoreApplication::sendPostedEvents(this, kNCEventType);
+
+    dispatchEvent(*event);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::postEvent()
+//
+/// Helper method to create an event and post the event
+/// using just an EventId. This is useful if you are posting
+/// an event with no dictionary entries.
+/// \param inId The EventId to create an event for.
+/// \param inPostType The type in which to post the event.
+/// \sa PostType.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::postEvent(const EventId& inId, PostType inPostType)
+{
+	postEvent(new Event(inId), inPostType);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::postEvent()
+//
+/// Helper method to create an event and post the event
+/// using just an EventId. This is useful if you are posting
+/// an event with no dictionary entries.
+/// \param inEvent A pointer to an event object.
+/// \param inPriority The priority in which the event will be handled.
+/// \param inPostType The type in which to post the event.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::postEvent(const EventId& inId,
+                              PostPriority inPriority,
+                              PostType inPostType)
+{
+	postEvent(new Event(inId), inPriority, inPostType);
+}
+
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::postEvent()
+//
+/// Post an event to the notification center event queue. 
+//  The event must be allocated on the heap as the
+/// event queue will take ownership of the event. 
+/// Events are processed in the order that they are posted.
+/// If the event is posted with a post type of POST_NOW,
+/// all events in the queue will be posted and then
+/// the event will be posted synchronously.
+/// \param inEvent A pointer to an event object.
+/// \param inPostType The type in which to post the event.
+/// \sa PostType.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::postEvent(Event* inEvent, PostType inPostType)
+{
+    Q_ASSERT(inEvent != NULL);
+
+    QThread* currentThread = QThread::currentThread();
+    QThread* receiverThread = this->thread();
+    const bool queued = (inPostType == POST_SOON || currentThread != receiverThread);
+
+    // The duplicate check comes last, as it records the event in the table
+    // of queued events.
+    if (!admitEvent(*inEvent, queued) || (queued && isDuplicate(*inEvent))) {
+        delete inEvent;
+        return;
+    }
+
+    NC_TRACE_ARG(inPostType == POST_NOW ? TRACE_POST_NOW : TRACE_POST, inEvent->id.getHash(), 0, inEvent->serial);
+
+    countPost(*inEvent, queued);
+
+    if (queued) {
+        queueEvent(inEvent, PRIORITY_NORMAL);
+    } else {
+        // Process all events in the queue.
+        QCoreApplication::sendPostedEvents();
+        
+        // Now dispatch the event synchronously. It never enters the Qt
+        // event queue, so it needs no QEvent wrapper.
+        dispatchEvent(*inEvent);
+
+        // Delete the event.
+        delete inEvent;
+    }    
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::postEvent()
+//
+/// Post an event to the notification center event queue. 
+//  The event must be allocated on the heap as the
+/// event queue will take ownership of the event. 
+/// Events are processed in the order that they are posted.
+/// The event priority can be any value between INT_MAX and INT_MIN.
+/// \param inEvent A pointer to an event object.
+/// \param inPriority The priority in which the event will be handled.
+/// \param inPostType The type in which to post the event.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::postEvent(Event* inEvent, 
+                              PostPriority inPriority,
+                              PostType inPostType)
+{
+    Q_ASSERT(inEvent != NULL);
+    Q_ASSERT(inPostType != POST_NOW);
+    Q_UNUSED(inPostType);
+
+    if (!admitEvent(*inEvent, true) || isDuplicate(*inEvent)) {
+        delete inEvent;
+        return;
+    }
+
+    NC_TRACE_ARG(TRACE_POST, inEvent->id.getHash(), 0, inEvent->serial);
+
+    countPost(*inEvent, true);
+    queueEvent(inEvent, inPriority);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::queueEvent()
+//
+/// Wrap a posted event in a QEvent and queue it, or hold it back for the
+/// coalescing timer. An event continuing the cascade of the dispatch that
+/// posted it takes the path of that cascade along, and keeps the cascade
+/// open until it is dispatched or deleted.
+/// \param inEvent The event. Ownership is passed to the queue.
+/// \param inPriority The priority in which the event will be handled.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::queueEvent(Event* inEvent, PostPriority inPriority)
+{
+    NCEvent* ncEvent = new NCEvent(this, inEvent);
+    if (inEvent->rootSerial != inEvent->serial) {
+        ncEvent->setCycleHistory(cycleHistory());
+        ++mCascadeTrees[inEvent->rootSerial].queued;
+    }
+
+#ifdef NC_COALESCE_EVENTS
+    mCoalesceList.push_back(qMakePair(ncEvent, inPriority));
+#else
+    QCoreApplication::postEvent(this, ncEvent, inPriority);
+#endif // NC_COALESCE_EVENTS
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::postEvent()
+//
+/// Post an event whose dictionary is built by inBuilder. The builder is
+/// called when the event is dispatched, and only if a listener that
+/// reads the dictionary is connected by then.
+/// \param inId The EventId to create an event for.
+/// \param inBuilder Fills the dictionary of the event.
+/// \param inPostType The type in which to post the event.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::postEvent(const EventId& inId,
+                              const EventPayloadBuilder& inBuilder,
+                              PostType inPostType)
+{
+    postEvent(new LazyEvent(inId, inBuilder), inPostType);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::postEvent()
+//
+/// Post an event whose dictionary is built by inBuilder, with a priority.
+/// \param inId The EventId to create an event for.
+/// \param inBuilder Fills the dictionary of the event.
+/// \param inPriority The priority in which the event will be handled.
+/// \param inPostType The type in which to post the event.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::postEvent(const EventId& inId,
+                              const EventPayloadBuilder& inBuilder,
+                              PostPriority inPriority,
+                              PostType inPostType)
+{
+    postEvent(new LazyEvent(inId, inBuilder), inPriority, inPostType);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::hasListeners()
+//
+/// Check if anything is connected to an event, so publishers can skip
+/// building a payload nobody reads. A bucket of a counting filter is
+/// checked first, which answers most misses with a single load. From
+/// another thread only the filter is consulted. Its buckets are atomic,
+/// so the answer may be a false positive, or miss a connection being made
+/// at the same time, but it never reads a torn count.
+/// \param inId The EventId to check.
+/// \result True if the event has live connections.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::hasListeners(const EventId& inId) const
+{
+    const unsigned int eventHash = inId.getHash();
+    if (!mayHaveListeners(eventHash))
+        return false;
+
+    if (QThread::currentThread() != thread())
+        return true;
+
+    return mEvents.contains(eventHash);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connectToQtSlot()
+//
+/// Connect the event ID to the callback.
+/// \param inId The event ID used to make the connection.
+/// \param inReceiver The object that owns the slot.
+/// \param inSlot The callback to be signalled.
+/// \param inName The name of the listener in profiling reports.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::connect(const EventId& inId, 
+                            QObject* inReceiver, 
+                            const char* inSlot, 
+                            const std::string& inName)
+{
+    // Store the QObject and the slot info. Connections to the same slot
+    // share one copy of its normalized signature.
+    QtConnectionInfo qtInfo;
+    qtInfo.receiver = inReceiver;
+    qtInfo.slot = internString(QMetaObject::normalizedSignature(inSlot));
+
+    return addQtConnection(inId, qtInfo, inName);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connect()
+//
+/// Connect the event ID to a callback that lives as long as a Qt object.
+/// This is how member functions of Qt receivers are connected without a
+/// slot signature, and functors can use their owner as the context. The
+/// callback is called from the thread of the context object and is
+/// skipped once the object is destroyed.
+/// \param inId The event ID used to make the connection.
+/// \param inContext The object that owns the callback.
+/// \param inCallback The callback to be signalled.
+/// \param inName The name of the listener in profiling reports.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::connect(const EventId& inId,
+                            QObject* inContext,
+                            EventCallbackType inCallback,
+                            const std::string& inName)
+{
+    Q_ASSERT(inContext != NULL);
+
+    QtConnectionInfo qtInfo;
+    qtInfo.receiver = inContext;
+    qtInfo.callback = inCallback;
+
+    return addQtConnection(inId, qtInfo, inName);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::addQtConnection()
+//
+/// Add a Qt connection and attach it, or defer it until its event is
+/// registered or the current dispatch returns.
+/// \param inId The event ID used to make the connection.
+/// \param inInfo The receiver and its slot or callback.
+/// \param inName The name of the listener in profiling reports.
+/// \result The id of the new connection, or INVALID_CONNECTION_ID.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::addQtConnection(const EventId& inId, const QtConnectionInfo& inInfo, const std::string& inName)
+{
+    ConnectionId result = addConnectionInfo(CONNECTION_TYPE_QT, inId, inName);
+    mQtConnections.insert(result, inInfo);
+
+    // Try to locate the EventId in the registry.
+    if (!mEventRegistry.contains(inId.getHash())) {
+        addDeferredEvent(inId, result);
+    } else if (isDispatching()) {
+        // The slot is connected once the dispatch returns.
+        mPendingChanges.push_back(PendingChange(PENDING_ATTACH, inId, result));
+    } else {
+        if (!connectQtEvent(inId, result)) {
+
+            // Remove the info from the map.
+            removeConnectionInfo(result);
+
+            result = NotificationCenter::INVALID_CONNECTION_ID;
+        }
+    }
+
+    // Send a notification about the connection
+    Event* event = new Event(EventConnected);
+    event->dictionary[kIdKey] = inId.mStringId;
+    event->dictionary[kTypeKey] = QString("CONNECTION_TYPE_QT");
+    postEvent(event);            
+
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connect()
+//
+/// Connect the event ID to the callback.
+/// \param inId The event ID used to make the connection.
+/// \param inCallback The callback to be signalled.
+/// \param inName The name of the listener in profiling reports.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::connect(const EventId& inId, 
+                            EventCallbackType inCallback, 
+                            const std::string& inName)
+{
+    return connectCallback(inId, inCallback, false, inName);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connectCallback()
+//
+/// Connect a callback to the event ID. Shared by untyped and typed
+/// listeners.
+/// \param inId The event ID used to make the connection.
+/// \param inCallback The callback to be signalled.
+/// \param inTyped True for a TypedCallback, which does not read the
+/// dictionary of the event.
+/// \param inName The name of the listener in profiling reports.
+/// \result The id of the new connection.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::connectCallback(const EventId& inId,
+                                    const EventCallbackType& inCallback,
+                                    bool inTyped,
+                                    const std::string& inName)
+{
+    // Set up the connection info
+    const ConnectionId result = addConnectionInfo(CONNECTION_TYPE_BOOST, inId, inName);
+    mBoostConnections[result].typed = inTyped;
+
+    // Try to locate the EventId in the registry.
+    if (!mEventRegistry.contains(inId.getHash())) {
+        // Hold on to the callback until the event shows up.
+        mDeferredCallbacks.insert(result, inCallback);
+        addDeferredEvent(inId, result);
+    } else if (isDispatching()) {
+        // Hold on to the callback until the dispatch returns.
+        mDeferredCallbacks.insert(result, inCallback);
+        mPendingChanges.push_back(PendingChange(PENDING_ATTACH, inId, result));
+    } else {
+        // This event is located in the registry.  This means it has a good chance of
+        // being invoked by someone, so we can connect the signals.
+
+        // Check for and connect any deferred events
+        checkForAndConnectDeferredEvents(inId);
+
+        // Attach the callback to the signal
+        connectBoostEvent(inId, result, inCallback);
+    }
+
+    // Send a notification about the connection
+    Event* event = new Event(EventConnected);
+    event->dictionary[kIdKey] = inId.mStringId;
+    event->dictionary[kTypeKey] = QString("CONNECTION_TYPE_BOOST");
+    postEvent(event);
+
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connect()
+//
+/// Connect the event ID to the callback.
+/// \param inId The string ID used to make the connection.
+/// \param inObject The python object to be called.
+/// \param inName The name of the listener in profiling reports.
+//-----------------------------------------------------------------------------
+ConnectionId NotificationCenter::connect(const QString& inId,
+                                         PyObject* inObject,
+                                         const std::string& inName)
+{
+    EventId eId(inId);
+    return connect(eId, inObject, inName);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connect()
+//
+/// Connect the event ID to the callback.
+/// \param inId The event ID used to make the connection.
+/// \param inObject The python object to be called.
+/// \param inName The name of the listener in profiling reports.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::connect(const EventId& inId, 
+                            PyObject* inObject, 
+                            const std::string& inName)
+{
+    Q_ASSERT(inObject != NULL);
+
+    const bool named = !mListenerProfiling || inName != DEFAULT_CALLBACK_NAME;
+    ConnectionId result = addConnectionInfo(CONNECTION_TYPE_PYTHON, inId,
+                                            named ? inName : pythonCallableName(inObject));
+
+    // Verify that this is a callable object
+    if (PyCallable_Check(inObject)) {
+
+        // Save the elements need to call the function at a later time
+        mPythonConnections[result].function = PythonFunctionInfoRef(new PythonFunctionInfo(inObject));
+
+        // Try to locate the EventId in the registry.
+        if (!mEventRegistry.contains(inId.getHash())) {
+            addDeferredEvent(inId, result);
+        } else {
+            // Add the python object to the list of the event, once the
+            // dispatch returns if we are in one.
+            if (isDispatching()) {
+                mPendingChanges.push_back(PendingChange(PENDING_ATTACH, inId, result));
+            } else {
+                connectPythonEvent(inId, result);
+            }
+
+            // Send a notification about the connection
+            Event* event = new Event(EventConnected);
+            event->dictionary[kIdKey] = inId.mStringId;
+            event->dictionary[kTypeKey] = QString("CONNECTION_TYPE_PYTHON");
+            postEvent(event);
+        }
+    } else {
+        // Not callable
+        if (mDebugOutput) {
+            LOG_ERROR("NotificationCenter::connect() python object not callable ----> "
+                      << "EventId:" << inId);
+        }
+
+        // Remove the info from the map.
+        removeConnectionInfo(result);
+
+        result = NotificationCenter::INVALID_CONNECTION_ID;
+    }
+
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connect()
+//
+/// Connect a Qt slot to one key of a parametric event. The receiver must
+/// live in the thread of the Notification Center.
+/// \param inId The event ID used to make the connection.
+/// \param inKey The key the slot listens to.
+/// \param inReceiver The object that owns the slot.
+/// \param inSlot The callback to be signalled.
+/// \param inName The name of the listener in profiling reports.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::connect(const EventId& inId,
+                            quint64 inKey,
+                            QObject* inReceiver,
+                            const char* inSlot,
+                            const std::string& inName)
+{
+    Q_ASSERT(inReceiver != NULL);
+
+    const ConnectionId result = addConnectionInfo(CONNECTION_TYPE_QT, inId, inName);
+    mKeyedConnections.insert(result, inKey);
+
+    QtConnectionInfo& qtInfo = mQtConnections[result];
+    qtInfo.receiver = inReceiver;
+    qtInfo.slot = internString(QMetaObject::normalizedSignature(inSlot));
+
+    return addKeyedConnection(inId, result);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connect()
+//
+/// Connect a callback to one key of a parametric event.
+/// \param inId The event ID used to make the connection.
+/// \param inKey The key the callback listens to.
+/// \param inCallback The callback to be signalled.
+/// \param inName The name of the listener in profiling reports.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::connect(const EventId& inId,
+                            quint64 inKey,
+                            EventCallbackType inCallback,
+                            const std::string& inName)
+{
+    const ConnectionId result = addConnectionInfo(CONNECTION_TYPE_BOOST, inId, inName);
+    mKeyedConnections.insert(result, inKey);
+
+    // Hold on to the callback until it is attached.
+    mDeferredCallbacks.insert(result, inCallback);
+
+    return addKeyedConnection(inId, result);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connect()
+//
+/// Connect a python callable to one key of a parametric event.
+/// \param inId The event ID used to make the connection.
+/// \param inKey The key the callable listens to.
+/// \param inObject The python object to be called.
+/// \param inName The name of the listener in profiling reports.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::connect(const EventId& inId,
+                            quint64 inKey,
+                            PyObject* inObject,
+                            const std::string& inName)
+{
+    Q_ASSERT(inObject != NULL);
+
+    // Verify that this is a callable object
+    if (!PyCallable_Check(inObject)) {
+        if (mDebugOutput) {
+            LOG_ERROR("NotificationCenter::connect() python object not callable ----> "
+                      << "EventId:" << inId);
+        }
+        return NotificationCenter::INVALID_CONNECTION_ID;
+    }
+
+    const bool named = !mListenerProfiling || inName != DEFAULT_CALLBACK_NAME;
+    const ConnectionId result = addConnectionInfo(CONNECTION_TYPE_PYTHON, inId,
+                                                  named ? inName : pythonCallableName(inObject));
+    mKeyedConnections.insert(result, inKey);
+    mPythonConnections[result].function = PythonFunctionInfoRef(new PythonFunctionInfo(inObject));
+
+    return addKeyedConnection(inId, result);
+}
+
+
+/*
+[TODO] How to do a bulk disconnect of all EventId?
+//-----------------------------------------------------------------------------
+// NotificationCenter::disconnect()
+//
+/// Disconnect all callbacks attached to the event ID.
+/// \param inId The event ID used to disconnect.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::disconnect(const EventId& inId)
+{
+    EventCallbackRefType signal;
+    EventMap::iterator iter = mEvents.find(inId);
+    if (iter != mEvents.end()) {
+        signal = iter.value();
+        signal->disconnect_all_slots();
+    }
+}
+*/
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::disconnect()
+//
+/// Disconnect all callbacks attached to the event ID.
+/// \param inId The connection ID that will be disconnected.
+//
+// NOTE: Removing the last connection frees the per-event callback state.
+// The event itself stays registered until every registerEvent() has been
+// balanced by unregisterEvent(). See releaseEventIfUnused().
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::disconnect(const ConnectionId& inId)
+{
+    // Check all the connections, both deferred and live.
+    ConnectionMap::const_iterator iter = mConnectionMap.constFind(inId);
+    if (iter == mConnectionMap.constEnd()) {
+        // There is no information for this ConnectionId.
+        if (mDebugOutput) {
+            LOG_WARN("NotificationCenter::disconnect() Connection information not found ----> "
+                     << "ConnectionId:" << inId);
+        }
+        return;
+    }
+
+    const ConnectionInfo connectionInfo = iter.value();
+    const EventId eventId = eventIdForHash(connectionInfo.eventHash);
+
+    // Send a notification about the disconnection once we are done.
+    Event* event = new Event(EventDisconnected);
+    event->dictionary[kIdKey] = eventId.mStringId;
+    event->dictionary[kTypeKey] = connectionTypeToString(connectionInfo.type);
+
+    // Check the deferred connection list first
+    DeferredEventMap::iterator deferIter = mDeferredEvents.find(connectionInfo.eventHash);
+    if (deferIter != mDeferredEvents.end()) {
+
+        DeferredCallbackList& deferredList = deferIter.value().connections;
+        if (deferredList.removeOne(inId)) {
+
+            // Nobody is waiting for the event any longer.
+            if (deferredList.isEmpty()) {
+                mDeferredEvents.erase(deferIter);
+            }
+
+            // A deferred connection was never attached to an event, so
+            // we are done once its info is gone.
+            removeConnectionInfo(inId);
+            postEvent(event);
+            return;
+        }
+    }
+
+    // Then the connections made during the current dispatch
+    for (int index = 0; index < mPendingChanges.size(); ++index) {
+        const PendingChange& change = mPendingChanges.at(index);
+        if (change.type == PENDING_ATTACH && change.connection == inId) {
+
+            mPendingChanges.removeAt(index);
+            removeConnectionInfo(inId);
+            postEvent(event);
+            return;
+        }
+    }
+
+    // Get the EventCallbackInfo structure that contains all
+    // of the connections related to it.
+    EventMap::iterator eventIter = mEvents.find(connectionInfo.eventHash);
+    if (eventIter == mEvents.end()) {
+        // There is no information for this ConnectionId.
+        if (mDebugOutput) {
+            LOG_WARN("NotificationCenter::disconnect() Event information not found ----> "
+                     << "EventId:" << eventId.mStringId
+                     << " "
+                     << inId);
+        }
+        removeConnectionInfo(inId);
+        postEvent(event);
+        return;
+    }
+
+    // Get the event callback info
+    const EventCallbackInfo& eventCallbackInfo = eventIter.value();
+    PythonFunctionInfoRef pythonFunction;
+
+    // A sealed plan or keyed listeners being dispatched check their
+    // connections from now on.
+    ++mDisconnectCount;
+
+    // Keyed listeners are wrapped in callbacks, there is no transport
+    // connection to break.
+    KeyedConnectionMap::const_iterator keyIter = mKeyedConnections.constFind(inId);
+    const bool keyed = (keyIter != mKeyedConnections.constEnd());
+    const quint64 key = keyed ? keyIter.value() : 0;
+
+    // Break the connection based on connection type.
+    switch (keyed ? CONNECTION_TYPE_NONE : connectionInfo.type) {
+    case CONNECTION_TYPE_NONE:
+        break;
+
+    case CONNECTION_TYPE_BOOST: {
+        const BoostConnectionInfo boostInfo = mBoostConnections.value(inId);
+        if (eventCallbackInfo.boostSignal) {
+            eventCallbackInfo.boostSignal->disconnect(boostInfo.connection);
+        }
+        if (boostInfo.typed) {
+            --eventIter.value().typedListenerCount;
+        }
+    }
+    break;
+
+    case CONNECTION_TYPE_QT: {
+        // Only this slot is released, by detachListener(). The other
+        // slots of the event keep their own connections.
+    }
+    break;
+
+    case CONNECTION_TYPE_PYTHON: {
+        // The event shares the function info with the connection. Mark
+        // it so a dispatch in progress skips it, the list entry itself
+        // is removed by detachListener().
+        pythonFunction = mPythonConnections.value(inId).function;
+        pythonFunction->connected = false;
+    }
+    break;
+
+    default:
+        break;
+    };
+
+    // Remove the info from the connection tables
+    removeConnectionInfo(inId);
+
+    // Release the listener from the event, or have the outermost
+    // dispatch do it if callbacks are running.
+    PendingChange detach(PENDING_DETACH, eventId, inId, pythonFunction);
+    detach.keyed = keyed;
+    detach.key = key;
+
+    if (isDispatching()) {
+        mPendingChanges.push_back(detach);
+    } else {
+        detachListener(detach);
+    }
+
+    postEvent(event);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::disconnect()
+//
+/// Disconnect all connections in the list.
+/// The list passed in will be cleared on return.
+/// \param inList A ConnectionList of connections to disconnect.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::disconnect(ConnectionList& inList)
+{
+    ConnectionList::iterator iter = inList.begin();
+    for ( ; iter != inList.end(); ++iter) {
+        disconnect(*iter); 
+    }
+    
+    inList.clear();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::addDeferredEvent()
+//
+/// Add events for EventId's not yet registered.
+/// \param inId The EventId to defer.
+/// \param inConnection The connection waiting for the event.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::addDeferredEvent(const EventId& inId, ConnectionId inConnection)
+{
+    // We were unable to find the event in the active event registry.
+    // Check and see if we already have the EventId in the deferred queue.
+    DeferredEventMap::iterator deferIter = mDeferredEvents.find(inId.getHash());
+    if (deferIter == mDeferredEvents.end()) {
+        DeferredEventInfo deferredInfo;
+        deferredInfo.eventId = inId;
+        deferredInfo.connections.push_back(inConnection);
+        mDeferredEvents.insert(inId.getHash(), deferredInfo);
+    }
+    else {
+        // There is already a deferred event to add the callback to.
+        deferIter.value().connections.push_back(inConnection);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::addListener()
+//
+/// Count a live connection of an event.
+/// \param ioInfo The callback info of the event.
+/// \param inEventHash The hash of the EventId.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::addListener(EventCallbackInfo& ioInfo, unsigned int inEventHash)
+{
+    ++ioInfo.listenerCount;
+    mListenerFilter[inEventHash & (kListenerFilterSize - 1)].ref();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::removeListener()
+//
+/// Release a live connection from the event. The callback state of the
+/// event is freed along with its last listener.
+/// \param inEventHash The hash of the EventId the connection was attached to.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::removeListener(unsigned int inEventHash)
+{
+    EventMap::iterator eventIter = mEvents.find(inEventHash);
+    if (eventIter == mEvents.end())
+        return;
+
+    mListenerFilter[inEventHash & (kListenerFilterSize - 1)].deref();
+    if (--eventIter.value().listenerCount > 0)
+        return;
+
+    // Drop the signal and callback lists. They are recreated by the
+    // next connection.
+    mEvents.erase(eventIter);
+
+    releaseEventIfUnused(inEventHash);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::releaseEventIfUnused()
+//
+/// Remove an event from the registry once it has neither publishers nor
+/// listeners, and make its event type available for reuse. Everything
+/// else kept for the event goes with it: its counters, latency and
+/// cascade statistics, its last sticky event and state, and whether it
+/// is deduplicated or dispatched in parallel.
+/// \param inEventHash The hash of the EventId to release.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::releaseEventIfUnused(unsigned int inEventHash)
+{
+    if (mPublisherCounts.contains(inEventHash) || mEvents.contains(inEventHash))
+        return;
+
+    EventRegistry::iterator iter = mEventRegistry.find(inEventHash);
+    if (iter == mEventRegistry.end())
+        return;
+
+    if (mDebugOutput) {
+        LOG_INFO("NotificationCenter::releaseEventIfUnused() releasing event ----> "
+                  << "EventId: " << iter.value());
+    }
+
+    const QString stringId = iter.value().getStringId();
+    mFreeEventTypes.push_back(iter.value().getEventType());
+    mEventRegistry.erase(iter);
+
+    // The signal is handed to another event once it has no receivers.
+    const int signalIndex = mSignalIndices.value(inEventHash, -1);
+    if (signalIndex >= 0) {
+        mReleasedSignals.push_back(signalIndex);
+    }
+
+    mEventStatistics.remove(inEventHash);
+    mLatencies.remove(inEventHash);
+    mCascadeStatistics.remove(inEventHash);
+    mStickyEvents.remove(inEventHash);
+    mStateEvents.remove(inEventHash);
+    mParallelEvents.remove(inEventHash);
+    mDispatchPlans.remove(inEventHash);
+
+    {
+        QMutexLocker locker(&mPostMutex);
+        mDeduplicatedEvents.remove(inEventHash);
+        mDeduplicatedCount = mDeduplicatedEvents.size();
+        mRetiredPostCounters.remove(inEventHash);
+
+        Q_FOREACH(const PostCounterShardRef& shard, mPostCounterShardList) {
+            QMutexLocker shardLocker(&shard->mutex);
+            shard->counters.remove(inEventHash);
+        }
+    }
+
+    // Send a notification about the event going away.
+    Event* event = new Event(EventUnregistered);
+    event->dictionary[kIdKey] = stringId;
+    postEvent(event);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::addConnectionInfo()
+//
+/// Set up some boilerplate info based on connection type.
+/// \param inType The ConnectionType.
+/// \param inId The EventId the connection is made to.
+/// \param inName The name of the listener in profiling reports.
+/// \result The id of the new connection.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::addConnectionInfo(ConnectionType inType, const EventId& inId, const std::string& inName)
+{
+    // Save the connection info for this connection ID
+    mConnectionMap.insert(mConnectionIdCount, ConnectionInfo(inId.getHash(), inType));
+    NC_TRACE(TRACE_CONNECT, inId.getHash(), mConnectionIdCount);
+
+    EventStatistics& statistics = statisticsFor(inId);
+    switch (inType) {
+    case CONNECTION_TYPE_BOOST:     ++statistics.boostConnections;  break;
+    case CONNECTION_TYPE_QT:        ++statistics.qtConnections;     break;
+    case CONNECTION_TYPE_PYTHON:    ++statistics.pythonConnections; break;
+    default:                        break;
+    }
+
+    if (inName != DEFAULT_CALLBACK_NAME) {
+        mListenerNames.insert(mConnectionIdCount, QString::fromStdString(inName));
+    }
+    if (mListenerProfiling) {
+        addListenerProfile(mConnectionIdCount, ConnectionInfo(inId.getHash(), inType));
+    }
+
+    return mConnectionIdCount++;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::removeConnectionInfo()
+//
+/// Remove a connection from the connection table and from the table
+/// of its ConnectionType.
+/// \param inId The connection to remove.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::removeConnectionInfo(ConnectionId inId)
+{
+    ConnectionMap::iterator iter = mConnectionMap.find(inId);
+    if (iter == mConnectionMap.end())
+        return;
+
+    NC_TRACE(TRACE_DISCONNECT, iter.value().eventHash, inId);
+    mListenerProfiles.remove(inId);
+    mListenerNames.remove(inId);
+
+    EventStatistics& statistics = mEventStatistics[iter.value().eventHash];
+    switch (iter.value().type) {
+    case CONNECTION_TYPE_BOOST:     --statistics.boostConnections;  break;
+    case CONNECTION_TYPE_QT:        --statistics.qtConnections;     break;
+    case CONNECTION_TYPE_PYTHON:    --statistics.pythonConnections; break;
+    default:                        break;
+    }
+    if (mKeyedConnections.contains(inId)) {
+        --statistics.keyedConnections;
+    }
+
+    switch (iter.value().type) {
+    case CONNECTION_TYPE_BOOST:
+        mBoostConnections.remove(inId);
+        mDeferredCallbacks.remove(inId);
+        break;
+
+    case CONNECTION_TYPE_QT:
+        mQtConnections.remove(inId);
+        break;
+
+    case CONNECTION_TYPE_PYTHON:
+        mPythonConnections.remove(inId);
+        break;
+
+    default:
+        break;
+    }
+
+    mKeyedConnections.remove(inId);
+    mConnectionMap.erase(iter);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::statisticsFor()
+//
+/// Return the counters of an event, creating them the first time. Only
+/// call from the thread of the Notification Center.
+/// \param inId The event.
+/// \result The counters of the event.
+//-----------------------------------------------------------------------------
+EventStatistics&
+NotificationCenter::statisticsFor(const EventId& inId)
+{
+    EventStatistics& statistics = mEventStatistics[inId.getHash()];
+    if (statistics.stringId.isEmpty()) {
+        statistics.stringId = inId.getStringId();
+    }
+    return statistics;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::latencyFor()
+//
+/// Return the latency of an event to record into. Only registered events
+/// and events with listeners are timed, so dispatching events that are
+/// neither allocates nothing. Only call from the thread of the
+/// Notification Center.
+/// \param inEventHash The hash of the EventId.
+/// \result The latency of the event, or NULL if it is not timed.
+//-----------------------------------------------------------------------------
+EventLatency*
+NotificationCenter::latencyFor(unsigned int inEventHash)
+{
+    EventLatencyMap::iterator iter = mLatencies.find(inEventHash);
+    if (iter != mLatencies.end())
+        return &iter.value();
+
+    if (!mEventRegistry.contains(inEventHash) && !mEvents.contains(inEventHash))
+        return NULL;
+
+    return &mLatencies[inEventHash];
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::countPost()
+//
+/// Count a posted event in the counters of the posting thread.
+/// \param inEvent The posted event.
+/// \param inQueued Whether the event goes through the event queue.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::countPost(const Event& inEvent, bool inQueued)
+{
+    PostCounterShard* shard = postCounterShard();
+    QMutexLocker locker(&shard->mutex);
+    EventPostCounters& counters = shard->counters[inEvent.id.getHash()];
+    ++counters.posted;
+    if (inQueued) {
+        ++counters.queued;
+#ifdef NC_COALESCE_EVENTS
+        ++counters.coalesced;
+#endif
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::countDuplicate()
+//
+/// Count a posted event dropped by isDuplicate().
+/// \param inEvent The posted event.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::countDuplicate(const Event& inEvent)
+{
+    PostCounterShard* shard = postCounterShard();
+    QMutexLocker locker(&shard->mutex);
+    EventPostCounters& counters = shard->counters[inEvent.id.getHash()];
+    ++counters.posted;
+    ++counters.deduplicated;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::postCounterShard()
+//
+/// Return the post counters of the current thread, creating them on its
+/// first post. Only then is mPostMutex taken, to add the shard to the
+/// list and fold the shards of finished threads into the retired
+/// counters.
+//-----------------------------------------------------------------------------
+PostCounterShard*
+NotificationCenter::postCounterShard()
+{
+    PostCounterShardRef* shard = mPostCounterShards.localData();
+    if (shard == NULL) {
+        QMutexLocker locker(&mPostMutex);
+
+        // Finished threads released their reference with their storage.
+        for (int index = mPostCounterShardList.size() - 1; index >= 0; --index) {
+            const PostCounterShardRef& finished = mPostCounterShardList.at(index);
+            if (finished.use_count() > 1)
+                continue;
+
+            EventPostCounterMap::const_iterator iter = finished->counters.constBegin();
+            for ( ; iter != finished->counters.constEnd(); ++iter) {
+                EventPostCounters& retired = mRetiredPostCounters[iter.key()];
+                retired.posted += iter.value().posted;
+                retired.queued += iter.value().queued;
+                retired.coalesced += iter.value().coalesced;
+                retired.deduplicated += iter.value().deduplicated;
+            }
+            mPostCounterShardList.removeAt(index);
+        }
+
+        shard = new PostCounterShardRef(new PostCounterShard());
+        mPostCounterShardList.push_back(*shard);
+        mPostCounterShards.setLocalData(shard);
+    }
+    return shard->get();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::postCounters()
+//
+/// Add up the post counters of every thread.
+/// \result The counters by EventId hash.
+//-----------------------------------------------------------------------------
+EventPostCounterMap
+NotificationCenter::postCounters() const
+{
+    QMutexLocker locker(&mPostMutex);
+    EventPostCounterMap result = mRetiredPostCounters;
+    Q_FOREACH(const PostCounterShardRef& shard, mPostCounterShardList) {
+        QMutexLocker shardLocker(&shard->mutex);
+        EventPostCounterMap::const_iterator iter = shard->counters.constBegin();
+        for ( ; iter != shard->counters.constEnd(); ++iter) {
+            EventPostCounters& counters = result[iter.key()];
+            counters.posted += iter.value().posted;
+            counters.queued += iter.value().queued;
+            counters.coalesced += iter.value().coalesced;
+            counters.deduplicated += iter.value().deduplicated;
+        }
+    }
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::isDuplicate()
+//
+/// Check a deduplicated event about to be queued against the events of
+/// its id still waiting in the queue. The content hash is computed once
+/// and kept on the event until it is dispatched. Unless it is a copy, the
+/// event is recorded in the table, so it must be queued afterwards.
+/// Called from any thread.
+/// \param inEvent The event about to be queued.
+/// \result True if an equal event is queued, the caller drops the copy.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::isDuplicate(const Event& inEvent)
+{
+    // Most centers deduplicate nothing, and posting takes no lock then.
+    if (mDeduplicatedCount == 0)
+        return false;
+
+    const unsigned int eventHash = inEvent.id.getHash();
+    {
+        QMutexLocker locker(&mPostMutex);
+        if (!mDeduplicatedEvents.contains(eventHash))
+            return false;
+    }
+
+    // Lazy and typed events are compared by their dictionary, so it is
+    // built now rather than at dispatch. The builder runs unlocked.
+    inEvent.ensureDictionary();
+
+    uint contentHash = eventHash ^ inEvent.dictionary.contentHash();
+    if (inEvent.hasKey) {
+        contentHash ^= qHash(inEvent.key) * 31;
+    }
+    if (contentHash == 0) {
+        contentHash = 1;                        // 0 marks events that are not tracked
+    }
+
+    QMutexLocker locker(&mPostMutex);
+    QMultiHash<uint, const Event*>::const_iterator iter = mQueuedContent.constFind(contentHash);
+    for ( ; iter != mQueuedContent.constEnd() && iter.key() == contentHash; ++iter) {
+        const Event* queued = iter.value();
+        if (queued->id == inEvent.id && queued->hasKey == inEvent.hasKey && queued->key == inEvent.key
+                && queued->dictionary == inEvent.dictionary) {
+            locker.unlock();
+            countDuplicate(inEvent);
+            return true;
+        }
+    }
+
+    inEvent.contentHash = contentHash;
+    mQueuedContent.insert(contentHash, &inEvent);
+    return false;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::takeStateChanges()
+//
+/// Replace the dictionary of a state event about to be dispatched with
+/// its changes from the current state, and make it the state. Changes are
+/// taken at dispatch, so they follow the order in which listeners see
+/// them whatever thread posted the events, and refused events never
+/// touch the state.
+/// \param inEvent The event about to be dispatched.
+/// \param ioState The current state of the event.
+/// \result False if the event changes nothing.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::takeStateChanges(const Event& inEvent, EventDictionary& ioState)
+{
+    inEvent.ensureDictionary();
+
+    const EventDictionary changes = inEvent.dictionary.changesFrom(ioState);
+    if (changes.isEmpty())
+        return false;
+
+    ioState = inEvent.dictionary;
+    inEvent.dictionary = changes;
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::releaseContent()
+//
+/// Forget a deduplicated event taken out of the queue, either to be
+/// dispatched or because it is deleted undispatched. Called from any
+/// thread.
+/// \param inEvent The event leaving the queue.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::releaseContent(const Event& inEvent)
+{
+    QMutexLocker locker(&mPostMutex);
+    mQueuedContent.remove(inEvent.contentHash, &inEvent);
+    inEvent.contentHash = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::eventIdForHash()
+//
+/// Look up the EventId of a connection. Live connections belong to
+/// registered events, deferred connections to deferred events.
+/// \param inHash The hash of the EventId.
+/// \result The EventId, or an empty EventId if the hash is unknown.
+//-----------------------------------------------------------------------------
+EventId
+NotificationCenter::eventIdForHash(unsigned int inHash) const
+{
+    EventRegistry::const_iterator iter = mEventRegistry.constFind(inHash);
+    if (iter != mEventRegistry.constEnd())
+        return iter.value();
+
+    DeferredEventMap::const_iterator deferIter = mDeferredEvents.constFind(inHash);
+    if (deferIter != mDeferredEvents.constEnd())
+        return deferIter.value().eventId;
+
+    return EventId();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::internString()
+//
+/// Return the shared copy of a string. Slot signatures are repeated by
+/// many connections, so they are stored once.
+/// \param inString The string to intern.
+/// \result The interned string.
+//-----------------------------------------------------------------------------
+const QByteArray&
+NotificationCenter::internString(const QByteArray& inString)
+{
+    StringPool::const_iterator iter = mStringPool.constFind(inString);
+    if (iter == mStringPool.constEnd())
+        iter = mStringPool.insert(inString);
+
+    return *iter;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::checkForAndConnectDeferredEvents()
+//
+/// Connect all deferred signals for the EventId
+/// \param inId The EventId to connect deferred events to.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::checkForAndConnectDeferredEvents(const EventId& inId)
+{
+    // Check and see if the event is in the deferred list. If so, we can
+    // remove it and move it over to the active event list.
+    DeferredEventMap::iterator deferIter = mDeferredEvents.find(inId.getHash());
+    if (deferIter == mDeferredEvents.end())
+        return;
+
+    if (isDispatching()) {
+        // Leave the connections deferred until the dispatch returns.
+        mPendingChanges.push_back(PendingChange(PENDING_RESOLVE_DEFERRED, inId));
+        return;
+    }
+
+    if (mDebugOutput) {
+        LOG_INFO("NotificationCenter::checkForAndConnectDeferredEvents() found deferred event ----> "
+                  << "EventId:" << inId);
+    }
+
+    // We found a deferred event. Take the list of callbacks waiting
+    // to be connected and remove the deferred item. It is now in the
+    // active list.
+    const DeferredCallbackList callbackList = deferIter.value().connections;
+    mDeferredEvents.erase(deferIter);
+
+    // Connect the deferred callbacks
+    DeferredCallbackList::const_iterator callbackIter = callbackList.begin();
+    for ( ; callbackIter != callbackList.end(); ++callbackIter) {
+        const ConnectionId connectionId = *callbackIter;
+
+        if (attachConnection(inId, connectionId)) {
+            if (mDebugOutput) {
+                    LOG_INFO("NotificationCenter::checkForAndConnectDeferredEvents() connecting deferred event ----> "
+                              << "EventId:" << inId
+                              << " "
+                              << "ConnectionId:" << connectionId);
+            }
+        } else {
+            if (mDebugOutput) {
+                LOG_ERROR("NotificationCenter::checkForAndConnectDeferredEvents() failed to connect deferred event ----> "
+                          << "EventId:" << inId
+                          << " "
+                          << "ConnectionId:" << connectionId);
+            }
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// struct NotificationCenter::DispatchScope
+//
+/// Marks a dispatch in progress. Topology changes made inside the scope
+/// are queued and applied when the outermost scope closes.
+//-----------------------------------------------------------------------------
+struct NotificationCenter::DispatchScope
+{
+    DispatchScope(NotificationCenter* inCenter)
+        :   mCenter(inCenter)
+    {
+        ++mCenter->mDispatchDepth;
+    }
+
+    ~DispatchScope()
+    {
+        if (--mCenter->mDispatchDepth == 0 && !mCenter->mPendingChanges.isEmpty()) {
+            mCenter->commitPendingChanges();
+        }
+    }
+
+    NotificationCenter* mCenter;
+};
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::attachConnection()
+//
+/// Attach a connection to a registered event based on its ConnectionType.
+/// A connection that can not be made is removed.
+/// \param inId The EventId to connect to.
+/// \param inConnection The connection to attach.
+/// \result True if the connection was attached.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::attachConnection(const EventId& inId, ConnectionId inConnection)
+{
+    if (mKeyedConnections.contains(inConnection)) {
+        if (connectKeyedEvent(inId, inConnection))
+            return true;
+
+        removeConnectionInfo(inConnection);
+        return false;
+    }
+
+    switch (mConnectionMap.value(inConnection).type) {
+    case CONNECTION_TYPE_BOOST:
+        connectBoostEvent(inId, inConnection, mDeferredCallbacks.take(inConnection));
+        return true;
+
+    case CONNECTION_TYPE_QT:
+        if (connectQtEvent(inId, inConnection))
+            return true;
+        break;
+
+    case CONNECTION_TYPE_PYTHON:
+        connectPythonEvent(inId, inConnection);
+        return true;
+
+    default:
+        break;
+    }
+
+    // The connection can never be made, so don't keep it.
+    removeConnectionInfo(inConnection);
+    return false;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::detachListener()
+//
+/// Release a disconnected listener from its event.
+/// \param inChange The PENDING_DETACH change of the listener.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::detachListener(const PendingChange& inChange)
+{
+    EventMap::iterator eventIter = mEvents.find(inChange.eventId.getHash());
+    if (eventIter != mEvents.end()) {
+        EventCallbackInfo& callbackInfo = eventIter.value();
+
+        if (inChange.keyed) {
+            KeyedListenerMap::iterator keyIter = callbackInfo.keyedListeners.find(inChange.key);
+            if (keyIter != callbackInfo.keyedListeners.end()) {
+                KeyedListenerList& listeners = keyIter.value();
+                for (int index = 0; index < listeners.size(); ++index) {
+                    if (listeners.at(index).connection == inChange.connection) {
+                        listeners.remove(index);
+                        break;
+                    }
+                }
+
+                if (listeners.isEmpty()) {
+                    callbackInfo.keyedListeners.erase(keyIter);
+                }
+            }
+        } else if (inChange.pythonFunction) {
+            callbackInfo.pythonFunctionList.removeOne(inChange.pythonFunction);
+        } else {
+            QtSlotInvokerList& invokers = callbackInfo.qtInvokers;
+            for (int index = 0; index < invokers.size(); ++index) {
+                if (invokers.at(index).connection == inChange.connection) {
+                    invokers.remove(index);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Free the event state if this was the last listener.
+    removeListener(inChange.eventId.getHash());
+
+    topologyChanged();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::commitPendingChanges()
+//
+/// Apply the topology changes queued during a dispatch, in the order
+/// they were made.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::commitPendingChanges()
+{
+    Q_ASSERT(!isDispatching());
+
+    // Nothing is queued while we are not dispatching, so one pass
+    // applies everything.
+    const PendingChangeList changes = mPendingChanges;
+    mPendingChanges.clear();
+
+    Q_FOREACH(const PendingChange& change, changes) {
+        switch (change.type) {
+        case PENDING_ATTACH:
+            // The event may have been unregistered during the dispatch.
+            if (mEventRegistry.contains(change.eventId.getHash())) {
+                attachConnection(change.eventId, change.connection);
+            } else {
+                addDeferredEvent(change.eventId, change.connection);
+            }
+            break;
+
+        case PENDING_DETACH:
+            detachListener(change);
+            break;
+
+        case PENDING_RESOLVE_DEFERRED:
+            checkForAndConnectDeferredEvents(change.eventId);
+            break;
+
+        case PENDING_SEAL:
+            seal();
+            break;
+
+        case PENDING_UNSEAL:
+            unseal();
+            break;
+        }
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::seal()
+//
+/// Compile the current topology into flat per-event dispatch plans.
+/// The callback signal and the Qt slots of an event are shared with it
+/// and python methods are bound once. A later connect() or disconnect()
+/// recompiles the plans before the next dispatch, so sealing never
+/// changes which listeners are called.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::seal()
+{
+    if (isDispatching()) {
+        mPendingChanges.push_back(PendingChange(PENDING_SEAL, EventId()));
+        return;
+    }
+
+    mSealed = true;
+    compileDispatchPlans();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::unseal()
+//
+/// Drop the dispatch plans and return to the generic dispatch path.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::unseal()
+{
+    if (isDispatching()) {
+        mPendingChanges.push_back(PendingChange(PENDING_UNSEAL, EventId()));
+        return;
+    }
+
+    mSealed = false;
+    mPlansStale = false;
+    mDispatchPlans.clear();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::compileDispatchPlans()
+//
+/// Build a DispatchPlan for every event with live listeners.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::compileDispatchPlans()
+{
+    Q_ASSERT(!isDispatching());
+
+    mDispatchPlans.clear();
+    mDispatchPlans.reserve(mEvents.size());
+
+    EventMap::const_iterator eventIter = mEvents.constBegin();
+    for ( ; eventIter != mEvents.constEnd(); ++eventIter) {
+        const EventCallbackInfo& callbackInfo = eventIter.value();
+        DispatchPlan& plan = mDispatchPlans[eventIter.key()];
+        plan.needsDictionary = needsDictionary(callbackInfo);
+
+        if (callbackInfo.boostSignal && !callbackInfo.boostSignal->empty()) {
+            plan.boostSignal = callbackInfo.boostSignal;
+        }
+
+        // Shared with the event until either changes.
+        plan.qtInvokers = callbackInfo.qtInvokers;
+
+#ifndef DISABLE_PYTHON
+        if (!callbackInfo.pythonFunctionList.isEmpty()) {
+            python_gil::GilState gilstate;
+            plan.pythonInvokers.reserve(callbackInfo.pythonFunctionList.size());
+            Q_FOREACH(const PythonFunctionInfoRef& function, callbackInfo.pythonFunctionList) {
+                plan.pythonInvokers.push_back(PythonInvokerRef(new PythonInvoker(function)));
+            }
+        }
+#endif
+    }
+
+    mPlansStale = false;
+
+    if (mDebugOutput) {
+        LOG_INFO("NotificationCenter::compileDispatchPlans() compiled ----> "
+                  << "plans: " << mDispatchPlans.size());
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::dispatchPlan()
+//
+/// Call the listeners of a compiled plan, in the order of the generic path.
+/// \param inPlan The plan of the event.
+/// \param inEvent The event to deliver.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::dispatchPlan(const DispatchPlan& inPlan, const Event& inEvent)
+{
+    // Handle the boost signals
+    if (inPlan.boostSignal) {
+        emitCallbacks(*inPlan.boostSignal, inEvent);
+    }
+
+    // Handle the Qt slots
+    if (!inPlan.qtInvokers.isEmpty()) {
+        emitQtSlots(inPlan.qtInvokers, inEvent);
+    }
+
+#ifndef DISABLE_PYTHON
+    // Handle the python callables
+    if (!inPlan.pythonInvokers.isEmpty()) {
+        TimedGilState gilstate(latencyFor(inEvent.id.getHash()));
+        const PythonInvokerRef* invoker = inPlan.pythonInvokers.constData();
+        const PythonInvokerRef* end = invoker + inPlan.pythonInvokers.size();
+        for ( ; invoker != end; ++invoker) {
+            (**invoker)(inEvent);
+        }
+    }
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+// class FanOutPartition
+//
+/// A range of the callback listeners of a parallel event, run on the
+/// global thread pool.
+//-----------------------------------------------------------------------------
+class FanOutPartition : public QRunnable
+{
+public:
+    FanOutPartition(const EventCallbackSignal& inSignal,
+                    const Event& inEvent,
+                    int inBegin,
+                    int inEnd,
+                    bool inObserved,
+                    const ListenerProfileMap* inProfiles,
+                    QSemaphore& inDone)
+        :   mSignal(inSignal),
+            mEvent(inEvent),
+            mBegin(inBegin),
+            mEnd(inEnd),
+            mObserved(inObserved),
+            mProfiles(inProfiles),
+            mDone(inDone)
+    {
+    }
+
+    virtual void run()
+    {
+        if (mObserved) {
+            mSignal.emitRangeScoped<CallbackScope>(mEvent, mProfiles, mBegin, mEnd);
+        } else {
+            mSignal.emitRange(mEvent, mBegin, mEnd);
+        }
+        mDone.release();
+    }
+
+private:
+    const EventCallbackSignal& mSignal;
+    const Event& mEvent;
+    int mBegin;
+    int mEnd;
+    bool mObserved;
+    const ListenerProfileMap* mProfiles;
+    QSemaphore& mDone;
+};
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::setParallelDispatch()
+//
+/// Let the callback listeners of an event run in parallel. Once an event
+/// has more than kParallelPartitionSize callbacks they are split in
+/// contiguous partitions, one per core, and all but the first are run on
+/// the global QThreadPool while the dispatching thread runs the first.
+/// The dispatch returns when every partition is done.
+///
+/// Only callback listeners are affected. Qt slots keep the thread of
+/// their receiver and python callables the GIL.
+///
+/// The callbacks of a parallel event must be thread safe and must not
+/// call back into the Notification Center, which is not.
+/// \param inId The EventId.
+/// \param inEnabled True to allow parallel dispatch.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::setParallelDispatch(const EventId& inId, bool inEnabled)
+{
+    if (inEnabled) {
+        mParallelEvents.insert(inId.getHash());
+    } else {
+        mParallelEvents.remove(inId.getHash());
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::emitCallbacks()
+//
+/// Call the callback listeners of an event, in partitions on the thread
+/// pool if the event allows it and has enough listeners. While tracing is
+/// on every call is recorded, and while listeners are profiled every call
+/// is timed, whenever the listeners were connected.
+/// \param ioSignal The callback signal of the event.
+/// \param inEvent The event to deliver.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::emitCallbacks(EventCallbackSignal& ioSignal, const Event& inEvent)
+{
+#ifndef NC_DISABLE_TRACE
+    const bool traced = NotificationTrace::isEnabled();
+#else
+    const bool traced = false;
+#endif
+    const ListenerProfileMap* profiles = mListenerProfiling ? &mListenerProfiles : NULL;
+    const bool observed = traced || profiles != NULL;
+
+    const int slotCount = ioSignal.slotCount();
+    const int partitionCount = qMin(QThread::idealThreadCount(), slotCount / kParallelPartitionSize);
+    if (partitionCount < 2 || !mParallelEvents.contains(inEvent.id.getHash())) {
+        if (observed) {
+            ioSignal.emitScoped<CallbackScope>(inEvent, profiles);
+        } else {
+            ioSignal(inEvent);
+        }
+        return;
+    }
+
+    // Holds the slots in place until every partition is done.
+    EventCallbackSignal::Emission emission(ioSignal);
+    QSemaphore done;
+
+    const int partitionSize = (slotCount + partitionCount - 1) / partitionCount;
+    for (int begin = partitionSize; begin < slotCount; begin += partitionSize) {
+        QThreadPool::globalInstance()->start(new FanOutPartition(ioSignal,
+                                                                 inEvent,
+                                                                 begin,
+                                                                 qMin(begin + partitionSize, slotCount),
+                                                                 observed,
+                                                                 profiles,
+                                                                 done));
+    }
+
+    if (observed) {
+        ioSignal.emitRangeScoped<CallbackScope>(inEvent, profiles, 0, partitionSize);
+    } else {
+        ioSignal.emitRange(inEvent, 0, partitionSize);
+    }
+
+    done.acquire((slotCount - 1) / partitionSize);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::dispatchKeyed()
+//
+/// Call the listeners connected to the key of a parametric event.
+/// \param inInfo The callback info of the event.
+/// \param inEvent The event to deliver.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::dispatchKeyed(const EventCallbackInfo& inInfo, const Event& inEvent)
+{
+    KeyedListenerMap::const_iterator keyIter = inInfo.keyedListeners.constFind(inEvent.key);
+    if (keyIter == inInfo.keyedListeners.constEnd())
+        return;
+
+    // The list is not updated until the dispatch returns, so once a
+    // listener disconnects anything each listener is checked first.
+    const unsigned int disconnectCount = mDisconnectCount;
+    const KeyedListenerList& listeners = keyIter.value();
+    const KeyedListener* listener = listeners.constData();
+    const KeyedListener* end = listener + listeners.size();
+    for ( ; listener != end; ++listener) {
+        if (mDisconnectCount != disconnectCount && !mConnectionMap.contains(listener->connection))
+            continue;
+
+        // Python invokers record and time their own calls.
+        if (listener->type == CONNECTION_TYPE_PYTHON) {
+            listener->callback(inEvent);
+        } else {
+            NC_TRACE_SCOPE_ARG(TRACE_LISTENER_BEGIN, TRACE_LISTENER_END,
+                               inEvent.id.getHash(), listener->connection, listener->type);
+            ListenerTimer timer(listenerProfile(listener->connection));
+            listener->callback(inEvent);
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connectBoostEvent()
+//
+/// Attach a boost callback to the signal of a registered event. The
+/// signal is created with the first boost connection of the event.
+/// \param inId The EventId to connect to.
+/// \param inConnection The connection being made.
+/// \param inCallback The callback to attach.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::connectBoostEvent(const EventId& inId,
+                                      ConnectionId inConnection,
+                                      const EventCallbackType& inCallback)
+{
+    EventCallbackInfo& callbackInfo = mEvents[inId.getHash()];
+    if (!callbackInfo.boostSignal) {
+        callbackInfo.boostSignal = EventCallbackRefType(new EventCallbackSignal());
+    }
+
+    BoostConnectionInfo& boostInfo = mBoostConnections[inConnection];
+    boostInfo.connection = callbackInfo.boostSignal->connect(inCallback, inConnection);
+    addListener(callbackInfo, inId.getHash());
+    const bool typed = boostInfo.typed;
+    if (typed) {
+        ++callbackInfo.typedListenerCount;
+    }
+
+    topologyChanged();
+
+    // The listener starts from the current state of a sticky event. The
+    // reference keeps the event alive if the listener replaces it.
+    const StickyEventRef last = mStickyEvents.value(inId.getHash());
+    if (last) {
+        DispatchScope scope(this);
+        if (!typed) {
+            last->ensureDictionary();
+        }
+        inCallback(*last);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connectQtEvent()
+//
+/// Add a Qt slot to the slots of a registered event. The slot is looked
+/// up once here and called directly on dispatch.
+/// \param inId The EventId to connect to.
+/// \param inConnection The connection being made.
+/// \result True if connection was made.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::connectQtEvent(const EventId& inId, ConnectionId inConnection)
+{
+    bool result = false;
+
+    const QtConnectionInfo qtInfo = mQtConnections.value(inConnection);
+    const bool hasCallback = !qtInfo.callback.empty() && !qtInfo.receiver.isNull();
+    const int slotIndex = hasCallback ? -1 : resolveQtSlot(inId, qtInfo);
+    if (hasCallback || slotIndex >= 0) {
+
+        // Add the event to the events map, or find the entry other
+        // listener types created first.
+        EventCallbackInfo& callbackInfo = mEvents[inId.getHash()];
+        if (hasCallback) {
+            callbackInfo.qtInvokers.push_back(QtSlotInvoker(inConnection, qtInfo.receiver, qtInfo.callback));
+        } else {
+            callbackInfo.qtInvokers.push_back(QtSlotInvoker(inConnection, qtInfo.receiver, slotIndex));
+        }
+        const QtSlotInvoker invoker = callbackInfo.qtInvokers.last();
+
+        addListener(callbackInfo, inId.getHash());
+        result = true;
+
+        topologyChanged();
+
+        const StickyEventRef last = mStickyEvents.value(inId.getHash());
+        if (last) {
+            DispatchScope scope(this);
+            last->ensureDictionary();
+            emitQtSlots(QtSlotInvokerList() << invoker, *last);
+        }
+
+    } else {
+        if (mDebugOutput) {
+            LOG_INFO("NotificationCenter::connectQtEvent() failed ----> "
+                      << "EventId:" << inId
+                      << " "
+                      << "StringId:" << inId.getStringId().toStdString());
+        }
+    }
+
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connectPythonEvent()
+//
+/// Add a python callable to the function list of a registered event.
+/// \param inId The EventId to connect to.
+/// \param inConnection The connection being made.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::connectPythonEvent(const EventId& inId, ConnectionId inConnection)
+{
+    const PythonFunctionInfoRef function = mPythonConnections.value(inConnection).function;
+    function->connection = inConnection;
+    function->profile = mListenerProfiling ? mListenerProfiles.value(inConnection) : ListenerProfileRef();
+
+    EventCallbackInfo& callbackInfo = mEvents[inId.getHash()];
+    callbackInfo.pythonFunctionList.push_back(function);
+    addListener(callbackInfo, inId.getHash());
+
+    topologyChanged();
+
+#ifndef DISABLE_PYTHON
+    const StickyEventRef last = mStickyEvents.value(inId.getHash());
+    if (last) {
+        DispatchScope scope(this);
+        last->ensureDictionary();
+        python_gil::GilState gilstate;
+        callPythonFunctor(last.get())(function);
+    }
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::addKeyedConnection()
+//
+/// Attach a new keyed connection, or defer it until its event is
+/// registered or the current dispatch returns.
+/// \param inId The EventId to connect to.
+/// \param inConnection The keyed connection.
+/// \result The connection, or INVALID_CONNECTION_ID if it can not be made.
+//-----------------------------------------------------------------------------
+ConnectionId
+NotificationCenter::addKeyedConnection(const EventId& inId, ConnectionId inConnection)
+{
+    const ConnectionType type = mConnectionMap.value(inConnection).type;
+    const quint64 key = mKeyedConnections.value(inConnection);
+
+    ++statisticsFor(inId).keyedConnections;
+
+    if (!mEventRegistry.contains(inId.getHash())) {
+        addDeferredEvent(inId, inConnection);
+    } else if (isDispatching()) {
+        mPendingChanges.push_back(PendingChange(PENDING_ATTACH, inId, inConnection));
+    } else {
+        // Check for and connect any deferred events
+        checkForAndConnectDeferredEvents(inId);
+
+        if (!attachConnection(inId, inConnection)) {
+            return NotificationCenter::INVALID_CONNECTION_ID;
+        }
+    }
+
+    // Send a notification about the connection
+    Event* event = new Event(EventConnected);
+    event->dictionary[kIdKey] = inId.mStringId;
+    event->dictionary[kTypeKey] = connectionTypeToString(type);
+    event->dictionary[kKeyKey] = QVariant(static_cast<qulonglong>(key));
+    postEvent(event);
+
+    return inConnection;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::connectKeyedEvent()
+//
+/// Wrap a keyed connection in a callback and add it to the listeners
+/// of its key.
+/// \param inId The EventId to connect to.
+/// \param inConnection The keyed connection.
+/// \result True if the connection was made.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::connectKeyedEvent(const EventId& inId, ConnectionId inConnection)
+{
+    KeyedListener listener;
+    listener.connection = inConnection;
+    listener.type = mConnectionMap.value(inConnection).type;
+
+    switch (listener.type) {
+    case CONNECTION_TYPE_BOOST:
+        listener.callback = mDeferredCallbacks.take(inConnection);
+        break;
+
+    case CONNECTION_TYPE_QT: {
+        // Keyed slots are wrapped in a callback, which only calls
+        // receivers of this thread.
+        const QtConnectionInfo qtInfo = mQtConnections.value(inConnection);
+        const int slotIndex = resolveQtSlot(inId, qtInfo);
+        if (slotIndex < 0)
+            return false;
+
+        if (qtInfo.receiver->thread() != thread()) {
+            if (mDebugOutput) {
+                LOG_ERROR("NotificationCenter::connectKeyedEvent() receiver lives in another thread ----> "
+                          << "slot: " << qtInfo.slot.data());
+            }
+            return false;
+        }
+
+        listener.callback = QtSlotCallback(QtSlotInvoker(inConnection, qtInfo.receiver, slotIndex));
+    }
+    break;
+
+    case CONNECTION_TYPE_PYTHON: {
+#ifndef DISABLE_PYTHON
+        python_gil::GilState gilstate;
+#endif
+        const PythonFunctionInfoRef function = mPythonConnections.value(inConnection).function;
+        function->connection = inConnection;
+        function->profile = mListenerProfiling ? mListenerProfiles.value(inConnection) : ListenerProfileRef();
+
+        PythonInvokerRef invoker(new PythonInvoker(function));
+        listener.callback = PythonCallback(invoker);
+    }
+    break;
+
+    default:
+        return false;
+    }
+
+    const quint64 key = mKeyedConnections.value(inConnection);
+    EventCallbackInfo& callbackInfo = mEvents[inId.getHash()];
+    callbackInfo.keyedListeners[key].push_back(listener);
+    addListener(callbackInfo, inId.getHash());
+
+    topologyChanged();
+
+    // Only a last event posted with the key of the listener is delivered.
+    const StickyEventRef last = mStickyEvents.value(inId.getHash());
+    if (last && last->hasKey && last->key == key) {
+        DispatchScope scope(this);
+        last->ensureDictionary();
+        listener.callback(*last);
+    }
+
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::isValid()
+//
+/// Check the validity of a connection
+/// \param inId The ConnectionInfo to connect to check.
+/// \result True if the connection is valid.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::isValid(ConnectionId inId) const
+{
+    ConnectionMap::const_iterator iter = mConnectionMap.find(inId);
+    return iter != mConnectionMap.end();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::isDeferred()
+//
+/// Check the deferred status of a connection
+/// \param inId The ConnectionInfo to connect to check.
+/// \result True if the connection is connected but deferred.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::isDeferred(ConnectionId inId) const
+{
+    ConnectionMap::const_iterator iter = mConnectionMap.find(inId);
+    if (iter == mConnectionMap.end())
+        return false;
 
-            // Add the event to the events map.
-            mEvents[inId] = EventCallbackInfo(signal, "", PythonFunctionList());
-        } else {
-            // We found a signal that was previously created.
-            const EventCallbackInfo& callbackInfo = eventIter.value();
-            signal = callbackInfo.boostSignal;
-        }
+    return mDeferredEvents.contains(iter.value().eventHash);
+}
 
-        // Attach the callback to the signal
-        infoRef.boostId = signal->connect(inCallback);
-    }
 
-    if (mDebugOutput) {
-        LOG_INFO("NotificationCenter::connect() connecting boost callback ----> "
-                  << "EventId:" << inId
-                  << "     "
-                  << "ConnectionId:" << result);
-    }
-    
-    // Send a notification about the connection
-    Event* event = new Event(EventConnected);
-    event->dictionary["id"] = inId.mStringId;
-    event->dictionary["type"] = QString("CONNECTION_TYPE_BOOST");
-    postEvent(event);
+//-----------------------------------------------------------------------------
+// NotificationCenter::isActive()
+//
+/// Check the active status of a connection
+/// \param inId The ConnectionInfo to connect to check.
+/// \result True if the connection is connected and active.
+//-----------------------------------------------------------------------------
+bool
+NotificationCenter::isActive(ConnectionId inId) const
+{
+    ConnectionMap::const_iterator iter = mConnectionMap.find(inId);
+    if (iter == mConnectionMap.end())
+        return false;
 
-    return result;
+    return mEvents.contains(iter.value().eventHash);
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::connect()
+// NotificationCenter::dumpRegisteredEvents()
 //
-/// Connect the event ID to the callback.
-/// \param inId The string ID used to make the connection.
-/// \param inObject The python object to be called.
-/// \param inName The name (doesn't appear to do anything).
+/// Output the state of every event to the console, as the JSON of
+/// eventSnapshotJson().
 //-----------------------------------------------------------------------------
-ConnectionId NotificationCenter::connect(const QString& inId,
-                                         PyObject* inObject,
-                                         const std::string& inName)
+void
+NotificationCenter::dumpRegisteredEvents() const
 {
-    EventId eId(inId);
-    return connect(eId, inObject, inName);
+    std::cout << eventSnapshotJson().constData() << std::endl;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::connect()
+// earlierStringId()
 //
-/// Connect the event ID to the callback.
-/// \param inId The event ID used to make the connection.
-/// \param inObject The python object to be called.
-/// \param inName The name (doesn't appear to do anything).
+/// Order event snapshots by their string id.
 //-----------------------------------------------------------------------------
-ConnectionId
-NotificationCenter::connect(const EventId& inId, 
-                            PyObject* inObject, 
-                            const std::string& /*inName*/)
+static bool
+earlierStringId(const EventSnapshot& inLeft, const EventSnapshot& inRight)
 {
-    Q_ASSERT(inObject != NULL);
+    return inLeft.statistics.stringId < inRight.statistics.stringId;
+}
 
-    if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::connect() trying to connect python callable ----> "
-                      << "EventId: " << inId);
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::eventSnapshots()
+//
+/// Return the state of every event the Notification Center has seen:
+/// registered events, events with connections or deferred connections
+/// and events that were posted. The counters are maintained as events
+/// are connected, posted and dispatched, so a snapshot costs a lookup
+/// per event and can be polled. Only call from the thread of the
+/// Notification Center.
+/// \result The events, ordered by string id.
+//-----------------------------------------------------------------------------
+EventSnapshotList
+NotificationCenter::eventSnapshots() const
+{
+    const EventPostCounterMap postCounters = this->postCounters();
+
+    // Events posted from other threads may not have been dispatched yet.
+    EventStatisticsMap statistics = mEventStatistics;
+    EventPostCounterMap::const_iterator postIter = postCounters.constBegin();
+    for ( ; postIter != postCounters.constEnd(); ++postIter) {
+        if (!statistics.contains(postIter.key())) {
+            statistics[postIter.key()].stringId = eventIdForHash(postIter.key()).getStringId();
+        }
     }
 
-    // Save the id before we increment it.
-    int result = mConnectionIdCount;
+    QVector<EventSnapshot> snapshots;
+    snapshots.reserve(statistics.size());
+
+    EventStatisticsMap::const_iterator iter = statistics.constBegin();
+    for ( ; iter != statistics.constEnd(); ++iter) {
+        EventSnapshot snapshot;
+        snapshot.eventHash = iter.key();
+        snapshot.registered = mEventRegistry.contains(iter.key());
+        snapshot.publishers = mPublisherCounts.value(iter.key());
+        snapshot.statistics = iter.value();
+
+        // Events are counted as posted before they enter the queue, so
+        // the difference only drops below zero for an event released
+        // and used again while it was queued.
+        const EventPostCounters counters = postCounters.value(iter.key());
+        snapshot.posted = counters.posted;
+        snapshot.queued = qMax(0, int(counters.queued - iter.value().dequeued));
+        snapshot.coalesced = counters.coalesced;
+        snapshot.deduplicated = counters.deduplicated;
+        snapshot.latency = mLatencies.value(iter.key());
+
+        EventMap::const_iterator eventIter = mEvents.constFind(iter.key());
+        if (eventIter != mEvents.constEnd()) {
+            snapshot.listeners = eventIter.value().listenerCount;
+        }
 
-    // Save the elements need to call the function at a later time
-    ConnectionInfo& infoRef = addConnectionInfo(CONNECTION_TYPE_PYTHON, inId);
-    infoRef.pythonFunctionInfo = PythonFunctionInfoRef(new PythonFunctionInfo(inObject));
+        DeferredEventMap::const_iterator deferIter = mDeferredEvents.constFind(iter.key());
+        if (deferIter != mDeferredEvents.constEnd()) {
+            snapshot.deferredConnections = deferIter.value().connections.size();
+        }
 
-    // Verify that this is a callable object
-    if (PyCallable_Check(inObject)) {
+        snapshots.push_back(snapshot);
+    }
 
-        // Try to locate the EventId in the registry.
-        EventRegistry::iterator iter = mEventRegistry.find(inId.getHash());
-        if (iter == mEventRegistry.end()) {
-            addDeferredEvent(inId, infoRef);
-        } else {
-            // Check and see if we already have objects attached to this event ID.
-            EventMap::const_iterator eventIter = mEvents.find(inId);
-            if (eventIter == mEvents.end()) {
-                // Create an EventId for this object.
-                mEvents[inId] = EventCallbackInfo(EventCallbackRefType(new EventCallbackSignal()),
-                                                  "",
-                                                  PythonFunctionList());
-            }
+    std::sort(snapshots.begin(), snapshots.end(), earlierStringId);
+    return snapshots.toList();
+}
 
-            // Add the puthon object to the list.
-            mEvents[inId].pythonFunctionList.push_back(PythonFunctionInfoRef(new PythonFunctionInfo(inObject)));
 
-            // Send a notification about the connection
-            Event* event = new Event(EventConnected);
-            event->dictionary["id"] = inId.mStringId;
-            event->dictionary["type"] = QString("CONNECTION_TYPE_PYTHON");
-            postEvent(event);            
+//-----------------------------------------------------------------------------
+// NotificationCenter::eventSnapshotReport()
+//
+/// Return eventSnapshots() for Python and reports.
+/// \result A QVariantMap per event.
+//-----------------------------------------------------------------------------
+QVariantList
+NotificationCenter::eventSnapshotReport() const
+{
+    QVariantList result;
+    Q_FOREACH(const EventSnapshot& snapshot, eventSnapshots()) {
+        const EventStatistics& statistics = snapshot.statistics;
+
+        QVariantMap connections;
+        connections["callback"] = statistics.boostConnections;
+        connections["qt"] = statistics.qtConnections;
+        connections["python"] = statistics.pythonConnections;
+        connections["keyed"] = statistics.keyedConnections;
+        connections["deferred"] = snapshot.deferredConnections;
+
+        QVariantMap entry;
+        entry["id"] = statistics.stringId;
+        entry["hash"] = snapshot.eventHash;
+        entry["registered"] = snapshot.registered;
+        entry["publishers"] = snapshot.publishers;
+        entry["listeners"] = snapshot.listeners;
+        entry["connections"] = connections;
+        entry["posted"] = qulonglong(snapshot.posted);
+        entry["dispatched"] = qulonglong(statistics.dispatched);
+        entry["queued"] = snapshot.queued;
+        entry["dropped"] = qulonglong(statistics.dropped);
+        entry["suppressed"] = qulonglong(statistics.suppressed);
+        entry["coalesced"] = qulonglong(snapshot.coalesced);
+        entry["deduplicated"] = qulonglong(snapshot.deduplicated);
+        entry["unchanged"] = qulonglong(statistics.unchanged);
+        result.push_back(entry);
+    }
+    return result;
+}
 
-            if (mDebugOutput) {
-                LOG_INFO("NotificationCenter::connect() connecting python callable ----> "
-                          << "EventId:" << inId
-                          << "     "
-                          << "ConnectionId:" << result
-                          << "     "
-                          << "count:" << mEvents[inId].pythonFunctionList.size());
-            }
-        }
-    } else {
-        // Not callable
-        if (mDebugOutput) {
-            LOG_ERROR("NotificationCenter::connect() python object not callable ----> "
-                      << "EventId:" << inId);
-        }
 
-        // Remove the info from the map.
-        mConnectionMap.remove(mConnectionIdCount - 1);
+//-----------------------------------------------------------------------------
+// NotificationCenter::eventSnapshotJson()
+//
+/// Return eventSnapshotReport() as a JSON array.
+//-----------------------------------------------------------------------------
+QByteArray
+NotificationCenter::eventSnapshotJson() const
+{
+    return toJson(eventSnapshotReport());
+}
 
-        result = NotificationCenter::INVALID_CONNECTION_ID;
-    }
 
+//-----------------------------------------------------------------------------
+// NotificationCenter::latencyStatistics()
+//
+/// Summarize the latency of an event for Python and monitoring. Both
+/// entries hold the count and the min, max, mean, p50, p90, p99 and p999
+/// durations in nanoseconds.
+/// \param inId The event.
+/// \result The "queue" and "dispatch" summaries of the event.
+//-----------------------------------------------------------------------------
+QVariantMap
+NotificationCenter::latencyStatistics(const EventId& inId) const
+{
+    const EventLatency eventLatency = latency(inId);
+
+    QVariantMap result;
+    result["queue"] = eventLatency.queue.toVariantMap();
+    result["dispatch"] = eventLatency.dispatch.toVariantMap();
+    result["gilWait"] = eventLatency.gilWait.toVariantMap();
     return result;
 }
 
 
-/*
-[TODO] How to do a bulk disconnect of all EventId?
 //-----------------------------------------------------------------------------
-// NotificationCenter::disconnect()
+// NotificationCenter::resetLatency()
 //
-/// Disconnect all callbacks attached to the event ID.
-/// \param inId The event ID used to disconnect.
+/// Forget the latency recorded for every event, for instance at the start
+/// of a measurement.
 //-----------------------------------------------------------------------------
 void
-NotificationCenter::disconnect(const EventId& inId)
+NotificationCenter::resetLatency()
 {
-    EventCallbackRefType signal;
-    EventMap::iterator iter = mEvents.find(inId);
-    if (iter != mEvents.end()) {
-        signal = iter.value();
-        signal->disconnect_all_slots();
-    }
+    mLatencies.clear();
 }
-*/
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::disconnect()
-//
-/// Disconnect all callbacks attached to the event ID.
-/// \param inId The connection ID that will be disconnected.
+// NotificationCenter::setListenerProfiling()
 //
-// NOTE: If all connections of all types are removed, the event is
-// still registered.  Should there be a way to completely unregister
-// an event?  I am thinking no, as right now there is no way to keep
-// track of who actually registered an event in the first place.
+/// Measure the time spent in each listener, to find the slow ones. The
+/// dispatch times every call while profiling is on, so all connections
+/// are measured whenever they were made. Turning profiling off pauses
+/// the measurement and keeps the profiles, turning it on again resumes
+/// it.
+///
+/// Qt slots are only measured when they are called from the thread of
+/// the Notification Center.
+/// \param inEnabled True to profile.
 //-----------------------------------------------------------------------------
 void
-NotificationCenter::disconnect(const ConnectionId& inId)
+NotificationCenter::setListenerProfiling(bool inEnabled)
 {
-    // Check all the connections, both deferred and live.
-    ConnectionMap::iterator iter = mConnectionMap.find(inId);
-    if (iter == mConnectionMap.end()) {
-        // There is no information for this ConnectionId.
-        if (mDebugOutput) {
-            LOG_WARN("NotificationCenter::disconnect() Connection information not found ----> "
-                     << "ConnectionId:" << inId);
+    mListenerProfiling = inEnabled;
+
+    if (inEnabled) {
+        for (ConnectionMap::const_iterator iter = mConnectionMap.constBegin(); iter != mConnectionMap.constEnd(); ++iter) {
+            if (!mListenerProfiles.contains(iter.key())) {
+                addListenerProfile(iter.key(), iter.value());
+            }
         }
-        return;
     }
 
-    const ConnectionInfo& connectionInfo = iter.value();
-    Q_ASSERT(inId == connectionInfo.connectionId);
-
-    if (mDebugOutput) {
-        LOG_INFO("NotificationCenter::disconnect() "
-                 << "EventId:" << connectionInfo.eventId);
+    // Python callables time themselves through their shared function info.
+    for (PythonConnectionMap::iterator iter = mPythonConnections.begin(); iter != mPythonConnections.end(); ++iter) {
+        if (iter.value().function) {
+            iter.value().function->profile = inEnabled ? mListenerProfiles.value(iter.key()) : ListenerProfileRef();
+        }
     }
+}
 
-    // Check the deferred connection list first
-    DeferredEventMap::iterator deferIter = mDeferredEvents.find(connectionInfo.eventId.getHash());
-    if (deferIter != mDeferredEvents.end()) {
 
-        DeferredCallbackList& deferredList = deferIter.value();
-        DeferredCallbackList::iterator deferredListIter = std::find(deferredList.begin(),
-                deferredList.end(),
-                &connectionInfo);
-        if (deferredListIter != deferredList.end()) {
+//-----------------------------------------------------------------------------
+// NotificationCenter::addListenerProfile()
+//
+/// Start the profile of a connection. Python callables connected without
+/// a name are named after their method.
+/// \param inConnection The connection.
+/// \param inInfo The ConnectionInfo of the connection.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::addListenerProfile(ConnectionId inConnection, const ConnectionInfo& inInfo)
+{
+    ListenerProfileRef profile(new ListenerProfile());
+    profile->connection = inConnection;
+    profile->eventHash = inInfo.eventHash;
+    profile->name = mListenerNames.value(inConnection);
+    if (profile->name.isEmpty()) {
+        profile->name = QString::fromStdString(inInfo.type == CONNECTION_TYPE_PYTHON
+                                               ? pythonFunctionName(mPythonConnections.value(inConnection).function)
+                                               : DEFAULT_CALLBACK_NAME);
+    }
+    mListenerProfiles.insert(inConnection, profile);
+}
 
-            // Remove the deferred callback
-            deferredList.erase(deferredListIter);
 
-            if (mDebugOutput) {
-                LOG_INFO("NotificationCenter::disconnect() removing deferred connection.");
-            }
-        }
-    }
+//-----------------------------------------------------------------------------
+// NotificationCenter::listenerProfile()
+//
+/// Return the profile of a connection while listeners are profiled.
+/// \param inConnection The connection.
+/// \result The profile, or NULL when not profiling.
+//-----------------------------------------------------------------------------
+ListenerProfile*
+NotificationCenter::listenerProfile(ConnectionId inConnection) const
+{
+    return findListenerProfile(mListenerProfiling ? &mListenerProfiles : NULL, inConnection);
+}
 
 
-    // [TODO gragan] I think we should be able to check and see if any events were removed from the deferred
-    // map. If any were, that means that the event in question has not been registered and we do
-    // not need to proceed any further.
+//-----------------------------------------------------------------------------
+// moreTotalTime()
+//
+/// Order listener profiles by the time spent in them, most first.
+//-----------------------------------------------------------------------------
+static bool
+moreTotalTime(const ListenerProfile& inLeft, const ListenerProfile& inRight)
+{
+    return inLeft.totalNanoseconds > inRight.totalNanoseconds;
+}
 
-    // Get the EventCallbackInfo structure that contains all
-    // of the connections related to it.
-    EventMap::iterator eventIter = mEvents.find(connectionInfo.eventId);
-    if (eventIter == mEvents.end()) {
-        // There is no information for this ConnectionId.
-        if (mDebugOutput) {
-            LOG_WARN("NotificationCenter::disconnect() Event information not found ----> "
-                     << "EventId:" << connectionInfo.eventId.mStringId
-                     << " "
-                     << connectionInfo.connectionId);
-        }
-        return;
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::listenerProfiles()
+//
+/// Return the profiles of the profiled connections, the listeners that
+/// took the most time in total first.
+/// \param inCount The number of profiles to return, all if negative.
+/// \result The profiles.
+//-----------------------------------------------------------------------------
+ListenerProfileList
+NotificationCenter::listenerProfiles(int inCount) const
+{
+    QVector<ListenerProfile> profiles;
+    profiles.reserve(mListenerProfiles.size());
+    Q_FOREACH(const ListenerProfileRef& profile, mListenerProfiles) {
+        profiles.push_back(*profile);
     }
 
-    // Get the event callback info
-    EventCallbackInfo& eventCallbackInfo = eventIter.value();
+    const int count = (inCount < 0) ? profiles.size() : qMin(inCount, profiles.size());
+    std::partial_sort(profiles.begin(), profiles.begin() + count, profiles.end(), moreTotalTime);
 
-    // Break the connection based on connection type.
-    switch (connectionInfo.type) {
-    case CONNECTION_TYPE_NONE:
-        break;
+    return profiles.mid(0, count).toList();
+}
 
-    case CONNECTION_TYPE_BOOST: {
-        if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::disconnect() disconnecting boost callback ----> "
-                     << "EventId:" << connectionInfo.eventId);
-        }
 
-        connectionInfo.boostId.disconnect();
+//-----------------------------------------------------------------------------
+// NotificationCenter::listenerProfileReport()
+//
+/// Return the profiles of listenerProfiles() for Python and reports. Each
+/// entry holds the connection, event, name, calls and the total, max and
+/// mean time in nanoseconds.
+/// \param inCount The number of profiles to return, all if negative.
+/// \result The profiles, as QVariantMaps.
+//-----------------------------------------------------------------------------
+QVariantList
+NotificationCenter::listenerProfileReport(int inCount) const
+{
+    QVariantList result;
+    Q_FOREACH(const ListenerProfile& profile, listenerProfiles(inCount)) {
+        QVariantMap entry;
+        entry["connection"] = profile.connection;
+        entry["event"] = eventIdForHash(profile.eventHash).getStringId();
+        entry["name"] = profile.name;
+        entry["calls"] = qulonglong(profile.calls);
+        entry["total"] = qulonglong(profile.totalNanoseconds);
+        entry["max"] = qulonglong(profile.maxNanoseconds);
+        entry["mean"] = profile.calls == 0 ? 0.0 : double(profile.totalNanoseconds) / double(profile.calls);
+        result.push_back(entry);
     }
-    break;
+    return result;
+}
 
-    case CONNECTION_TYPE_QT: {
-        if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::disconnect() disconnecting Qt slot ----> "
-                     << "EventId:" << connectionInfo.eventId);
-        }
 
-        // Find and remove the signal info from the dynamic signal map
-        const QByteArray theSignal = QMetaObject::normalizedSignature(connectionInfo.qtSignal.toLatin1());
-        SignalTable::iterator iter2 = mQtSignalIndices.find(theSignal);
-        if (iter2 != mQtSignalIndices.end()) {
-
-        	// Disconnect the slot from the dynamic signal
-			const int signalId = *iter2 + metaObject()->methodCount();
-			const int slotId = connectionInfo.qtObject->metaObject()->indexOfMethod(connectionInfo.qtMethod.toLatin1());
-			bool result = QMetaObject::disconnect(this,
-					    					      signalId,
-					    						  connectionInfo.qtObject,
-					    						  slotId);		        	
-            if (!result) {
-	            LOG_WARN("NotificationCenter::disconnect() Unable to disconnect ----> "
-	                     << "EventId:" << connectionInfo.eventId.mStringId
-	                     << " "
-	                     << connectionInfo.connectionId);
-			}
-			
-        	// Remove the signal from the signal map.
-            mQtSignalIndices.erase(iter2);
-		}
+//-----------------------------------------------------------------------------
+// NotificationCenter::resetListenerProfiles()
+//
+/// Zero the counters of every profiled connection.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::resetListenerProfiles()
+{
+    Q_FOREACH(const ListenerProfileRef& profile, mListenerProfiles) {
+        profile->calls = 0;
+        profile->totalNanoseconds = 0;
+        profile->maxNanoseconds = 0;
     }
-    break;
+}
 
-    case CONNECTION_TYPE_PYTHON: {
-        if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::disconnect() disconnecting python method ----> "
-                     << "EventId:" << connectionInfo.eventId);
-        }
 
-        PythonFunctionList::iterator callbackIter = eventCallbackInfo.pythonFunctionList.begin();
-        for (; callbackIter != eventCallbackInfo.pythonFunctionList.end(); ++callbackIter) {
-            PythonFunctionInfoRef infoRef = *callbackIter;
-            if (infoRef->functionMethod == connectionInfo.pythonFunctionInfo->functionMethod) {
-                eventCallbackInfo.pythonFunctionList.erase(callbackIter);
-                break;
-            }
-        }
+//-----------------------------------------------------------------------------
+// NotificationCenter::connectionTypeToString()
+//
+/// Convert a ConnectionType to a string.
+/// \result A human readable string based on the ConnectionType.
+//-----------------------------------------------------------------------------
+QString
+NotificationCenter::connectionTypeToString(ConnectionType inType)
+{
+    QString typeString;
+
+    switch (inType) 
+    {
+        case CONNECTION_TYPE_BOOST:
+            typeString = "CONNECTION_TYPE_BOOST";
+            break;
+
+        case CONNECTION_TYPE_QT:
+            typeString = "CONNECTION_TYPE_QT";
+            break;
+
+        case CONNECTION_TYPE_PYTHON:
+            typeString = "CONNECTION_TYPE_PYTHON";
+            break;
+
+        case CONNECTION_TYPE_NONE:
+            typeString = "CONNECTION_TYPE_NONE";
+            break;
+
+        default:
+            typeString = "CONNECTION_TYPE_UNKNOWN";
+            break;
     }
-    break;
 
-    default:
-        break;
-    };
+    return typeString;
+}
 
-    // Send a notification about the disconnection
-    Event* event = new Event(EventDisconnected);
-    event->dictionary["id"] = connectionInfo.eventId.mStringId;
-    event->dictionary["type"] = connectionTypeToString(connectionInfo.type);
-    
-    // Remove the info from the connection map
-    // note connectionInfo now points to bad memory
-    mConnectionMap.erase(iter);
 
-    postEvent(event);
+//-----------------------------------------------------------------------------
+// NotificationCenter::setCoalesceInterval()
+//
+/// Set the event coalescing interval in milliseconds. Values less than
+/// 10 may not be respected.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::setCoalesceInterval(int inAmount)
+{
+    mCoalesceInterval = qMax(1, inAmount);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationCenter::setDeduplicated()
+//
+/// Drop posted events of an id that equal an event still waiting in the
+/// queue, as when several publishers announce the same change in one
+/// turn of the event loop. Events are equal if their key and dictionary
+/// are; the dictionary is hashed once when the event is queued.
+///
+/// Events dispatched synchronously with POST_NOW are never dropped.
+/// Lazy and typed events of the id build their dictionary when posted.
+/// State events are not deduplicated, as a copy of a queued state may
+/// restore it after another state queued in between.
+/// \param inId The EventId.
+/// \param inEnabled True to drop duplicates.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::setDeduplicated(const EventId& inId, bool inEnabled)
+{
+    QMutexLocker locker(&mPostMutex);
+    if (inEnabled && !isStateEvent(inId)) {
+        mDeduplicatedEvents.insert(inId.getHash());
+    } else {
+        mDeduplicatedEvents.remove(inId.getHash());
+    }
+    mDeduplicatedCount = mDeduplicatedEvents.size();
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::disconnect()
+// NotificationCenter::setSticky()
 //
-/// Disconnect all connections in the list.
-/// The list passed in will be cleared on return.
-/// \param inList A ConnectionList of connections to disconnect.
+/// Keep the last dispatched event of an id, for events describing state.
+/// Listeners connecting to a sticky event receive the last event right
+/// away, from connect() or, for deferred connections, when they attach,
+/// and lastEvent() returns it without copying.
+///
+/// Each dispatch of a sticky event clones it. Keyed listeners only
+/// receive the last event if it was posted with their key.
+/// \param inId The EventId.
+/// \param inEnabled True to keep the last event, false to drop it.
 //-----------------------------------------------------------------------------
 void
-NotificationCenter::disconnect(ConnectionList& inList)
+NotificationCenter::setSticky(const EventId& inId, bool inEnabled)
 {
-    ConnectionList::iterator iter = inList.begin();
-    for ( ; iter != inList.end(); ++iter) {
-        disconnect(*iter); 
+    if (inEnabled) {
+        if (!mStickyEvents.contains(inId.getHash())) {
+            mStickyEvents.insert(inId.getHash(), StickyEventRef());
+        }
+    } else {
+        mStickyEvents.remove(inId.getHash());
     }
-    
-    inList.clear();
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::addDeferredEvent()
+// NotificationCenter::setStateEvent()
 //
-/// Add events for EventId's not yet registered.
-/// \param inId The EventId to defer.
+/// Make an id a state event, for events whose publishers post their full
+/// state on every change. The center keeps the state and, as each event
+/// is dispatched, replaces its dictionary with the keys that changed
+/// since the previous one. Removed keys are set to an invalid QVariant,
+/// None in python. Events that change nothing are not delivered.
+///
+/// Listeners read the changes from the event and all of the state from
+/// currentState(). Typed listeners keep receiving the full payload.
+/// Making an id a state event turns its deduplication off. Call from the
+/// thread of the Notification Center.
+/// \param inId The EventId.
+/// \param inEnabled True to dispatch changes, false to forget the state.
 //-----------------------------------------------------------------------------
 void
-NotificationCenter::addDeferredEvent(const EventId& inId, ConnectionInfo& outInfoRef)
+NotificationCenter::setStateEvent(const EventId& inId, bool inEnabled)
 {
-    if (mDebugOutput) {
-        LOG_INFO("NotificationCenter::addDeferredEvent() adding deferred event ----> "
-                  << "EventId:" << inId);
-    }
-
-    // We were unable to find the event in the active event registry.
-    // Check and see if we already have the EventId in the deferred queue.
-    DeferredEventMap::iterator deferIter = mDeferredEvents.find(inId.getHash());
-    if (deferIter == mDeferredEvents.end()) {
-        if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::addDeferredEvent() creating deferred event list.");
-        }
-
-        DeferredCallbackList callbackList;
-        mDeferredEvents[inId.getHash()] = callbackList;
-        mDeferredEvents[inId.getHash()].push_back(&outInfoRef);
-    }
-    else {
-        if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::addDeferredEvent() found deferred event list.");
+    const unsigned int eventHash = inId.getHash();
+    if (inEnabled) {
+        if (!mStateEvents.contains(eventHash)) {
+            mStateEvents.insert(eventHash, EventDictionary());
         }
 
-        // There is already a deferred event to add the callback to.
-        deferIter.value().push_back(&outInfoRef);
+        QMutexLocker locker(&mPostMutex);
+        mDeduplicatedEvents.remove(eventHash);
+        mDeduplicatedCount = mDeduplicatedEvents.size();
+    } else {
+        mStateEvents.remove(eventHash);
     }
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::addConnectionInfo()
+// NotificationCenter::currentState()
 //
-/// Set up some boilerplate info based on connection type.
-/// \param inType The ConnectionType.
+/// Return the full state of a state event, as of the last event that was
+/// dispatched. Only call from the thread of the Notification Center.
+/// \param inId The EventId.
+/// \result The state, empty for other events.
 //-----------------------------------------------------------------------------
-ConnectionInfo&
-NotificationCenter::addConnectionInfo(ConnectionType inType, const EventId& inId)
+const EventDictionary&
+NotificationCenter::currentState(const EventId& inId) const
 {
-    // Set up the connection info
-    ConnectionInfo info;
-    info.eventId = inId;
-    info.type = inType;
-    info.connectionId = mConnectionIdCount;
+    static const EventDictionary sEmpty;
 
-    // Save the connection info for this connection ID
-    mConnectionMap[mConnectionIdCount++] = info;
-
-    // Get a reference back out of the map so we can share the information.
-    return mConnectionMap[mConnectionIdCount - 1];
+    StateEventMap::const_iterator stateIter = mStateEvents.constFind(inId.getHash());
+    return stateIter != mStateEvents.constEnd() ? stateIter.value() : sEmpty;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::checkForAndConnectDeferredEvents()
+// NotificationCenter::isDeduplicated()
 //
-/// Connect all deferred signals for the EventId
-/// \param inId The EventId to connect deferred events to.
+/// \result True if copies of queued events of the id are dropped.
 //-----------------------------------------------------------------------------
-void
-NotificationCenter::checkForAndConnectDeferredEvents(const EventId& inId)
+bool
+NotificationCenter::isDeduplicated(const EventId& inId) const
 {
-    // Check and see if the event is in the deferred list. If so, we can
-    // remove it and move it over to the active event list.
-    DeferredEventMap::iterator deferIter = mDeferredEvents.find(inId.getHash());
-    if (deferIter != mDeferredEvents.end()) {
-
-        EventCallbackRefType signal;
-
-        // We found a deferred event. Get the list of callbacks waiting
-        // to be connected.
-        DeferredCallbackList& callbackList = deferIter.value();
+    QMutexLocker locker(&mPostMutex);
+    return mDeduplicatedEvents.contains(inId.getHash());
+}
 
-        // Connect the deferred callbacks
-        DeferredCallbackList::iterator callbackIter = callbackList.begin();
-        for (int index = 0; callbackIter != callbackList.end(); ++callbackIter, ++index) {
-            ConnectionInfo* callbackConnectInfo = *callbackIter;
 
-            if (index == 0) {
-                // If this is the first instance, we need to create the signal.
-                 signal = EventCallbackRefType(new EventCallbackSignal());
+//-----------------------------------------------------------------------------
+// NotificationCenter::setMaxCascadeDepth()
+//
+/// Limit how deep listeners may send events, or post them with POST_NOW,
+/// in response to events. Events beyond the limit are suppressed. Queued
+/// events count too, unless they repost the event being dispatched, see
+/// admitEvent(). There is no limit until one is set.
+/// \param inDepth The deepest cascade depth allowed, 0 for no limit.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::setMaxCascadeDepth(int inDepth)
+{
+    mMaxCascadeDepth = qMax(0, inDepth);
+}
 
-                // Add the event to the events map
-                mEvents[inId] = EventCallbackInfo(signal, "", PythonFunctionList());
 
-                if (mDebugOutput) {
-                    LOG_INFO("NotificationCenter::checkForAndConnectDeferredEvents() found deferred event ----> "
-                              << "EventId:" << inId);
-                }
-            }
+//-----------------------------------------------------------------------------
+// NotificationCenter::setMaxCascadeFanOut()
+//
+/// Limit how many events the listeners of one dispatch may send or post
+/// with POST_NOW.
+/// \param inFanOut The most events per dispatch, 0 for no limit.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::setMaxCascadeFanOut(int inFanOut)
+{
+    mMaxCascadeFanOut = qMax(0, inFanOut);
+}
 
-            if (callbackConnectInfo->type == CONNECTION_TYPE_BOOST) {
-                // Attach the callback to the signal
-                callbackConnectInfo->boostId = signal->connect(callbackConnectInfo->boostCallbackType);
 
-                if (mDebugOutput) {
-                        LOG_INFO("NotificationCenter::checkForAndConnectDeferredEvents() connecting deferred boost event ----> "
-                                  << "EventId:" << inId
-                                  << " "
-                                  << "ConnectionId:" << callbackConnectInfo->connectionId);
-                }
-            } else if (callbackConnectInfo->type == CONNECTION_TYPE_QT) {
+//-----------------------------------------------------------------------------
+// NotificationCenter::setMaxCycleRepeats()
+//
+/// Limit how often an EventId may repeat between an event and the root
+/// of its cascade. A repeating EventId means listeners send or post to
+/// each other in a loop, which is cut once it went round this many times.
+/// \param inRepeats The most repeats, 0 for no cycle detection.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::setMaxCycleRepeats(int inRepeats)
+{
+    mMaxCycleRepeats = qMax(0, inRepeats);
+}
 
-                if (connectQtEvent(inId, *callbackConnectInfo)) {
-                    // Set the slot signature so we can invoke later on.
-                    mEvents[inId].qtSlotSignature = callbackConnectInfo->qtSignal;
 
-                    if (mDebugOutput) {
-                            LOG_INFO("NotificationCenter::checkForAndConnectDeferredEvents() connecting deferred Qt event ----> "
-                                      << "EventId:" << inId
-                                      << " "
-                                      << "ConnectionId:" << callbackConnectInfo->connectionId);
-                    }
-                } else {
-                    // We failed to make the dynamic Qt connection.
-                    if (mDebugOutput) {
-                        LOG_ERROR("NotificationCenter::checkForAndConnectDeferredEvents() failed to connect deferred Qt event ----> "
-                                  << "EventId:" << inId
-                                  << " "
-                                  << "ConnectionId:" << callbackConnectInfo->connectionId);
-                    }
-                }
-            } else if (callbackConnectInfo->type == CONNECTION_TYPE_PYTHON) {
+//-----------------------------------------------------------------------------
+// NotificationCenter::cascadeReport()
+//
+/// Return the cascades of every root event, ordered by their total cost.
+/// Costs are in nanoseconds of listener time, dispatches nested in other
+/// dispatches counted once.
+/// \result A QVariantMap per root event.
+//-----------------------------------------------------------------------------
+QVariantList
+NotificationCenter::cascadeReport() const
+{
+    QMap<quint64, QVariantMap> ordered;
+    CascadeStatisticsMap::const_iterator iter = mCascadeStatistics.constBegin();
+    for ( ; iter != mCascadeStatistics.constEnd(); ++iter) {
+        const CascadeStatistics& statistics = iter.value();
+
+        QVariantMap entry;
+        entry["id"] = eventIdForHash(iter.key()).getStringId();
+        entry["hash"] = iter.key();
+        entry["trees"] = qulonglong(statistics.trees);
+        entry["events"] = qulonglong(statistics.events);
+        entry["maxEvents"] = statistics.maxEvents;
+        entry["maxDepth"] = statistics.maxDepth;
+        entry["suppressed"] = qulonglong(statistics.suppressed);
+        entry["cost"] = statistics.cost.toVariantMap();
+        ordered.insertMulti(statistics.cost.total(), entry);
+    }
 
-                mEvents[inId].pythonFunctionList.push_back(callbackConnectInfo->pythonFunctionInfo);
+    QVariantList result;
+    QMapIterator<quint64, QVariantMap> orderedIter(ordered);
+    orderedIter.toBack();
+    while (orderedIter.hasPrevious()) {
+        result.push_back(orderedIter.previous().value());
+    }
+    return result;
+}
 
-                if (mDebugOutput) {
-                        LOG_INFO("NotificationCenter::checkForAndConnectDeferredEvents() connecting deferred Python event ----> "
-                                  << "EventId:" << inId
-                                  << " "
-                                  << "ConnectionId:" << callbackConnectInfo->connectionId);
-                }
-            } else {
-                if (mDebugOutput) {
-                    LOG_WARN("NotificationCenter::checkForAndConnectDeferredEvents() unknown deferred event ----> "
-                              << "EventId:" << inId
-                              << " "
-                              << "ConnectionId:" << callbackConnectInfo->connectionId);
-                }
-            }
-        }
 
-        // Remove the deferred item. It is now in the active list.
-        mDeferredEvents.erase(deferIter);
-    }
+//-----------------------------------------------------------------------------
+// NotificationCenter::resetCascades()
+//
+/// Forget the statistics of closed cascades. Open cascades keep counting.
+//-----------------------------------------------------------------------------
+void
+NotificationCenter::resetCascades()
+{
+    mCascadeStatistics.clear();
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::connectQtEvent()
+// NotificationCenter::admitEvent()
 //
-/// Connect all deferred Qt signals.
-/// \param inInfoRef The ConnectionInfo to connect deferred events to.
-/// \result True if connection was made.
+/// Stamp the causality of an event about to be posted or sent and check
+/// the cascade limits. Events sent or posted by listeners on the thread
+/// of the center join the cascade of the event being dispatched, queued
+/// ones included, so loops through the queue are cut like synchronous
+/// ones. An event reposting itself through the queue, as tick and poll
+/// loops do, starts a new cascade and is never suppressed.
+/// \param inEvent The event.
+/// \param inQueued Whether the event goes through the event queue.
+/// \result False if the event is suppressed by the cascade limits.
 //-----------------------------------------------------------------------------
 bool
-NotificationCenter::connectQtEvent(const EventId& inId, ConnectionInfo& ioInfoRef)
+NotificationCenter::admitEvent(const Event& inEvent, bool inQueued)
 {
-    bool result = false;
+    inEvent.serial = quint32(lastEventSerial().fetchAndAddRelaxed(1) + 1);
 
-    if (connectDynamicSignal(ioInfoRef)) {
+    if (QThread::currentThread() != thread() || mDispatchFrames.isEmpty()) {
+        inEvent.parentSerial = 0;
+        inEvent.rootSerial = inEvent.serial;
+        inEvent.cascadeDepth = 0;
+        return true;
+    }
 
-        if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::connectQtEvent() connecting qt slot ----> "
-                      << "EventId:" << inId
-                      << " "
-                      << "StringId:" << inId.getStringId().toStdString());
-        }
+    DispatchFrame& frame = mDispatchFrames.last();
+    inEvent.parentSerial = frame.serial;
+    if (inQueued && inEvent.id.getHash() == frame.eventHash) {
+        inEvent.rootSerial = inEvent.serial;
+        inEvent.cascadeDepth = 0;
+        return true;
+    }
 
-        // Check and see if we already have slots attached to this event ID.
-        EventMap::const_iterator eventIter = mEvents.find(inId);
-        if (eventIter == mEvents.end()) {
-            // Add the event to the events map
-            mEvents[inId] = EventCallbackInfo(EventCallbackRefType(new EventCallbackSignal()),
-                                              ioInfoRef.qtSignal,
-                                              PythonFunctionList());
-        }
+    inEvent.rootSerial = frame.rootSerial;
+    inEvent.cascadeDepth = frame.cascadeDepth + 1;
 
-        result = true;
+    const char* reason = NULL;
+    if (mMaxCascadeDepth > 0 && inEvent.cascadeDepth > mMaxCascadeDepth) {
+        reason = "depth";
+    } else if (mMaxCascadeFanOut > 0 && frame.fanOut >= mMaxCascadeFanOut) {
+        reason = "fan-out";
+    } else if (mMaxCycleRepeats > 0 && cycleRepeats(inEvent.id.getHash()) >= mMaxCycleRepeats) {
+        reason = "cycle";
+    }
 
-    } else {
-        if (mDebugOutput) {
-            LOG_INFO("NotificationCenter::connectQtEvent() failed ----> "
-                      << "EventId:" << inId
-                      << " "
-                      << "StringId:" << inId.getStringId().toStdString());
+    if (reason != NULL) {
+        // The tree of the event being dispatched is open until it returns.
+        CascadeTree& tree = mCascadeTrees[frame.rootSerial];
+        ++tree.suppressed;
+        ++statisticsFor(inEvent.id).suppressed;
+        if (!tree.warned) {
+            tree.warned = true;
+            LOG_WARN("NotificationCenter: cascade " << reason << " limit reached, suppressing "
+                     << qPrintable(inEvent.id.getStringId()) << " posted by "
+                     << qPrintable(eventIdForHash(frame.eventHash).getStringId())
+                     << " at depth " << inEvent.cascadeDepth);
         }
+        return false;
     }
 
-    return result;
+    ++frame.fanOut;
+    return true;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::isValid()
+// NotificationCenter::cycleRepeats()
 //
-/// Check the validity of a connection
-/// \param inId The ConnectionInfo to connect to check.
-/// \result True if the connection is valid.
+/// Count the dispatches of an EventId between the innermost dispatch and
+/// the root of its cascade. The synchronous part of the path is on top of
+/// the dispatch stack, down to the root or to an event that was queued,
+/// which brought the rest of the path along.
+/// \param inEventHash The EventId hash to count.
+/// \result The number of dispatches of the hash.
 //-----------------------------------------------------------------------------
-bool
-NotificationCenter::isValid(ConnectionId inId) const
+int
+NotificationCenter::cycleRepeats(unsigned int inEventHash) const
 {
-    ConnectionMap::const_iterator iter = mConnectionMap.find(inId);
-    return iter != mConnectionMap.end();
+    int result = 0;
+    const quint32 rootSerial = mDispatchFrames.last().rootSerial;
+    for (int index = mDispatchFrames.size() - 1; index >= 0; --index) {
+        const DispatchFrame& frame = mDispatchFrames.at(index);
+        if (frame.rootSerial != rootSerial)
+            break;
+
+        if (frame.eventHash == inEventHash) {
+            ++result;
+        }
+        if (frame.history != NULL)
+            return result + frame.history->value(inEventHash);
+    }
+    return result;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::isDeferred()
+// NotificationCenter::cycleHistory()
 //
-/// Check the deferred status of a connection
-/// \param inId The ConnectionInfo to connect to check.
-/// \result True if the connection is connected but deferred.
+/// Count every EventId between the innermost dispatch and the root of its
+/// cascade, for an event posted to the queue, see cycleRepeats().
+/// \result The dispatches of each EventId hash on the path.
 //-----------------------------------------------------------------------------
-bool
-NotificationCenter::isDeferred(ConnectionId inId) const
+CycleHistory
+NotificationCenter::cycleHistory() const
 {
-    ConnectionMap::const_iterator iter = mConnectionMap.find(inId);
-    if (iter == mConnectionMap.end())
-        return false;
-
-    const ConnectionInfo& connectionInfo = iter.value();
+    CycleHistory result;
+    const quint32 rootSerial = mDispatchFrames.last().rootSerial;
+    for (int index = mDispatchFrames.size() - 1; index >= 0; --index) {
+        const DispatchFrame& frame = mDispatchFrames.at(index);
+        if (frame.rootSerial != rootSerial)
+            break;
 
-    DeferredEventMap::const_iterator deferIter = mDeferredEvents.find(connectionInfo.eventId.getHash());
-    return deferIter != mDeferredEvents.end();
+        ++result[frame.eventHash];
+        if (frame.history != NULL) {
+            CycleHistory::const_iterator iter = frame.history->constBegin();
+            for ( ; iter != frame.history->constEnd(); ++iter) {
+                result[iter.key()] += iter.value();
+            }
+            break;
+        }
+    }
+    return result;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::isActive()
+// NotificationCenter::beginCascade()
 //
-/// Check the active status of a connection
-/// \param inId The ConnectionInfo to connect to check.
-/// \result True if the connection is connected and active.
+/// Enter the dispatch of an event. Roots open their cascade here, as they
+/// may have been posted from any thread.
+/// \param inEvent The event being dispatched.
+/// \param inStart When the dispatch started.
+/// \param inHistory The path of the cascade a queued event continues,
+/// NULL for other events.
 //-----------------------------------------------------------------------------
-bool
-NotificationCenter::isActive(ConnectionId inId) const
+void
+NotificationCenter::beginCascade(const Event& inEvent, quint64 inStart, const CycleHistory* inHistory)
 {
-    ConnectionMap::const_iterator iter = mConnectionMap.find(inId);
-    if (iter == mConnectionMap.end())
-        return false;
-
-    const ConnectionInfo& connectionInfo = iter.value();
+    // Events dispatched without being posted or sent start a cascade.
+    if (inEvent.serial == 0) {
+        inEvent.serial = quint32(lastEventSerial().fetchAndAddRelaxed(1) + 1);
+        inEvent.parentSerial = 0;
+        inEvent.rootSerial = inEvent.serial;
+        inEvent.cascadeDepth = 0;
+    }
 
-    EventMap::const_iterator eventIter = mEvents.find(connectionInfo.eventId);
-    return eventIter != mEvents.end();
+    CascadeTree& tree = mCascadeTrees[inEvent.rootSerial];
+    if (inEvent.serial == inEvent.rootSerial) {
+        tree.rootHash = inEvent.id.getHash();
+    }
+    ++tree.events;
+    ++tree.dispatching;
+    tree.maxDepth = qMax(tree.maxDepth, inEvent.cascadeDepth);
+
+    DispatchFrame frame;
+    frame.eventHash = inEvent.id.getHash();
+    frame.serial = inEvent.serial;
+    frame.rootSerial = inEvent.rootSerial;
+    frame.cascadeDepth = inEvent.cascadeDepth;
+    frame.start = inStart;
+    frame.nested = 0;
+    frame.fanOut = 0;
+    frame.history = inHistory;
+    mDispatchFrames.push_back(frame);
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::dumpRegisteredEvents()
+// NotificationCenter::endCascade()
 //
-/// Output all registered event IDs to the console.
+/// Leave the innermost dispatch. Its time, less the dispatches nested in
+/// it, goes to its cascade, which closes once none of its events is
+/// dispatching or queued.
+/// \param inEnd When the dispatch ended.
 //-----------------------------------------------------------------------------
 void
-NotificationCenter::dumpRegisteredEvents() const
+NotificationCenter::endCascade(quint64 inEnd)
 {
-    EventRegistry::const_iterator iter = mEventRegistry.begin();
-    for ( ; iter != mEventRegistry.end(); ++iter) {
-        const EventId& eventId = iter.value();
-        std::cout << "Registered event: " << eventId.getStringId() << std::endl;
-
-        EventMap::const_iterator eventIter = mEvents.find(eventId);
-        if (eventIter != mEvents.end()) {
-
-            ConnectionMap::const_iterator connectIter = mConnectionMap.begin();
-            for ( ; connectIter != mConnectionMap.end(); ++connectIter) {
-                const ConnectionInfo& info = connectIter.value();
-                if (info.eventId == eventId) {
+    const DispatchFrame frame = mDispatchFrames.last();
+    mDispatchFrames.pop_back();
 
-                    // Dump the connection info
-                    std::cout << "     connection: "  << std::endl
-                              << "          type: " << qPrintable(connectionTypeToString(info.type)) << std::endl
-                              << "          id: " << info.connectionId
-                              << std::endl;
+    const quint64 elapsed = inEnd - frame.start;
+    if (!mDispatchFrames.isEmpty()) {
+        mDispatchFrames.last().nested += elapsed;
+    }
 
-                    // Add a new line between entries.
-                    std::cout << std::endl;
-                }
-            }
-        } else {
-            std::cout << "     no connections"  << std::endl;
+    CascadeTreeMap::iterator treeIter = mCascadeTrees.find(frame.rootSerial);
+    if (treeIter == mCascadeTrees.end())
+        return;
 
-            // Add a new line between entries.
-            std::cout << std::endl;
-        }
+    CascadeTree& tree = treeIter.value();
+    tree.nanoseconds += elapsed - qMin(elapsed, frame.nested);
+    if (--tree.dispatching == 0 && tree.queued == 0) {
+        closeCascade(treeIter);
     }
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::connectionTypeToString()
+// NotificationCenter::releaseQueuedCascade()
 //
-/// Convert a ConnectionType to a string.
-/// \result A human readable string based on the ConnectionType.
+/// Note that a queued event continuing a cascade has been dispatched or
+/// deleted, and close the cascade if that was its last event.
+/// \param inRootSerial The serial of the root of the cascade.
 //-----------------------------------------------------------------------------
-QString
-NotificationCenter::connectionTypeToString(ConnectionType inType)
+void
+NotificationCenter::releaseQueuedCascade(quint32 inRootSerial)
 {
-    QString typeString;
-
-    switch (inType) 
-    {
-        case CONNECTION_TYPE_BOOST:
-            typeString = "CONNECTION_TYPE_BOOST";
-            break;
-
-        case CONNECTION_TYPE_QT:
-            typeString = "CONNECTION_TYPE_QT";
-            break;
-
-        case CONNECTION_TYPE_PYTHON:
-            typeString = "CONNECTION_TYPE_PYTHON";
-            break;
-
-        case CONNECTION_TYPE_NONE:
-            typeString = "CONNECTION_TYPE_NONE";
-            break;
+    CascadeTreeMap::iterator treeIter = mCascadeTrees.find(inRootSerial);
+    if (treeIter == mCascadeTrees.end())
+        return;
 
-        default:
-            typeString = "CONNECTION_TYPE_UNKNOWN";
-            break;
+    CascadeTree& tree = treeIter.value();
+    if (--tree.queued == 0 && tree.dispatching == 0) {
+        closeCascade(treeIter);
     }
-
-    return typeString;
 }
 
 
 //-----------------------------------------------------------------------------
-// NotificationCenter::setCoalesceInterval()
+// NotificationCenter::closeCascade()
 //
-/// Set the event coalescing interval in milliseconds. Values less than
-/// 10 may not be respected.
+/// Add a finished cascade to the statistics of its root.
+/// \param inTree The cascade.
 //-----------------------------------------------------------------------------
 void
-NotificationCenter::setCoalesceInterval(int inAmount)
+NotificationCenter::closeCascade(CascadeTreeMap::iterator inTree)
 {
-    mCoalesceInterval = qMax(1, inAmount);
+    const CascadeTree& tree = inTree.value();
+    CascadeStatistics& statistics = mCascadeStatistics[tree.rootHash];
+    ++statistics.trees;
+    statistics.events += tree.events;
+    statistics.maxEvents = qMax(statistics.maxEvents, tree.events);
+    statistics.maxDepth = qMax(statistics.maxDepth, tree.maxDepth);
+    statistics.suppressed += tree.suppressed;
+    statistics.cost.record(tree.nanoseconds);
+    mCascadeTrees.erase(inTree);
 }
 
 
@@ -1635,17 +4668,17 @@ NotificationCenter::dumpMethods() const
 //-----------------------------------------------------------------------------
 // NotificationCenter::dumpConnectionMethods()
 //
-/// Dump ConnectionInfo metaObject methods.
-/// \param inInfo The ConnectionInfo to dump methods of.
+/// Dump QtConnectionInfo metaObject methods.
+/// \param inInfo The QtConnectionInfo to dump methods of.
 //-----------------------------------------------------------------------------
 void
-NotificationCenter::dumpConnectionMethods(const ConnectionInfo& inInfo) const
+NotificationCenter::dumpConnectionMethods(const QtConnectionInfo& inInfo) const
 {
-	Q_ASSERT(inInfo.qtObject != NULL);
+	Q_ASSERT(!inInfo.receiver.isNull());
 	
 	qDebug() << "Connection Methods: ";
 	
-	const QMetaObject* metaObject = inInfo.qtObject->metaObject();
+	const QMetaObject* metaObject = inInfo.receiver->metaObject();
 	for(int index = metaObject->methodOffset(); index < metaObject->methodCount(); ++index) {
 	    const char* methodSignature = metaObject->method(index).signature();	    
 	    qDebug() << QString::fromLatin1(metaObject->method(index).signature())
@@ -1665,7 +4698,9 @@ NotificationCenter::dumpConnectionMethods(const ConnectionInfo& inInfo) const
 PythonFunctionInfo::PythonFunctionInfo()
     :   functionMethod(NULL),
         functionSelf(NULL),
-        functionClass(NULL)
+        functionClass(NULL),
+        connected(true),
+        connection(0)
 {
 }
 
@@ -1676,7 +4711,9 @@ PythonFunctionInfo::PythonFunctionInfo()
 PythonFunctionInfo::PythonFunctionInfo(PyObject* inCallable)
     :   functionMethod(NULL),
         functionSelf(NULL),
-        functionClass(NULL)
+        functionClass(NULL),
+        connected(true),
+        connection(0)
 {
     Q_ASSERT(inCallable != NULL);
 
@@ -1700,6 +4737,8 @@ PythonFunctionInfo::PythonFunctionInfo(const PythonFunctionInfo& info)
     functionMethod = info.functionMethod;
     functionSelf = info.functionSelf;
     functionClass = info.functionClass;
+    connected = info.connected;
+    connection = info.connection;
 
     Py_XINCREF(functionMethod);
     Py_XINCREF(functionSelf);
@@ -1721,3 +4760,87 @@ PythonFunctionInfo::~PythonFunctionInfo()
     }
 }
 
+
+//-----------------------------------------------------------------------------
+// ListenerProfile::record()
+//
+/// Count a call of the listener.
+/// \param inNanoseconds How long the call took.
+//-----------------------------------------------------------------------------
+void
+ListenerProfile::record(quint64 inNanoseconds)
+{
+    ++calls;
+    totalNanoseconds += inNanoseconds;
+    if (inNanoseconds > maxNanoseconds) {
+        maxNanoseconds = inNanoseconds;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// QtSlotInvoker::operator()
+//-----------------------------------------------------------------------------
+void
+QtSlotInvoker::operator()(void** inArgs) const
+{
+    QObject* object = receiver.data();
+    if (object == NULL)
+        return;
+
+    if (slotIndex >= 0) {
+        QMetaObject::metacall(object, QMetaObject::InvokeMetaMethod, slotIndex, inArgs);
+    } else {
+        callback(*static_cast<const Event*>(inArgs[1]));
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// PythonInvoker::PythonInvoker()
+//
+/// The caller holds the GIL.
+//-----------------------------------------------------------------------------
+PythonInvoker::PythonInvoker(const PythonFunctionInfoRef& inFunction)
+    :   mFunction(inFunction),
+        mMethod(NULL)
+{
+    if (mFunction->isValid()) {
+        mMethod = PyMethod_New(mFunction->functionMethod,
+                               mFunction->functionSelf,
+                               mFunction->functionClass);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// PythonInvoker::~PythonInvoker()
+//-----------------------------------------------------------------------------
+PythonInvoker::~PythonInvoker()
+{
+    // NOTE: on exit this may be false.  Don't try to clean up
+    // If python has already left the building
+    if (mMethod != NULL && Py_IsInitialized()) {
+        python_gil::GilState gilstate;
+        Py_DECREF(mMethod);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// PythonInvoker::operator()
+//
+/// The caller holds the GIL.
+//-----------------------------------------------------------------------------
+void
+PythonInvoker::operator()(const Event& inEvent) const
+{
+    // Skip callables disconnected earlier in this dispatch.
+    if (mMethod != NULL && mFunction->connected) {
+        NC_TRACE_SCOPE_ARG(TRACE_LISTENER_BEGIN, TRACE_LISTENER_END,
+                           inEvent.id.getHash(), mFunction->connection, CONNECTION_TYPE_PYTHON);
+        ListenerTimer timer(mFunction->profile.get());
+        callPythonMethod(mMethod, inEvent);
+    }
+}
+
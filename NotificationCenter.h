@@ -26,17 +26,33 @@ THE SOFTWARE.
 #define AF_NC_HAS_BEEN_INCLUDED
 
 // Boost
-#include <boost/signals.hpp>
+#include <boost/shared_ptr.hpp>
 
 // Qt
 #include <QEvent>
 #include <QHash>
 #include <QList>
 #include <QMap>
+#include <QMetaType>
+#include <QAtomicInt>
+#include <QMutex>
 #include <QObject>
-#include <QTime>
+#include <QPointer>
+#include <QSet>
+#include <QThreadStorage>
 #include <QVariant>
+#include <QVector>
 
+// System
+#ifdef Q_COMPILER_RVALUE_REFS
+#include <memory>
+#include <utility>
+#endif
+
+// Local
+#include "EventDictionary.h"
+#include "EventSignal.h"
+#include "LatencyHistogram.h"
 
 // Python
 struct _object;
@@ -46,6 +62,7 @@ namespace framework {
 
 // Forward declarations
 class NotificationCenter;
+class NCEvent;
 
 //=============================================================================
 // class EventId
@@ -70,7 +87,8 @@ public:
 
 private:
     friend class NotificationCenter;
-    void registerSelf();
+    void registerSelf(int inEventType);
+    void unregisterSelf();
 
     QString mStringId;
     unsigned int mCrc32;
@@ -95,28 +113,251 @@ inline const QString& EventId::getStringId() const { return mStringId; }
 // listeners.  It contains a basic data dictionary payload.  It can be
 // subclassed to provide additional data and functionality.
 //=============================================================================
-typedef QHash<QString, QVariant> EventDictionary;
-
 class Event
 {
 public:
+    Event();
     Event(const EventId& inId);
+    Event(const EventId& inId, quint64 inKey);
     virtual ~Event() {}
 
+    virtual Event* clone() const;
+
+    void ensureDictionary() const;
+    const void* payloadType() const;
+
     EventId id;
-    EventDictionary dictionary;
+    mutable EventDictionary dictionary;         // Filled by ensureDictionary() for typed and lazy events
+    quint64 key;                                // Selects the keyed listeners of a parametric event
+    bool hasKey;
+
+    // Causality, stamped by the Notification Center when the event is
+    // posted or sent. Events a listener on the thread of the center sends
+    // or posts join the cascade of the event being dispatched, even
+    // through the queue. Only an event reposting itself through the
+    // queue starts a cascade of its own.
+    mutable quint32 serial;                     // Unique in the process, 0 until posted
+    mutable quint32 parentSerial;               // The event whose listener posted this one, 0 if none
+    mutable quint32 rootSerial;
+    mutable int cascadeDepth;                   // 0 for the root of a cascade
+    mutable uint contentHash;                   // Set while a deduplicated event waits in the queue, 0 otherwise
+
+protected:
+    virtual void fillDictionary(EventDictionary& outDictionary) const;
+
+    const void* mPayloadType;                   // Set by TypedEvent, NULL for untyped events
+    mutable bool mDictionaryFilled;
+};
+
+inline const void* Event::payloadType() const { return mPayloadType; }
+
+
+//=============================================================================
+// class LazyEvent
+//
+// An event whose dictionary is built by a callable when it is dispatched,
+// and only if a listener reads the dictionary.
+//=============================================================================
+typedef Delegate<EventDictionary&> EventPayloadBuilder;
+
+class LazyEvent : public Event
+{
+public:
+    LazyEvent(const EventId& inId, const EventPayloadBuilder& inBuilder);
+
+    virtual Event* clone() const;
+
+protected:
+    virtual void fillDictionary(EventDictionary& outDictionary) const;
+
+private:
+    EventPayloadBuilder mBuilder;
+};
+
+
+//=============================================================================
+// struct TypedEventTraits
+//
+// Converts a typed payload to and from the dictionary read by python and
+// untyped listeners. Specialize it for payloads those listeners need.
+//=============================================================================
+template <class Payload>
+struct TypedEventTraits
+{
+    static void toDictionary(const Payload& inPayload, EventDictionary& outDictionary)
+    {
+        Q_UNUSED(inPayload);
+        Q_UNUSED(outDictionary);
+    }
+
+    static bool fromDictionary(const EventDictionary& inDictionary, Payload& outPayload)
+    {
+        Q_UNUSED(inDictionary);
+        Q_UNUSED(outPayload);
+        return false;
+    }
+};
+
+
+//=============================================================================
+// struct TypedEventTag
+//
+// A unique address per payload type, stored in the events carrying it.
+//=============================================================================
+template <class Payload>
+struct TypedEventTag
+{
+    static const void* value() { static const char sTag = 0; return &sTag; }
+};
+
+
+//=============================================================================
+// class TypedEventId
+//
+// An EventId whose events carry a Payload. Untyped listeners connect to
+// it as a plain EventId.
+//=============================================================================
+template <class Payload>
+class TypedEventId : public EventId
+{
+public:
+    typedef Delegate<const Payload&> Callback;
+
+    TypedEventId() {}
+    TypedEventId(const QString& inId) : EventId(inId) {}
+};
+
+
+//=============================================================================
+// class TypedEvent
+//
+// An event passing its payload straight through to typed listeners. The
+// dictionary is only filled, through TypedEventTraits, when the event
+// reaches a python or untyped listener.
+//=============================================================================
+template <class Payload>
+class TypedEvent : public Event
+{
+public:
+    /// A default constructed payload, to be filled in place.
+    explicit TypedEvent(const TypedEventId<Payload>& inId)
+        :   Event(inId)
+    {
+        mPayloadType = TypedEventTag<Payload>::value();
+    }
+
+    TypedEvent(const TypedEventId<Payload>& inId, const Payload& inPayload)
+        :   Event(inId),
+            payload(inPayload)
+    {
+        mPayloadType = TypedEventTag<Payload>::value();
+    }
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    TypedEvent(const TypedEventId<Payload>& inId, Payload&& inPayload)
+        :   Event(inId),
+            payload(std::move(inPayload))
+    {
+        mPayloadType = TypedEventTag<Payload>::value();
+    }
+
+#ifdef Q_COMPILER_VARIADIC_TEMPLATES
+    /// The payload is constructed in place from inArgs.
+    struct InPlace {};
+
+    template <class... Args>
+    TypedEvent(const TypedEventId<Payload>& inId, InPlace, Args&&... inArgs)
+        :   Event(inId),
+            payload(std::forward<Args>(inArgs)...)
+    {
+        mPayloadType = TypedEventTag<Payload>::value();
+    }
+#endif
+#endif
+
+    virtual Event* clone() const { return new TypedEvent(*this); }
+
+    Payload payload;
+
+protected:
+    virtual void fillDictionary(EventDictionary& outDictionary) const
+    {
+        TypedEventTraits<Payload>::toDictionary(payload, outDictionary);
+    }
+};
+
+
+//=============================================================================
+// struct TypedCallback
+//
+// Adapts a typed listener to the event callback signal. Untyped events
+// posted to a typed id are converted with TypedEventTraits, or skipped
+// if the payload can not be recovered.
+//=============================================================================
+template <class Payload>
+struct TypedCallback
+{
+    explicit TypedCallback(const Delegate<const Payload&>& inCallback) : mCallback(inCallback) {}
+
+    void operator()(const Event& inEvent) const
+    {
+        if (inEvent.payloadType() == TypedEventTag<Payload>::value()) {
+            mCallback(static_cast<const TypedEvent<Payload>&>(inEvent).payload);
+        } else {
+            Payload payload;
+            if (TypedEventTraits<Payload>::fromDictionary(inEvent.dictionary, payload)) {
+                mCallback(payload);
+            }
+        }
+    }
+
+    Delegate<const Payload&> mCallback;
 };
 
 //=============================================================================
 // Event Notification
 //=============================================================================
-typedef boost::signal<void (const Event&)> EventCallbackSignal;
-typedef EventCallbackSignal::slot_function_type EventCallbackType;
+typedef Delegate<const Event&> EventDelegate;
+typedef Signal<const Event&> EventCallbackSignal;
+typedef EventDelegate EventCallbackType;
 typedef boost::shared_ptr<EventCallbackSignal> EventCallbackRefType;
 typedef unsigned int ConnectionId;
-typedef boost::signals::connection Connection;
+typedef EventCallbackSignal::SlotId Connection;
 typedef QList<ConnectionId> ConnectionList;
 
+
+//=============================================================================
+// struct ListenerProfile
+//=============================================================================
+/** Time spent in one listener, kept while listener profiling is on.
+    The name is the one given to connect(), or the qualified name of a
+    python method. Durations are in nanoseconds.
+ */
+struct ListenerProfile
+{
+    ListenerProfile()
+        :   connection(0),
+            eventHash(0),
+            calls(0),
+            totalNanoseconds(0),
+            maxNanoseconds(0)
+    {
+    }
+
+    void record(quint64 inNanoseconds);
+
+    ConnectionId connection;
+    unsigned int eventHash;
+    QString name;
+    quint64 calls;
+    quint64 totalNanoseconds;
+    quint64 maxNanoseconds;
+};
+
+typedef boost::shared_ptr<ListenerProfile> ListenerProfileRef;
+typedef QList<ListenerProfile> ListenerProfileList;
+typedef QHash<ConnectionId, ListenerProfileRef> ListenerProfileMap;
+
 //=============================================================================
 // struct EventCallback
 //=============================================================================
@@ -151,6 +392,9 @@ struct PythonFunctionInfo
     PyObject* functionMethod;
     PyObject* functionSelf;
     PyObject* functionClass;
+    bool connected;                             // Cleared by disconnect(), the info is dropped at the next commit
+    ConnectionId connection;                    // Names the listener in the trace
+    ListenerProfileRef profile;                 // Set while listeners are profiled
 };
 
 typedef boost::shared_ptr<PythonFunctionInfo> PythonFunctionInfoRef;
@@ -175,35 +419,67 @@ enum ConnectionType
 // struct ConnectionInfo
 //=============================================================================
 /** Internal data structure used by the Notification Center.
-    Handles the housekeeping of maintaining various signalling architectures.
+    The part of a connection that every signalling architecture shares.
+    The transport specific state lives in a separate table per
+    ConnectionType, so a connection only pays for what it uses.
  */
 struct ConnectionInfo
 {
     ConnectionInfo()
-        :   type(CONNECTION_TYPE_NONE),
-            connectionId(static_cast<ConnectionId>(-1)),
-            qtObject(NULL)
+        :   eventHash(0),
+            type(CONNECTION_TYPE_NONE)
     {
     }
 
-    // Connection state
-    EventId eventId;
+    ConnectionInfo(unsigned int inEventHash, ConnectionType inType)
+        :   eventHash(inEventHash),
+            type(inType)
+    {
+    }
+
+    unsigned int eventHash;
     ConnectionType type;
-    ConnectionId connectionId;
+};
+
 
-    // boost::signal info
-    Connection boostId;
-    EventCallbackType boostCallbackType;
+/**<
+ * @class BoostConnectionInfo
+ * @brief Callback connection state. The CONNECTION_TYPE_BOOST name
+ * predates EventCallbackSignal.
+ */
+struct BoostConnectionInfo
+{
+    BoostConnectionInfo() : connection(0), typed(false) {}
+
+    Connection connection;                      // Slot in the EventCallbackSignal of the event
+    bool typed;                                 // A TypedCallback, which never reads the dictionary
+};
+
+
+/**<
+ * @class QtConnectionInfo
+ * @brief Qt slot connection state. The slot signature is interned and
+ * shared by every connection to the same slot.
+ */
+struct QtConnectionInfo
+{
+    QPointer<QObject> receiver;
+    QByteArray slot;
+    EventCallbackType callback;                 // Called instead of a slot by member function and functor connections
+};
 
-    // Qt info
-    QString qtSignal;
-    QString qtMethod;
-    QObject* qtObject;
 
-    // Python info
-    PythonFunctionInfoRef pythonFunctionInfo;
+/**<
+ * @class PythonConnectionInfo
+ * @brief Python callable connection state. The function info is shared
+ * with the PythonFunctionList of the event.
+ */
+struct PythonConnectionInfo
+{
+    PythonFunctionInfoRef function;
 };
 
+
 /**<
  * @class EventRegistry
  * @brief Map of all registered events.
@@ -211,62 +487,560 @@ struct ConnectionInfo
 typedef QMap<unsigned int, EventId> EventRegistry;
 
 
-
 /**<
  * @class DeferredCallbackList
- * @brief List of deferred EventCallbackTypes to register.
+ * @brief List of deferred connections to make once an event is registered.
+ */
+typedef QList<ConnectionId> DeferredCallbackList;
+
+
+/**<
+ * @class DeferredEventInfo
+ * @brief An unregistered event and the connections waiting for it.
  */
-typedef QList<ConnectionInfo*> DeferredCallbackList;
+struct DeferredEventInfo
+{
+    EventId eventId;
+    DeferredCallbackList connections;
+};
 
 
 /**<
  * @class DeferredEventMap
  * @brief Map of events waiting to be connected.
  */
-typedef QMap<unsigned int, DeferredCallbackList> DeferredEventMap;
+typedef QHash<unsigned int, DeferredEventInfo> DeferredEventMap;
+
+
+/**<
+ * @class DeferredCallbackMap
+ * @brief boost callbacks held until their event is registered.
+ */
+typedef QHash<ConnectionId, EventCallbackType> DeferredCallbackMap;
+
+
+/**<
+ * @class StringPool
+ * @brief Interned strings shared between connections.
+ */
+typedef QSet<QByteArray> StringPool;
+
+
+//=============================================================================
+// struct QtSlotInvoker
+//=============================================================================
+/** A connected Qt slot. The slot index is resolved once when the slot is
+    connected and the slot is invoked directly through its metacall.
+    Member function and functor connections have no slot index and call
+    their callback instead, while the receiver is alive.
+ */
+struct QtSlotInvoker
+{
+    QtSlotInvoker() : connection(0), slotIndex(-1) {}
+
+    QtSlotInvoker(ConnectionId inConnection, QObject* inReceiver, int inSlotIndex)
+        :   connection(inConnection),
+            receiver(inReceiver),
+            slotIndex(inSlotIndex)
+    {
+    }
+
+    QtSlotInvoker(ConnectionId inConnection, QObject* inReceiver, const EventCallbackType& inCallback)
+        :   connection(inConnection),
+            receiver(inReceiver),
+            slotIndex(-1),
+            callback(inCallback)
+    {
+    }
+
+    void operator()(void** inArgs) const;
+
+    ConnectionId connection;
+    QPointer<QObject> receiver;                 // Cleared if the receiver is destroyed while connected
+    int slotIndex;
+    EventCallbackType callback;
+};
+
+
+//=============================================================================
+// struct QtMemberSlot
+//=============================================================================
+/** Calls a member function of a Qt receiver. The receiver is guarded by
+    the QtSlotInvoker of the connection, so a plain pointer is kept here.
+ */
+template <class T>
+struct QtMemberSlot
+{
+    typedef void (T::*Method)(const Event&);
+
+    QtMemberSlot(T* inReceiver, Method inMethod)
+        :   mReceiver(inReceiver),
+            mMethod(inMethod)
+    {
+    }
+
+    void operator()(const Event& inEvent) const
+    {
+        (mReceiver->*mMethod)(inEvent);
+    }
+
+    T* mReceiver;
+    Method mMethod;
+};
+
+
+/**<
+ * @class QtSlotInvokerList
+ * @brief The Qt slots of an event, in connection order.
+ */
+typedef QVector<QtSlotInvoker> QtSlotInvokerList;
 
 
 /**<
- * @class SignalTable
- * @brief Map of signals.
+ * @class KeyedListener
+ * @brief A listener subscribed to one key of a parametric event. Qt and
+ * python listeners are wrapped in the callback like boost ones.
  */
-typedef QHash<QByteArray, int> SignalTable;
+struct KeyedListener
+{
+    KeyedListener() : connection(0), type(CONNECTION_TYPE_NONE) {}
+
+    ConnectionId connection;
+    ConnectionType type;
+    EventCallbackType callback;
+};
+
+
+/**<
+ * @class KeyedListenerList
+ * @brief The listeners of one key, in connection order.
+ */
+typedef QVector<KeyedListener> KeyedListenerList;
+
+
+/**<
+ * @class KeyedListenerMap
+ * @brief Keyed listeners of an event based on the key.
+ */
+typedef QHash<quint64, KeyedListenerList> KeyedListenerMap;
+
 
 /**<
  * @class EventCallbackInfo
- * @brief boost::signal and qt::signal information.
+ * @brief Callback signal, Qt slot and python callable information.
  */
 struct EventCallbackInfo
 {
-    EventCallbackInfo() {}
+    EventCallbackInfo() : listenerCount(0), typedListenerCount(0) {}
+
+    EventCallbackRefType boostSignal;           // Created with the first boost connection
+    QtSlotInvokerList qtInvokers;
+    PythonFunctionList pythonFunctionList;
+    KeyedListenerMap keyedListeners;
+    int listenerCount;                          // Live connections of all types
+    int typedListenerCount;                     // Live typed connections, the others need the dictionary
+};
+
+
+/**<
+ * @class PendingChangeType
+ * @brief Topology changes that wait for the outermost dispatch to return.
+ */
+enum PendingChangeType
+{
+    PENDING_ATTACH,                             // Attach a connection to its event
+    PENDING_DETACH,                             // Release a disconnected listener
+    PENDING_RESOLVE_DEFERRED,                   // Attach the deferred connections of a registered event
+    PENDING_SEAL,                               // seal() called from a callback
+    PENDING_UNSEAL                              // unseal() called from a callback
+};
 
-    EventCallbackInfo(EventCallbackRefType inBoostSignal,
-                      const QString& inSlotSignature,
-                      const PythonFunctionList& inPythonFunctionList)
-        :   boostSignal(inBoostSignal),
-            qtSlotSignature(inSlotSignature),
-            pythonFunctionList(inPythonFunctionList)
+
+/**<
+ * @class PendingChange
+ * @brief A topology change queued while events are being dispatched.
+ */
+struct PendingChange
+{
+    PendingChange(PendingChangeType inType,
+                  const EventId& inEventId,
+                  ConnectionId inConnection = static_cast<ConnectionId>(-1),
+                  const PythonFunctionInfoRef& inPythonFunction = PythonFunctionInfoRef())
+        :   type(inType),
+            eventId(inEventId),
+            connection(inConnection),
+            pythonFunction(inPythonFunction),
+            keyed(false),
+            key(0)
     {
     }
 
-    EventCallbackRefType boostSignal;
-    QString qtSlotSignature;
-    PythonFunctionList pythonFunctionList;
+    PendingChangeType type;
+    EventId eventId;
+    ConnectionId connection;
+    PythonFunctionInfoRef pythonFunction;
+    bool keyed;                                 // Detaching a keyed listener
+    quint64 key;
 };
 
 
+/**<
+ * @class PendingChangeList
+ * @brief Topology changes in the order they were made.
+ */
+typedef QList<PendingChange> PendingChangeList;
+
+
 /**<
  * @class EventMap
- * @brief Map of all connected callabacks based on the EventId.
+ * @brief Map of all connected callabacks based on the EventId hash.
  */
-typedef QMap<EventId, EventCallbackInfo> EventMap;
+typedef QHash<unsigned int, EventCallbackInfo> EventMap;
 
 
 /**<
  * @class ConnectionMap
  * @brief Map of connection information based on connection id's.
  */
-typedef QMap<ConnectionId, ConnectionInfo> ConnectionMap;
+typedef QHash<ConnectionId, ConnectionInfo> ConnectionMap;
+typedef QHash<ConnectionId, BoostConnectionInfo> BoostConnectionMap;
+typedef QHash<ConnectionId, QtConnectionInfo> QtConnectionMap;
+typedef QHash<ConnectionId, PythonConnectionInfo> PythonConnectionMap;
+typedef QHash<ConnectionId, quint64> KeyedConnectionMap;
+
+
+/**<
+ * @class EventSignalInfo
+ * @brief The signal of a registered event in the meta object of the
+ * Notification Center.
+ */
+struct EventSignalInfo
+{
+    EventSignalInfo() : eventHash(0), connected(false) {}
+    explicit EventSignalInfo(unsigned int inEventHash) : eventHash(inEventHash), connected(false) {}
+
+    unsigned int eventHash;
+    bool connected;                             // Has a receiver connected with QObject::connect()
+};
+
+
+/**<
+ * @class EventSignalList
+ * @brief Event signals in the order of their signal index.
+ */
+typedef QVector<EventSignalInfo> EventSignalList;
+
+
+/**<
+ * @class SignalIndexMap
+ * @brief Local signal index based on the EventId hash.
+ */
+typedef QHash<unsigned int, int> SignalIndexMap;
+
+
+/**<
+ * @class EventLatency
+ * @brief How long the events of an EventId waited in the queue and how
+ * long their listeners took, in nanoseconds. Events posted with POST_NOW
+ * and sent events are not queued, so they only count towards dispatch.
+ * Only registered events and events with listeners are timed, until they
+ * are released.
+ */
+struct EventLatency
+{
+    LatencyHistogram queue;                     // From postEvent() until the dispatch starts
+    LatencyHistogram dispatch;                  // From the start of the dispatch until every listener returned
+    LatencyHistogram gilWait;                   // Taking the GIL before calling the Python listeners
+};
+
+
+/**<
+ * @class EventLatencyMap
+ * @brief Latency based on the EventId hash.
+ */
+typedef QHash<unsigned int, EventLatency> EventLatencyMap;
+
+
+/**<
+ * @class EventStatistics
+ * @brief Counters of one event, kept up to date as it is connected and
+ * dispatched. Only the thread of the Notification Center updates them, so
+ * they take no lock. Keyed connections are also counted with their
+ * ConnectionType.
+ */
+struct EventStatistics
+{
+    EventStatistics()
+        :   boostConnections(0),
+            qtConnections(0),
+            pythonConnections(0),
+            keyedConnections(0),
+            dispatched(0),
+            dequeued(0),
+            dropped(0),
+            suppressed(0),
+            unchanged(0)
+    {
+    }
+
+    QString stringId;
+    int boostConnections;
+    int qtConnections;
+    int pythonConnections;
+    int keyedConnections;
+    quint64 dispatched;                         // Delivered to the listeners, sent events included
+    quint64 dequeued;                           // Taken out of the event queue for dispatch
+    quint64 dropped;                            // Dispatched while no listener was connected
+    quint64 suppressed;                         // Refused by the cascade limits
+    quint64 unchanged;                          // State events not delivered as they changed nothing
+};
+
+
+/**<
+ * @class EventStatisticsMap
+ * @brief Event counters based on the EventId hash.
+ */
+typedef QHash<unsigned int, EventStatistics> EventStatisticsMap;
+
+
+/**<
+ * @class EventPostCounters
+ * @brief Counters of one event updated by postEvent(), which is called
+ * from any thread.
+ */
+struct EventPostCounters
+{
+    EventPostCounters()
+        :   posted(0),
+            queued(0),
+            coalesced(0),
+            deduplicated(0)
+    {
+    }
+
+    quint64 posted;                             // Posted with postEvent(), queued or not
+    quint64 queued;                             // Posted to the event queue
+    quint64 coalesced;                          // Held back for the coalescing timer
+    quint64 deduplicated;                       // Dropped as a copy of an event still queued
+};
+
+typedef QHash<unsigned int, EventPostCounters> EventPostCounterMap;
+
+
+/**<
+ * @class PostCounterShard
+ * @brief The post counters of one posting thread. Only that thread
+ * updates them, so their lock is contended only while a snapshot reads
+ * them.
+ */
+struct PostCounterShard
+{
+    QMutex mutex;
+    EventPostCounterMap counters;
+};
+
+typedef boost::shared_ptr<PostCounterShard> PostCounterShardRef;
+typedef QList<PostCounterShardRef> PostCounterShardList;
+
+
+/**<
+ * @class EventSnapshot
+ * @brief The state of one event, see NotificationCenter::eventSnapshots().
+ */
+struct EventSnapshot
+{
+    EventSnapshot()
+        :   eventHash(0),
+            registered(false),
+            publishers(0),
+            listeners(0),
+            deferredConnections(0),
+            posted(0),
+            queued(0),
+            coalesced(0),
+            deduplicated(0)
+    {
+    }
+
+    unsigned int eventHash;
+    bool registered;
+    int publishers;                             // Outstanding registerEvent() calls
+    int listeners;                              // Attached listeners of all types
+    int deferredConnections;                    // Connections waiting for the event to be registered
+    quint64 posted;                             // Posted with postEvent(), queued or not
+    int queued;                                 // Posted and waiting in the event queue
+    quint64 coalesced;
+    quint64 deduplicated;
+    EventStatistics statistics;
+    EventLatency latency;
+};
+
+typedef QList<EventSnapshot> EventSnapshotList;
+
+
+/**<
+ * @class CascadeTree
+ * @brief A root event and the events its listeners sent or posted,
+ * directly or not. The tree is open while one of its events dispatches
+ * or waits in the queue.
+ */
+struct CascadeTree
+{
+    CascadeTree()
+        :   rootHash(0),
+            events(0),
+            maxDepth(0),
+            nanoseconds(0),
+            suppressed(0),
+            dispatching(0),
+            queued(0),
+            warned(false)
+    {
+    }
+
+    unsigned int rootHash;
+    int events;                                 // Events dispatched
+    int maxDepth;
+    quint64 nanoseconds;                        // Time in the listeners, nested dispatches counted once
+    int suppressed;                             // Events refused by the cascade limits
+    int dispatching;                            // Events of the tree on the dispatch stack
+    int queued;                                 // Events of the tree waiting in the queue
+    bool warned;
+};
+
+typedef QHash<quint32, CascadeTree> CascadeTreeMap;
+
+
+/**<
+ * @class CascadeStatistics
+ * @brief The cascades started by one event, recorded as they close.
+ */
+struct CascadeStatistics
+{
+    CascadeStatistics()
+        :   trees(0),
+            events(0),
+            maxEvents(0),
+            maxDepth(0),
+            suppressed(0)
+    {
+    }
+
+    quint64 trees;
+    quint64 events;
+    int maxEvents;                              // Events of the largest tree
+    int maxDepth;
+    quint64 suppressed;
+    LatencyHistogram cost;                      // Nanoseconds per tree
+};
+
+typedef QHash<unsigned int, CascadeStatistics> CascadeStatisticsMap;
+
+
+/**<
+ * @class CycleHistory
+ * @brief How often each EventId hash appears on the path from an event
+ * to the root of its cascade.
+ */
+typedef QHash<unsigned int, int> CycleHistory;
+
+
+/**<
+ * @class DispatchFrame
+ * @brief A dispatch running on the thread of the Notification Center.
+ */
+struct DispatchFrame
+{
+    unsigned int eventHash;
+    quint32 serial;
+    quint32 rootSerial;
+    int cascadeDepth;
+    quint64 start;
+    quint64 nested;                             // Time of the dispatches nested in this one
+    int fanOut;                                 // Events posted or sent by the listeners
+    const CycleHistory* history;                // The path before the event was queued, NULL unless it was
+};
+
+typedef QVector<DispatchFrame> DispatchFrameList;
+
+
+/**<
+ * @class SlotRelayMap
+ * @brief Objects living in the threads of Qt receivers, which run the
+ * slot calls queued for those threads.
+ */
+typedef QHash<QThread*, QPointer<QObject> > SlotRelayMap;
+
+
+//=============================================================================
+// class PythonInvoker
+//=============================================================================
+/** A python callable resolved for a sealed dispatch plan. The bound
+    method is created once instead of on every dispatch.
+ */
+class PythonInvoker
+{
+public:
+    explicit PythonInvoker(const PythonFunctionInfoRef& inFunction);
+    ~PythonInvoker();
+
+    void operator()(const Event& inEvent) const;
+
+private:
+    // No copying allowed
+    PythonInvoker(const PythonInvoker& theValue);
+    PythonInvoker& operator=(const PythonInvoker& theValue);
+
+    PythonFunctionInfoRef mFunction;            // Shared with the connection, carries the connected flag
+    PyObject* mMethod;
+};
+
+typedef boost::shared_ptr<PythonInvoker> PythonInvokerRef;
+
+
+/**<
+ * @class DispatchPlan
+ * @brief The listeners of one event, compiled by NotificationCenter::seal().
+ */
+struct DispatchPlan
+{
+    DispatchPlan() : needsDictionary(false) {}
+
+    EventCallbackRefType boostSignal;
+    QtSlotInvokerList qtInvokers;
+    QVector<PythonInvokerRef> pythonInvokers;
+    bool needsDictionary;                       // Some listener reads the dictionary
+};
+
+
+/**<
+ * @class DispatchPlanMap
+ * @brief Dispatch plans based on the EventId hash.
+ */
+typedef QHash<unsigned int, DispatchPlan> DispatchPlanMap;
+
+
+/**<
+ * @class EventReferenceMap
+ * @brief Number of outstanding registerEvent() calls per event hash.
+ */
+typedef QHash<unsigned int, int> EventReferenceMap;
+
+
+/**<
+ * @class StickyEventMap
+ * @brief The last event dispatched for each sticky event hash, NULL
+ * until the first dispatch.
+ */
+typedef boost::shared_ptr<Event> StickyEventRef;
+typedef QHash<unsigned int, StickyEventRef> StickyEventMap;
+
+
+/**<
+ * @class StateEventMap
+ * @brief The full dictionary of each state event hash.
+ */
+typedef QHash<unsigned int, EventDictionary> StateEventMap;
 
 
 // Default name given to unanmed connections
@@ -286,6 +1060,7 @@ class NotificationCenter : public QObject
 {
 public:
     static framework::EventId EventRegistered;
+    static framework::EventId EventUnregistered;
     static framework::EventId EventConnected;
     static framework::EventId EventDisconnected;
 
@@ -309,29 +1084,112 @@ public:
 
     // QObject
     virtual bool event(QEvent* inEvent);
+    virtual const QMetaObject* metaObject() const;
+    virtual void* qt_metacast(const char* inClassName);
+    virtual int qt_metacall(QMetaObject::Call inCall, int inIndex, void** inArgs);
 
     // Event registration
     bool registerEvent(const EventId& inEventId);
+    bool unregisterEvent(const EventId& inEventId);
     EventIdSet registeredEvents() const;
 
     // Event dispatching
+    bool hasListeners(const EventId& inId) const;
+    void sendEvent(const Event& inEvent);
     void postEvent(const EventId& inId, PostType inPostType = POST_SOON);
     void postEvent(const EventId& inId, PostPriority inPriority, PostType inPostType = POST_SOON);
     void postEvent(Event* inEvent, PostType inPostType = POST_SOON);
     void postEvent(Event* inEvent, PostPriority inPriority, PostType inPostType = POST_SOON);
 
+    // The builder fills the dictionary at dispatch time, if anyone listens.
+    void postEvent(const EventId& inId, const EventPayloadBuilder& inBuilder, PostType inPostType = POST_SOON);
+    void postEvent(const EventId& inId, const EventPayloadBuilder& inBuilder, PostPriority inPriority, PostType inPostType = POST_SOON);
+
+    // Typed events pass their payload to typed listeners without a dictionary.
+    template <class Payload>
+    void postEvent(const TypedEventId<Payload>& inId, const Payload& inPayload, PostType inPostType = POST_SOON);
+    template <class Payload>
+    void postEvent(const TypedEventId<Payload>& inId, const Payload& inPayload, PostPriority inPriority, PostType inPostType = POST_SOON);
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    // Ownership passed explicitly, and payloads moved into the event.
+    void postEvent(std::unique_ptr<Event> inEvent, PostType inPostType = POST_SOON);
+    void postEvent(std::unique_ptr<Event> inEvent, PostPriority inPriority, PostType inPostType = POST_SOON);
+    template <class Payload>
+    void postEvent(const TypedEventId<Payload>& inId, Payload&& inPayload, PostType inPostType = POST_SOON);
+
+#ifdef Q_COMPILER_VARIADIC_TEMPLATES
+    // The payload is constructed in place inside the posted event.
+    template <class Payload, class... Args>
+    void emplaceEvent(const TypedEventId<Payload>& inId, Args&&... inArgs);
+#endif
+#endif
+
     // Connection management
 	ConnectionId connect(const EventId& inId, QObject* inReceiver, const char* inSlot, const std::string& inName = DEFAULT_CALLBACK_NAME);
     ConnectionId connect(const EventId& inId, EventCallbackType inCallback, const std::string& inName = DEFAULT_CALLBACK_NAME);
     ConnectionId connect(const EventId& inId, PyObject* inObject, const std::string& inName = DEFAULT_CALLBACK_NAME);
+
+    // Qt receivers without a slot signature, connect(id, object, &Class::method),
+    // and functors called for as long as their context object lives.
+    template <class T>
+    ConnectionId connect(const EventId& inId, T* inReceiver, void (T::*inMethod)(const Event&), const std::string& inName = DEFAULT_CALLBACK_NAME);
+    ConnectionId connect(const EventId& inId, QObject* inContext, EventCallbackType inCallback, const std::string& inName = DEFAULT_CALLBACK_NAME);
+
+    // Member function bound at compile time, connect<Class, &Class::method>(id, object)
+    template <class T, void (T::*Method)(const Event&)>
+    ConnectionId connect(const EventId& inId, T* inObject, const std::string& inName = DEFAULT_CALLBACK_NAME);
     ConnectionId connect(const QString& inId, PyObject* inObject, const std::string& inName = DEFAULT_CALLBACK_NAME);
 
+    // Typed listener, a callable taking const Payload&
+    template <class Payload>
+    ConnectionId connect(const TypedEventId<Payload>& inId, typename TypedEventId<Payload>::Callback inCallback, const std::string& inName = DEFAULT_CALLBACK_NAME);
+
+    // Keyed connections only receive events posted with their key.
+    ConnectionId connect(const EventId& inId, quint64 inKey, QObject* inReceiver, const char* inSlot, const std::string& inName = DEFAULT_CALLBACK_NAME);
+    ConnectionId connect(const EventId& inId, quint64 inKey, EventCallbackType inCallback, const std::string& inName = DEFAULT_CALLBACK_NAME);
+    ConnectionId connect(const EventId& inId, quint64 inKey, PyObject* inObject, const std::string& inName = DEFAULT_CALLBACK_NAME);
+
     void disconnect(const ConnectionId& inId);
     void disconnect(ConnectionList& inList);
 
+    // Sealed dispatch
+    void seal();
+    void unseal();
+    bool isSealed() const;
+
+    // Parallel fan-out of callback listeners, see setParallelDispatch()
+    void setParallelDispatch(const EventId& inId, bool inEnabled);
+    bool isParallelDispatch(const EventId& inId) const;
+
     int getCoalesceInterval() const;
     void setCoalesceInterval(int inAmount);
 
+    // Copies of queued events are dropped, see setDeduplicated()
+    void setDeduplicated(const EventId& inId, bool inEnabled);
+    bool isDeduplicated(const EventId& inId) const;
+
+    // State events delivered to listeners as they connect, see setSticky()
+    void setSticky(const EventId& inId, bool inEnabled);
+    bool isSticky(const EventId& inId) const;
+    const Event* lastEvent(const EventId& inId) const;
+
+    // State events dispatched with their changes only, see setStateEvent()
+    void setStateEvent(const EventId& inId, bool inEnabled);
+    bool isStateEvent(const EventId& inId) const;
+    const EventDictionary& currentState(const EventId& inId) const;
+
+    // Cascades of events sent by listeners, 0 means no limit, the default
+    void setMaxCascadeDepth(int inDepth);
+    int maxCascadeDepth() const;
+    void setMaxCascadeFanOut(int inFanOut);
+    int maxCascadeFanOut() const;
+    void setMaxCycleRepeats(int inRepeats);
+    int maxCycleRepeats() const;
+    CascadeStatistics cascadeStatistics(const EventId& inId) const;
+    QVariantList cascadeReport() const;
+    void resetCascades();
+
     // Diagnostics
     int registeredEventCount() const;
     int deferredEventCount() const;
@@ -343,43 +1201,174 @@ public:
     // Introspection
     const EventRegistry& getEventRegistry() const;
     void dumpRegisteredEvents() const;
+    EventSnapshotList eventSnapshots() const;
+    QVariantList eventSnapshotReport() const;
+    QByteArray eventSnapshotJson() const;
+
+    // Latency of posted events and of their listeners
+    EventLatency latency(const EventId& inId) const;
+    QVariantMap latencyStatistics(const EventId& inId) const;
+    void resetLatency();
+
+    // Time spent in each listener, see setListenerProfiling()
+    void setListenerProfiling(bool inEnabled);
+    bool isListenerProfiling() const;
+    ListenerProfileList listenerProfiles(int inCount = -1) const;
+    QVariantList listenerProfileReport(int inCount = -1) const;
+    void resetListenerProfiles();
 
     static QString connectionTypeToString(ConnectionType inType);
 
 protected:
     virtual void timerEvent(QTimerEvent* inEvent);
+    virtual void connectNotify(const char* inSignal);
+    virtual void disconnectNotify(const char* inSignal);
         
 private:
+    friend class NCEvent;
+
     // No copying allowed
     NotificationCenter(const NotificationCenter& theValue);
     NotificationCenter& operator=(const NotificationCenter& theValue);
 
-    // Dynamic signal and slot handling
-    bool connectDynamicSignal(ConnectionInfo& ioInfo);
-    bool emitDynamicSignal(const QString& inSignal, void** inArgs);
-
-    bool handleCustomEvent(QEvent* inEvent);
+    // Event signals in the meta object
+    void initMetaObject();
+    void addEventSignal(const EventId& inId);
+    int takeReleasedSignal();
+    void compactMetaStrings();
+    QByteArray eventSignalCode(int inIndex) const;
+    bool emitEventSignal(const Event& inEvent);
 
-    ConnectionInfo& addConnectionInfo(ConnectionType inType, const EventId& inId);
+    // Qt slot handling
+    int resolveQtSlot(const EventId& inId, const QtConnectionInfo& inInfo) const;
+    void emitQtSlots(const QtSlotInvokerList& inInvokers, const Event& inEvent);
+    void queueSlotCall(const QtSlotInvoker& inInvoker, QThread* inThread, const Event& inEvent);
 
-    void addDeferredEvent(const EventId& inId, ConnectionInfo& outInfoRef);
+    bool handleCustomEvent(QEvent* inEvent);
+    void dispatchEvent(const Event& inEvent, const CycleHistory* inHistory = NULL);
+    void queueEvent(Event* inEvent, PostPriority inPriority);
+    void deliverEvent(const Event& inEvent);
+
+    // Topology changes made while dispatching
+    struct DispatchScope;
+    bool isDispatching() const;
+    bool attachConnection(const EventId& inId, ConnectionId inConnection);
+    void detachListener(const PendingChange& inChange);
+    void commitPendingChanges();
+
+    // Sealed dispatch plans
+    void compileDispatchPlans();
+    void dispatchPlan(const DispatchPlan& inPlan, const Event& inEvent);
+    void topologyChanged();
+
+    // Callback fan-out
+    void emitCallbacks(EventCallbackSignal& ioSignal, const Event& inEvent);
+
+    ConnectionId connectCallback(const EventId& inId, const EventCallbackType& inCallback, bool inTyped, const std::string& inName);
+    static bool needsDictionary(const EventCallbackInfo& inInfo);
+
+    ConnectionId addConnectionInfo(ConnectionType inType, const EventId& inId, const std::string& inName);
+    void removeConnectionInfo(ConnectionId inId);
+    void addListenerProfile(ConnectionId inConnection, const ConnectionInfo& inInfo);
+    ListenerProfile* listenerProfile(ConnectionId inConnection) const;
+    EventStatistics& statisticsFor(const EventId& inId);
+    EventLatency* latencyFor(unsigned int inEventHash);
+    void countPost(const Event& inEvent, bool inQueued);
+    void countDuplicate(const Event& inEvent);
+    PostCounterShard* postCounterShard();
+    EventPostCounterMap postCounters() const;
+
+    // Deduplication
+    bool isDuplicate(const Event& inEvent);
+    void releaseContent(const Event& inEvent);
+    bool takeStateChanges(const Event& inEvent, EventDictionary& ioState);
+
+    // Cascades
+    bool admitEvent(const Event& inEvent, bool inQueued);
+    int cycleRepeats(unsigned int inEventHash) const;
+    CycleHistory cycleHistory() const;
+    void beginCascade(const Event& inEvent, quint64 inStart, const CycleHistory* inHistory);
+    void endCascade(quint64 inEnd);
+    void releaseQueuedCascade(quint32 inRootSerial);
+    void closeCascade(CascadeTreeMap::iterator inTree);
+    EventId eventIdForHash(unsigned int inHash) const;
+    const QByteArray& internString(const QByteArray& inString);
+
+    void addDeferredEvent(const EventId& inId, ConnectionId inConnection);
     void checkForAndConnectDeferredEvents(const EventId& inId);
-    bool connectQtEvent(const EventId& inId, ConnectionInfo& ioInfoRef);
+    void addListener(EventCallbackInfo& ioInfo, unsigned int inEventHash);
+    void removeListener(unsigned int inEventHash);
+    bool mayHaveListeners(unsigned int inEventHash) const;
+    void releaseEventIfUnused(unsigned int inEventHash);
+    void connectBoostEvent(const EventId& inId, ConnectionId inConnection, const EventCallbackType& inCallback);
+    ConnectionId addQtConnection(const EventId& inId, const QtConnectionInfo& inInfo, const std::string& inName);
+    bool connectQtEvent(const EventId& inId, ConnectionId inConnection);
+    void connectPythonEvent(const EventId& inId, ConnectionId inConnection);
+
+    // Keyed connections
+    ConnectionId addKeyedConnection(const EventId& inId, ConnectionId inConnection);
+    bool connectKeyedEvent(const EventId& inId, ConnectionId inConnection);
+    void dispatchKeyed(const EventCallbackInfo& inInfo, const Event& inEvent);
 	
 	void dumpMethods() const;
-	void dumpSignals() const;
-	void dumpConnectionMethods(const ConnectionInfo& inInfo) const;
+	void dumpConnectionMethods(const QtConnectionInfo& inInfo) const;
+
+    enum { kListenerFilterSize = 1024 };        // Power of two, the filter is indexed with a mask
+    enum { kParallelPartitionSize = 1024 };     // Fewest callbacks worth handing to another thread
 
-    typedef QPair<Event*, PostPriority> EventPriorityPair;
+    typedef QPair<NCEvent*, PostPriority> EventPriorityPair;
 	typedef QList<EventPriorityPair> EventList;
 
     // [TODO] We want to protect all of these with a mutex
     EventRegistry mEventRegistry;               // Contains all registered EventIds the Notification Center is aware of
+    EventReferenceMap mPublisherCounts;         // Outstanding registrations for each registered event
+    QList<int> mFreeEventTypes;                 // Event types released by unregistered events, reused first
     EventMap mEvents;
+    QAtomicInt mListenerFilter[kListenerFilterSize];    // Listeners per EventId hash bucket, zero means none, read from any thread
     DeferredEventMap mDeferredEvents;
-    SignalTable mQtSignalIndices;
     ConnectionId mConnectionIdCount;            // Not an index, but a running count.
     ConnectionMap mConnectionMap;
+    BoostConnectionMap mBoostConnections;
+    QtConnectionMap mQtConnections;
+    SlotRelayMap mSlotRelays;                   // Created with the first slot queued to each thread
+    QMetaObject mMetaObject;                    // QObject with a signal for every registered event
+    QByteArray mMetaStrings;                    // String data of mMetaObject
+    QVector<uint> mMetaData;                    // Method table of mMetaObject
+    EventSignalList mEventSignals;
+    SignalIndexMap mSignalIndices;
+    QList<int> mReleasedSignals;                // Signals of released events, renamed once nothing is connected
+    int mDeadMetaStrings;                       // Bytes of mMetaStrings no signal refers to
+    PythonConnectionMap mPythonConnections;
+    KeyedConnectionMap mKeyedConnections;       // Key of each keyed connection
+    DeferredCallbackMap mDeferredCallbacks;
+    StringPool mStringPool;                     // Slot signatures shared by Qt connections
+    int mDispatchDepth;                         // Nesting of handleCustomEvent()
+    PendingChangeList mPendingChanges;          // Applied when the outermost dispatch returns
+    DispatchPlanMap mDispatchPlans;
+    bool mSealed;
+    bool mPlansStale;                           // Topology changed since the plans were compiled
+    unsigned int mDisconnectCount;              // Lets a running plan notice disconnects made by its listeners
+    QSet<unsigned int> mParallelEvents;         // Events whose callbacks may run on the thread pool
+    StickyEventMap mStickyEvents;
+    EventLatencyMap mLatencies;
+    EventStatisticsMap mEventStatistics;
+    QThreadStorage<PostCounterShardRef*> mPostCounterShards;
+    PostCounterShardList mPostCounterShardList; // Guarded by mPostMutex, the shards of every posting thread
+    EventPostCounterMap mRetiredPostCounters;   // Guarded by mPostMutex, the shards of finished threads
+    mutable QMutex mPostMutex;
+    QSet<unsigned int> mDeduplicatedEvents;     // Guarded by mPostMutex
+    QAtomicInt mDeduplicatedCount;              // Size of mDeduplicatedEvents, read without the lock
+    QMultiHash<uint, const Event*> mQueuedContent;  // Guarded by mPostMutex, queued events by content hash
+    StateEventMap mStateEvents;                 // The state as of the last dispatch
+    ListenerProfileMap mListenerProfiles;       // Connections seen while profiling was on
+    QHash<ConnectionId, QString> mListenerNames;    // Names given to connect(), unnamed connections have none
+    bool mListenerProfiling;
+    DispatchFrameList mDispatchFrames;
+    CascadeTreeMap mCascadeTrees;               // Open cascades by the serial of their root
+    CascadeStatisticsMap mCascadeStatistics;    // Closed cascades by the EventId hash of their root
+    int mMaxCascadeDepth;
+    int mMaxCascadeFanOut;
+    int mMaxCycleRepeats;
     EventList mCoalesceList;
     int mCoalesceInterval;
     int mTimerId;
@@ -393,8 +1382,93 @@ inline int NotificationCenter::registeredEventCount() const { return mEventRegis
 inline int NotificationCenter::deferredEventCount() const { return mDeferredEvents.size(); }
 inline const EventRegistry& NotificationCenter::getEventRegistry() const { return mEventRegistry; }
 inline int NotificationCenter::getCoalesceInterval() const { return mCoalesceInterval; }
+inline int NotificationCenter::maxCascadeDepth() const { return mMaxCascadeDepth; }
+inline int NotificationCenter::maxCascadeFanOut() const { return mMaxCascadeFanOut; }
+inline int NotificationCenter::maxCycleRepeats() const { return mMaxCycleRepeats; }
+inline CascadeStatistics NotificationCenter::cascadeStatistics(const EventId& inId) const { return mCascadeStatistics.value(inId.getHash()); }
+inline EventLatency NotificationCenter::latency(const EventId& inId) const { return mLatencies.value(inId.getHash()); }
+inline bool NotificationCenter::isDispatching() const { return mDispatchDepth > 0; }
+inline bool NotificationCenter::isSealed() const { return mSealed; }
+inline bool NotificationCenter::isListenerProfiling() const { return mListenerProfiling; }
+inline bool NotificationCenter::isParallelDispatch(const EventId& inId) const { return mParallelEvents.contains(inId.getHash()); }
+inline bool NotificationCenter::isSticky(const EventId& inId) const { return mStickyEvents.contains(inId.getHash()); }
+inline const Event* NotificationCenter::lastEvent(const EventId& inId) const { return mStickyEvents.value(inId.getHash()).get(); }
+inline bool NotificationCenter::isStateEvent(const EventId& inId) const { return mStateEvents.contains(inId.getHash()); }
+inline void NotificationCenter::topologyChanged() { mPlansStale = true; }
+inline bool NotificationCenter::mayHaveListeners(unsigned int inEventHash) const { return mListenerFilter[inEventHash & (kListenerFilterSize - 1)] != 0; }
+inline bool NotificationCenter::needsDictionary(const EventCallbackInfo& inInfo) { return inInfo.listenerCount > inInfo.typedListenerCount; }
+
+template <class T, void (T::*Method)(const Event&)>
+inline ConnectionId
+NotificationCenter::connect(const EventId& inId, T* inObject, const std::string& inName)
+{
+    return connect(inId, EventDelegate::fromMethod<T, Method>(inObject), inName);
+}
+
+template <class T>
+inline ConnectionId
+NotificationCenter::connect(const EventId& inId, T* inReceiver, void (T::*inMethod)(const Event&), const std::string& inName)
+{
+    return connect(inId, static_cast<QObject*>(inReceiver), EventCallbackType(QtMemberSlot<T>(inReceiver, inMethod)), inName);
+}
+
+template <class Payload>
+inline void
+NotificationCenter::postEvent(const TypedEventId<Payload>& inId, const Payload& inPayload, PostType inPostType)
+{
+    postEvent(new TypedEvent<Payload>(inId, inPayload), inPostType);
+}
+
+template <class Payload>
+inline void
+NotificationCenter::postEvent(const TypedEventId<Payload>& inId, const Payload& inPayload, PostPriority inPriority, PostType inPostType)
+{
+    postEvent(new TypedEvent<Payload>(inId, inPayload), inPriority, inPostType);
+}
+
+#ifdef Q_COMPILER_RVALUE_REFS
+inline void
+NotificationCenter::postEvent(std::unique_ptr<Event> inEvent, PostType inPostType)
+{
+    postEvent(inEvent.release(), inPostType);
+}
+
+inline void
+NotificationCenter::postEvent(std::unique_ptr<Event> inEvent, PostPriority inPriority, PostType inPostType)
+{
+    postEvent(inEvent.release(), inPriority, inPostType);
+}
+
+template <class Payload>
+inline void
+NotificationCenter::postEvent(const TypedEventId<Payload>& inId, Payload&& inPayload, PostType inPostType)
+{
+    postEvent(new TypedEvent<Payload>(inId, std::move(inPayload)), inPostType);
+}
+
+#ifdef Q_COMPILER_VARIADIC_TEMPLATES
+template <class Payload, class... Args>
+inline void
+NotificationCenter::emplaceEvent(const TypedEventId<Payload>& inId, Args&&... inArgs)
+{
+    typedef typename TypedEvent<Payload>::InPlace InPlace;
+    postEvent(new TypedEvent<Payload>(inId, InPlace(), std::forward<Args>(inArgs)...));
+}
+#endif
+#endif
+
+template <class Payload>
+inline ConnectionId
+NotificationCenter::connect(const TypedEventId<Payload>& inId, typename TypedEventId<Payload>::Callback inCallback, const std::string& inName)
+{
+    return connectCallback(inId, TypedCallback<Payload>(inCallback), true, inName);
+}
     
 } // namespace framework
 
+// Lets queued connections to the event signals copy the event. The copy
+// is a plain Event, typed and lazy events only pass on their dictionary.
+Q_DECLARE_METATYPE(framework::Event)
+
 #endif // AF_NC_HAS_BEEN_INCLUDED
 
@@ -34,28 +34,28 @@ THE SOFTWARE.
     do { \
 		std::ostringstream _buf; \
 		_buf << logEvent; \
-		std::cout << "DEBUG: " << logEvent << std::endl; \
+		std::cout << "DEBUG: " << _buf.str() << std::endl; \
     } while (0); 
 
 #define LOG_INFO(logEvent) \
     do { \
 		std::ostringstream _buf; \
 		_buf << logEvent; \
-		std::cout << "INFO: " << logEvent << std::endl; \
+		std::cout << "INFO: " << _buf.str() << std::endl; \
     } while (0);
     
 #define LOG_WARN(logEvent) \
     do { \
 		std::ostringstream _buf; \
 		_buf << logEvent; \
-		std::cout << "WARNING: " << logEvent << std::endl; \
+		std::cout << "WARNING: " << _buf.str() << std::endl; \
     } while (0);   
 
 #define LOG_ERROR(logEvent) \
     do { \
 		std::ostringstream _buf; \
 		_buf << logEvent; \
-		std::cout << "ERROR: " << logEvent << std::endl; \
+		std::cout << "ERROR: " << _buf.str() << std::endl; \
     } while (0);   
 #else
 #include <logging_base/logging.h>
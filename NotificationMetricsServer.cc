@@ -0,0 +1,439 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "NotificationMetricsServer.h"
+
+// Qt
+#include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+// Local
+#include "NotificationCenter.h"
+
+
+// Namespaces
+using namespace framework;
+
+// Constants
+static const int kMaxRequestSize = 8192;
+static const int kProbeTimeout = 100;  // in milliseconds
+static const double kNanosecondsPerSecond = 1e9;
+static const double kQuantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+
+//-----------------------------------------------------------------------------
+// escapeLabel()
+//
+/// Escape a label value of the Prometheus text format.
+//-----------------------------------------------------------------------------
+static QByteArray
+escapeLabel(const QString& inValue)
+{
+    QByteArray result = inValue.toUtf8();
+    result.replace('\\', "\\\\");
+    result.replace('"', "\\\"");
+    result.replace('\n', "\\n");
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// writeHeader()
+//
+/// Append the HELP and TYPE lines of a metric.
+//-----------------------------------------------------------------------------
+static void
+writeHeader(const char* inName, const char* inType, const char* inHelp, QByteArray& ioText)
+{
+    ioText.append("# HELP ").append(inName).append(' ').append(inHelp).append('\n');
+    ioText.append("# TYPE ").append(inName).append(' ').append(inType).append('\n');
+}
+
+
+//-----------------------------------------------------------------------------
+// writeSample()
+//
+/// Append one sample of a metric labelled with the event.
+//-----------------------------------------------------------------------------
+static void
+writeSample(const char* inName, const QByteArray& inLabels, const QByteArray& inValue, QByteArray& ioText)
+{
+    ioText.append(inName).append('{').append(inLabels).append("} ").append(inValue).append('\n');
+}
+
+
+//-----------------------------------------------------------------------------
+// writeSummary()
+//
+/// Append a latency histogram as a summary in seconds.
+//-----------------------------------------------------------------------------
+static void
+writeSummary(const char* inName, const QByteArray& inLabels, const LatencyHistogram& inHistogram, QByteArray& ioText)
+{
+    if (inHistogram.count() == 0)
+        return;
+
+    for (size_t index = 0; index < sizeof(kQuantiles) / sizeof(kQuantiles[0]); ++index) {
+        const double seconds = inHistogram.percentile(kQuantiles[index] * 100.0) / kNanosecondsPerSecond;
+        QByteArray labels = inLabels;
+        labels.append(",quantile=\"").append(QByteArray::number(kQuantiles[index])).append('"');
+        writeSample(inName, labels, QByteArray::number(seconds, 'g', 9), ioText);
+    }
+
+    const QByteArray name(inName);
+    writeSample(name + "_sum", inLabels, QByteArray::number(inHistogram.total() / kNanosecondsPerSecond, 'g', 12), ioText);
+    writeSample(name + "_count", inLabels, QByteArray::number(inHistogram.count()), ioText);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::NotificationMetricsServer()
+//
+/// Create a server for a Notification Center, in the thread of the
+/// Notification Center. It does not listen until listenOnPort() or
+/// listenOnSocket() is called.
+/// \param inCenter The Notification Center to report on.
+/// \param inParent The parent object.
+//-----------------------------------------------------------------------------
+NotificationMetricsServer::NotificationMetricsServer(NotificationCenter* inCenter, QObject* inParent)
+    :   QObject(inParent),
+        mCenter(inCenter),
+        mTcpServer(NULL),
+        mLocalServer(NULL)
+{
+    Q_ASSERT(inCenter != NULL);
+    Q_ASSERT(inCenter->thread() == thread());
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::~NotificationMetricsServer()
+//
+/// Default destructor
+//-----------------------------------------------------------------------------
+NotificationMetricsServer::~NotificationMetricsServer()
+{
+    close();
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::listenOnPort()
+//
+/// Listen on a port of the loopback interface. Only local scrapers can
+/// connect.
+/// \param inPort The port, or 0 to pick a free one.
+/// \result True if the server listens.
+//-----------------------------------------------------------------------------
+bool
+NotificationMetricsServer::listenOnPort(quint16 inPort)
+{
+    if (mTcpServer == NULL) {
+        mTcpServer = new QTcpServer(this);
+        connect(mTcpServer, SIGNAL(newConnection()), this, SLOT(acceptConnections()));
+    }
+
+    if (!mTcpServer->listen(QHostAddress::LocalHost, inPort)) {
+        mErrorString = mTcpServer->errorString();
+        return false;
+    }
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::listenOnSocket()
+//
+/// Listen on a local socket. On Unix an absolute name is the path of the
+/// Unix domain socket. A socket file left by a crash is removed, one a
+/// running server still answers on is not.
+/// \param inName The name of the socket.
+/// \result True if the server listens.
+//-----------------------------------------------------------------------------
+bool
+NotificationMetricsServer::listenOnSocket(const QString& inName)
+{
+    if (mLocalServer == NULL) {
+        mLocalServer = new QLocalServer(this);
+        connect(mLocalServer, SIGNAL(newConnection()), this, SLOT(acceptConnections()));
+    }
+
+    // Only a socket nobody accepts on is stale.
+    QLocalSocket probe;
+    probe.connectToServer(inName);
+    if (probe.waitForConnected(kProbeTimeout)) {
+        probe.disconnectFromServer();
+        mErrorString = QString("%1 is in use by a running server").arg(inName);
+        return false;
+    }
+    QLocalServer::removeServer(inName);
+
+    if (!mLocalServer->listen(inName)) {
+        mErrorString = mLocalServer->errorString();
+        return false;
+    }
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::close()
+//
+/// Stop listening. Scrapes in progress are answered.
+//-----------------------------------------------------------------------------
+void
+NotificationMetricsServer::close()
+{
+    if (mTcpServer != NULL) {
+        mTcpServer->close();
+    }
+    if (mLocalServer != NULL) {
+        mLocalServer->close();
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::isListening()
+//
+/// \result True if the server listens on a port or a local socket.
+//-----------------------------------------------------------------------------
+bool
+NotificationMetricsServer::isListening() const
+{
+    return (mTcpServer != NULL && mTcpServer->isListening())
+        || (mLocalServer != NULL && mLocalServer->isListening());
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::errorString()
+//
+/// \result Why the last call to listen failed.
+//-----------------------------------------------------------------------------
+QString
+NotificationMetricsServer::errorString() const
+{
+    return mErrorString;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::metrics()
+//
+/// Return the metrics of a Notification Center in the Prometheus text
+/// format, one sample per event and metric. Latency is reported in
+/// seconds as summaries. Only call from the thread of the Notification
+/// Center.
+/// \param inCenter The Notification Center.
+/// \result The metrics.
+//-----------------------------------------------------------------------------
+QByteArray
+NotificationMetricsServer::metrics(const NotificationCenter& inCenter)
+{
+    const EventSnapshotList snapshots = inCenter.eventSnapshots();
+
+    QList<QByteArray> labels;
+    Q_FOREACH(const EventSnapshot& snapshot, snapshots) {
+        labels.push_back("event=\"" + escapeLabel(snapshot.statistics.stringId) + '"');
+    }
+
+    QByteArray text;
+
+    writeHeader("notification_events_posted_total", "counter", "Events posted, queued or not.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_events_posted_total", labels.at(index), QByteArray::number(snapshots.at(index).posted), text);
+    }
+
+    writeHeader("notification_events_dispatched_total", "counter", "Events delivered to their listeners, sent events included.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_events_dispatched_total", labels.at(index), QByteArray::number(snapshots.at(index).statistics.dispatched), text);
+    }
+
+    writeHeader("notification_events_dropped_total", "counter", "Events dispatched while no listener was connected.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_events_dropped_total", labels.at(index), QByteArray::number(snapshots.at(index).statistics.dropped), text);
+    }
+
+    writeHeader("notification_events_suppressed_total", "counter", "Events cut by the cascade limits.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_events_suppressed_total", labels.at(index), QByteArray::number(snapshots.at(index).statistics.suppressed), text);
+    }
+
+    writeHeader("notification_events_coalesced_total", "counter", "Events held back for the coalescing timer.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_events_coalesced_total", labels.at(index), QByteArray::number(snapshots.at(index).coalesced), text);
+    }
+
+    writeHeader("notification_events_deduplicated_total", "counter", "Events dropped as copies of an event still queued.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_events_deduplicated_total", labels.at(index), QByteArray::number(snapshots.at(index).deduplicated), text);
+    }
+
+    writeHeader("notification_events_unchanged_total", "counter", "State events not delivered as they changed nothing.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_events_unchanged_total", labels.at(index), QByteArray::number(snapshots.at(index).statistics.unchanged), text);
+    }
+
+    writeHeader("notification_event_queue_depth", "gauge", "Events posted and waiting in the event queue.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_event_queue_depth", labels.at(index), QByteArray::number(snapshots.at(index).queued), text);
+    }
+
+    writeHeader("notification_event_listeners", "gauge", "Listeners attached to the event.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSample("notification_event_listeners", labels.at(index), QByteArray::number(snapshots.at(index).listeners), text);
+    }
+
+    writeHeader("notification_event_queue_seconds", "summary", "Time from postEvent() until the dispatch starts.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSummary("notification_event_queue_seconds", labels.at(index), snapshots.at(index).latency.queue, text);
+    }
+
+    writeHeader("notification_event_dispatch_seconds", "summary", "Time until every listener of the event returned.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSummary("notification_event_dispatch_seconds", labels.at(index), snapshots.at(index).latency.dispatch, text);
+    }
+
+    writeHeader("notification_python_gil_wait_seconds", "summary", "Time spent taking the GIL before calling the Python listeners.", text);
+    for (int index = 0; index < snapshots.size(); ++index) {
+        writeSummary("notification_python_gil_wait_seconds", labels.at(index), snapshots.at(index).latency.gilWait, text);
+    }
+
+    return text;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::acceptConnections()
+//
+/// Start reading the requests of new scrapers.
+//-----------------------------------------------------------------------------
+void
+NotificationMetricsServer::acceptConnections()
+{
+    QList<QIODevice*> sockets;
+    while (mTcpServer != NULL && mTcpServer->hasPendingConnections()) {
+        QTcpSocket* socket = mTcpServer->nextPendingConnection();
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+        sockets.push_back(socket);
+    }
+    while (mLocalServer != NULL && mLocalServer->hasPendingConnections()) {
+        QLocalSocket* socket = mLocalServer->nextPendingConnection();
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+        sockets.push_back(socket);
+    }
+
+    Q_FOREACH(QIODevice* socket, sockets) {
+        mRequests.insert(socket, QByteArray());
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+        connect(socket, SIGNAL(destroyed(QObject*)), this, SLOT(forgetRequest(QObject*)));
+        if (socket->bytesAvailable() > 0) {
+            respond(socket);
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::readRequest()
+//
+/// Read the request of a scraper and answer once its header is complete.
+//-----------------------------------------------------------------------------
+void
+NotificationMetricsServer::readRequest()
+{
+    QIODevice* socket = qobject_cast<QIODevice*>(sender());
+    if (socket == NULL || !mRequests.contains(socket))
+        return;
+
+    respond(socket);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::forgetRequest()
+//
+/// Drop the request of a scraper that went away before it was answered.
+//-----------------------------------------------------------------------------
+void
+NotificationMetricsServer::forgetRequest(QObject* inSocket)
+{
+    mRequests.remove(inSocket);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationMetricsServer::respond()
+//
+/// Append the available bytes to the request of a connection and answer
+/// it once the header ends. Anything but a GET of / or /metrics gets an
+/// error status. The connection is closed after the answer.
+/// \param ioSocket The connection of the scraper.
+//-----------------------------------------------------------------------------
+void
+NotificationMetricsServer::respond(QIODevice* ioSocket)
+{
+    QByteArray& request = mRequests[ioSocket];
+    request.append(ioSocket->readAll());
+
+    const bool complete = request.contains("\r\n\r\n") || request.contains("\n\n");
+    if (!complete && request.size() < kMaxRequestSize)
+        return;
+
+    const QList<QByteArray> requestLine = request.left(request.indexOf('\n')).trimmed().split(' ');
+    mRequests.remove(ioSocket);
+    disconnect(ioSocket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+
+    QByteArray status("200 OK");
+    QByteArray body;
+    if (!complete) {
+        status = "431 Request Header Fields Too Large";
+    } else if (requestLine.size() < 2 || requestLine.at(0) != "GET") {
+        status = "405 Method Not Allowed";
+    } else if (requestLine.at(1) != "/" && requestLine.at(1) != "/metrics") {
+        status = "404 Not Found";
+    } else {
+        body = metrics(*mCenter);
+    }
+
+    QByteArray response("HTTP/1.0 ");
+    response.append(status).append("\r\n");
+    response.append("Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n");
+    response.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+    response.append("Connection: close\r\n\r\n");
+    response.append(body);
+    ioSocket->write(response);
+
+    // Both disconnect once the answer is written.
+    if (QTcpSocket* tcpSocket = qobject_cast<QTcpSocket*>(ioSocket)) {
+        tcpSocket->disconnectFromHost();
+    } else if (QLocalSocket* localSocket = qobject_cast<QLocalSocket*>(ioSocket)) {
+        localSocket->disconnectFromServer();
+    }
+}
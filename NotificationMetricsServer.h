@@ -0,0 +1,94 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef AF_NC_METRICS_SERVER_HAS_BEEN_INCLUDED
+#define AF_NC_METRICS_SERVER_HAS_BEEN_INCLUDED
+
+// Qt
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+
+namespace framework {
+
+class NotificationCenter;
+
+
+//=============================================================================
+// class NotificationMetricsServer
+//
+/// Serves the health of a Notification Center in the Prometheus text
+/// format, for scrapers outside the process. It listens on a loopback
+/// port or a local socket (a Unix domain socket on Unix) and answers
+/// "GET /metrics" with metrics(), for instance:
+///
+///     curl --unix-socket /tmp/notifications.sock http://localhost/metrics
+///
+/// The server lives in the thread of the Notification Center, so the
+/// counters are read between dispatches and the listeners never wait
+/// for a scrape. Rates are left to Prometheus, which derives them from
+/// the counters.
+//=============================================================================
+class NotificationMetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NotificationMetricsServer(NotificationCenter* inCenter, QObject* inParent = NULL);
+    virtual ~NotificationMetricsServer();
+
+    bool listenOnPort(quint16 inPort);
+    bool listenOnSocket(const QString& inName);
+    void close();
+    bool isListening() const;
+    QString errorString() const;
+
+    static QByteArray metrics(const NotificationCenter& inCenter);
+
+private Q_SLOTS:
+    void acceptConnections();
+    void readRequest();
+    void forgetRequest(QObject* inSocket);
+
+private:
+    NotificationMetricsServer(const NotificationMetricsServer&);
+    NotificationMetricsServer& operator=(const NotificationMetricsServer&);
+
+    void respond(QIODevice* ioSocket);
+
+    NotificationCenter* mCenter;
+    QTcpServer* mTcpServer;
+    QLocalServer* mLocalServer;
+    QString mErrorString;
+    QHash<QObject*, QByteArray> mRequests;      // Request read so far on each open connection
+};
+
+} // namespace framework
+
+#endif // AF_NC_METRICS_SERVER_HAS_BEEN_INCLUDED
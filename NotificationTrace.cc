@@ -0,0 +1,684 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "NotificationTrace.h"
+
+// Boost
+#include <boost/shared_ptr.hpp>
+
+// Qt
+#include <QAtomicInt>
+#include <QDataStream>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThreadStorage>
+#include <QVariant>
+
+// System
+#include <algorithm>
+
+// Local
+#include "JsonWriter.h"
+#include "MonotonicClock.h"
+
+
+// Namespaces
+using namespace framework;
+
+// Constants
+static const quint32 kTraceMagic = 0x4E435452;     // "NCTR"
+static const quint32 kTraceVersion = 2;           // Version 1 had no record arguments
+static const int kMaxTraceBuffers = 64;
+
+// Static members
+volatile bool NotificationTrace::sEnabled = true;
+
+
+namespace {
+
+//=============================================================================
+// class TraceBuffer
+//
+/// The ring buffer of one thread. Only the owning thread appends, and it
+/// publishes each record by bumping the write count. Readers copy without
+/// a lock and drop whatever the writer may have overwritten meanwhile.
+//=============================================================================
+class TraceBuffer
+{
+public:
+    enum { kCapacity = 4096, kMask = kCapacity - 1 };
+
+    //-----------------------------------------------------------------------------
+    // TraceBuffer::TraceBuffer()
+    //
+    /// Constructor.
+    /// \param inThread The number stamped on the records of the buffer.
+    //-----------------------------------------------------------------------------
+    explicit TraceBuffer(quint16 inThread)
+        :   mThread(inThread),
+            mWritten(0)
+    {
+    }
+
+    //-----------------------------------------------------------------------------
+    // TraceBuffer::append()
+    //
+    /// Write a record. Called by the owning thread only.
+    //-----------------------------------------------------------------------------
+    void
+    append(TraceOperation inOperation, quint32 inEventHash, quint32 inConnection, quint32 inArgument)
+    {
+        const quint32 index = quint32(int(mWritten));
+        TraceRecord& record = mRecords[index & kMask];
+        record.timestamp = monotonicNanoseconds();
+        record.eventHash = inEventHash;
+        record.connection = inConnection;
+        record.operation = quint16(inOperation);
+        record.thread = mThread;
+        record.argument = inArgument;
+        mWritten.fetchAndStoreRelease(int(index + 1));
+    }
+
+    //-----------------------------------------------------------------------------
+    // TraceBuffer::copyTo()
+    //
+    /// Append the records still held by the buffer, oldest first.
+    //-----------------------------------------------------------------------------
+    void
+    copyTo(TraceRecordList& outRecords)
+    {
+        const quint32 end = quint32(mWritten.fetchAndAddAcquire(0));
+        quint32 begin = end > quint32(kCapacity) ? end - kCapacity : 0;
+
+        TraceRecordList copied;
+        copied.reserve(end - begin);
+        for (quint32 index = begin; index != end; ++index) {
+            copied.push_back(mRecords[index & kMask]);
+        }
+
+        // The slot of the record being written holds the oldest record we
+        // copied, so everything from there up to the current count may be
+        // torn.
+        const quint32 after = quint32(mWritten.fetchAndAddAcquire(0));
+        if (after + 1 > begin + kCapacity) {
+            const quint32 torn = qMin(after + 1 - kCapacity - begin, end - begin);
+            copied.remove(0, int(torn));
+        }
+        outRecords += copied;
+    }
+
+    //-----------------------------------------------------------------------------
+    // TraceBuffer::clear()
+    //
+    /// Forget the records. Only safe while the owning thread is not writing.
+    //-----------------------------------------------------------------------------
+    void
+    clear()
+    {
+        mWritten.fetchAndStoreRelease(0);
+    }
+
+private:
+    TraceRecord mRecords[kCapacity];
+    quint16 mThread;
+    QAtomicInt mWritten;
+};
+
+typedef boost::shared_ptr<TraceBuffer> TraceBufferRef;    /**< @class TraceBufferRef @brief */
+
+
+//=============================================================================
+// struct TraceRegistry
+//
+/// Every trace buffer and the names of the traced events. The lock is
+/// only taken when a thread records for the first time and when the
+/// trace is read.
+//=============================================================================
+struct TraceRegistry
+{
+    TraceRegistry() : nextThread(0) {}
+
+    QMutex mutex;
+    QList<TraceBufferRef> buffers;
+    TraceNameMap names;
+    quint16 nextThread;
+};
+
+
+//-----------------------------------------------------------------------------
+// registry()
+//
+/// Function static, so static event ids of other translation units find
+/// the registry constructed.
+//-----------------------------------------------------------------------------
+TraceRegistry&
+registry()
+{
+    static TraceRegistry sRegistry;
+    return sRegistry;
+}
+
+
+//-----------------------------------------------------------------------------
+// threadBuffer()
+//
+/// Return the trace buffer of the current thread, creating it on first
+/// use. The registry shares the buffer so its records outlive the thread.
+/// Buffers of finished threads are dropped, oldest first, once there are
+/// more than kMaxTraceBuffers.
+//-----------------------------------------------------------------------------
+TraceBuffer*
+threadBuffer()
+{
+    static QThreadStorage<TraceBufferRef*> sThreadBuffers;
+
+    TraceBufferRef* buffer = sThreadBuffers.localData();
+    if (buffer == NULL) {
+        TraceRegistry& traceRegistry = registry();
+        QMutexLocker locker(&traceRegistry.mutex);
+
+        if (traceRegistry.buffers.size() >= kMaxTraceBuffers) {
+            for (int i = 0; i < traceRegistry.buffers.size(); ++i) {
+                if (traceRegistry.buffers.at(i).use_count() == 1) {
+                    traceRegistry.buffers.removeAt(i);
+                    break;
+                }
+            }
+        }
+
+        buffer = new TraceBufferRef(new TraceBuffer(traceRegistry.nextThread++));
+        traceRegistry.buffers.push_back(*buffer);
+        sThreadBuffers.setLocalData(buffer);
+    }
+    return buffer->get();
+}
+
+
+//-----------------------------------------------------------------------------
+// listenerTypeName()
+//
+/// Name the ConnectionType stored in the argument of listener records.
+//-----------------------------------------------------------------------------
+const char*
+listenerTypeName(quint32 inType)
+{
+    switch (inType) {
+        case 1:     return "callback";
+        case 2:     return "qt";
+        case 4:     return "python";
+        default:    return "unknown";
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// chromeEvent()
+//
+/// Start a Chrome trace event of a record.
+//-----------------------------------------------------------------------------
+QVariantMap
+chromeEvent(const char* inPhase, const TraceRecord& inRecord, quint64 inOrigin)
+{
+    QVariantMap event;
+    event["ph"] = inPhase;
+    event["pid"] = 1;
+    event["tid"] = inRecord.thread;
+    event["ts"] = double(inRecord.timestamp - inOrigin) / 1000.0;
+    return event;
+}
+
+
+//-----------------------------------------------------------------------------
+// earlierRecord()
+//
+/// Order records by time.
+//-----------------------------------------------------------------------------
+bool
+earlierRecord(const TraceRecord& inLeft, const TraceRecord& inRight)
+{
+    return inLeft.timestamp < inRight.timestamp;
+}
+
+} // namespace
+
+
+//=============================================================================
+// class NotificationTrace
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::setEnabled()
+//
+/// Turn recording on or off. Threads in the middle of recording may still
+/// write a record after it is turned off.
+/// \param inEnabled True to record.
+//-----------------------------------------------------------------------------
+void
+NotificationTrace::setEnabled(bool inEnabled)
+{
+    sEnabled = inEnabled;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::record()
+//
+/// Write a record into the ring buffer of the current thread. Use the
+/// NC_TRACE macro instead, which checks isEnabled() first and can be
+/// compiled out.
+/// \param inOperation What happened.
+/// \param inEventHash The hash of the EventId.
+/// \param inConnection The ConnectionId, 0 for records of no connection.
+/// \param inArgument The serial of the event or the listener ConnectionType.
+//-----------------------------------------------------------------------------
+void
+NotificationTrace::record(TraceOperation inOperation, quint32 inEventHash, quint32 inConnection, quint32 inArgument)
+{
+    threadBuffer()->append(inOperation, inEventHash, inConnection, inArgument);
+}
+
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::nameEvent()
+//
+/// Remember the string id of an event hash, so the decoder can print it.
+/// Called when an event is registered.
+/// \param inEventHash The hash of the EventId.
+/// \param inName The string id of the EventId.
+//-----------------------------------------------------------------------------
+void
+NotificationTrace::nameEvent(quint32 inEventHash, const QString& inName)
+{
+    TraceRegistry& traceRegistry = registry();
+    QMutexLocker locker(&traceRegistry.mutex);
+    traceRegistry.names.insert(inEventHash, inName);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::snapshot()
+//
+/// Copy the records of every thread, in the order they were written.
+/// \result The records.
+//-----------------------------------------------------------------------------
+TraceRecordList
+NotificationTrace::snapshot()
+{
+    TraceRecordList result;
+
+    TraceRegistry& traceRegistry = registry();
+    QMutexLocker locker(&traceRegistry.mutex);
+    Q_FOREACH(const TraceBufferRef& buffer, traceRegistry.buffers) {
+        buffer->copyTo(result);
+    }
+    locker.unlock();
+
+    std::stable_sort(result.begin(), result.end(), earlierRecord);
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::eventNames()
+//
+/// Return the string ids of the registered events by hash.
+//-----------------------------------------------------------------------------
+TraceNameMap
+NotificationTrace::eventNames()
+{
+    TraceRegistry& traceRegistry = registry();
+    QMutexLocker locker(&traceRegistry.mutex);
+    return traceRegistry.names;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::clear()
+//
+/// Forget every record. Meant for tests and for marking the start of a
+/// measurement while no other thread records.
+//-----------------------------------------------------------------------------
+void
+NotificationTrace::clear()
+{
+    TraceRegistry& traceRegistry = registry();
+    QMutexLocker locker(&traceRegistry.mutex);
+    Q_FOREACH(const TraceBufferRef& buffer, traceRegistry.buffers) {
+        buffer->clear();
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::write()
+//
+/// Write a snapshot of the trace and the event names to a file, to be
+/// turned into text by the decoder.
+/// \param inPath The file to write.
+/// \result False if the file could not be written.
+//-----------------------------------------------------------------------------
+bool
+NotificationTrace::write(const QString& inPath)
+{
+    const TraceRecordList records = snapshot();
+    const TraceNameMap names = eventNames();
+
+    QFile file(inPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << kTraceMagic << kTraceVersion;
+
+    stream << quint32(names.size());
+    for (TraceNameMap::const_iterator iter = names.constBegin(); iter != names.constEnd(); ++iter) {
+        stream << iter.key() << iter.value();
+    }
+
+    stream << quint32(records.size());
+    Q_FOREACH(const TraceRecord& record, records) {
+        stream << record.timestamp
+               << record.eventHash
+               << record.connection
+               << record.operation
+               << record.thread
+               << record.argument;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::read()
+//
+/// Read a file written by write().
+/// \param inPath The file to read.
+/// \param outRecords Receives the records.
+/// \param outNames Receives the event names.
+/// \result False if the file is not a trace or is truncated.
+//-----------------------------------------------------------------------------
+bool
+NotificationTrace::read(const QString& inPath, TraceRecordList& outRecords, TraceNameMap& outNames)
+{
+    QFile file(inPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != kTraceMagic || version == 0 || version > kTraceVersion)
+        return false;
+
+    quint32 nameCount = 0;
+    stream >> nameCount;
+    for (quint32 i = 0; i < nameCount && stream.status() == QDataStream::Ok; ++i) {
+        quint32 hash = 0;
+        QString name;
+        stream >> hash >> name;
+        outNames.insert(hash, name);
+    }
+
+    quint32 recordCount = 0;
+    stream >> recordCount;
+    for (quint32 i = 0; i < recordCount && stream.status() == QDataStream::Ok; ++i) {
+        TraceRecord record;
+        stream >> record.timestamp
+               >> record.eventHash
+               >> record.connection
+               >> record.operation
+               >> record.thread;
+        record.argument = 0;
+        if (version >= 2) {
+            stream >> record.argument;
+        }
+        outRecords.push_back(record);
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::operationName()
+//
+/// Return the name of a TraceOperation.
+//-----------------------------------------------------------------------------
+const char*
+NotificationTrace::operationName(quint16 inOperation)
+{
+    switch (inOperation) {
+        case TRACE_POST:            return "post";
+        case TRACE_POST_NOW:        return "post_now";
+        case TRACE_SEND:            return "send";
+        case TRACE_DISPATCH_BEGIN:  return "dispatch_begin";
+        case TRACE_DISPATCH_END:    return "dispatch_end";
+        case TRACE_CONNECT:         return "connect";
+        case TRACE_DISCONNECT:      return "disconnect";
+        case TRACE_REGISTER:        return "register";
+        case TRACE_UNREGISTER:      return "unregister";
+        case TRACE_LISTENER_BEGIN:  return "listener_begin";
+        case TRACE_LISTENER_END:    return "listener_end";
+        default:                    return "unknown";
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::describe()
+//
+/// Turn a record into a line of text.
+/// \param inRecord The record.
+/// \param inNames The event names, events without one print their hash.
+/// \param inOrigin Subtracted from the timestamp, usually the timestamp
+/// of the first record.
+/// \result The text, for example
+/// "12.345 us  thread 0  post  com.example.Event".
+//-----------------------------------------------------------------------------
+QString
+NotificationTrace::describe(const TraceRecord& inRecord,
+                            const TraceNameMap& inNames,
+                            quint64 inOrigin)
+{
+    const QString eventName = inNames.value(inRecord.eventHash,
+                                            QString("0x%1").arg(inRecord.eventHash, 8, 16, QChar('0')));
+
+    QString result = QString("%1 us  thread %2  %3  %4")
+        .arg(double(inRecord.timestamp - inOrigin) / 1000.0, 0, 'f', 3)
+        .arg(inRecord.thread)
+        .arg(operationName(inRecord.operation))
+        .arg(eventName);
+
+    if (inRecord.operation == TRACE_CONNECT || inRecord.operation == TRACE_DISCONNECT) {
+        result += QString("  connection %1").arg(inRecord.connection);
+    } else if (inRecord.operation == TRACE_LISTENER_BEGIN || inRecord.operation == TRACE_LISTENER_END) {
+        result += QString("  %1 connection %2").arg(listenerTypeName(inRecord.argument)).arg(inRecord.connection);
+    } else if (inRecord.argument != 0) {
+        result += QString("  serial %1").arg(inRecord.argument);
+    }
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::toChromeTrace()
+//
+/// Convert records to the Chrome Trace Event format. Every trace buffer
+/// becomes a thread lane with the dispatches and listener calls as nested
+/// slices, so POST_NOW cascades show up stacked. Posts are linked to their
+/// dispatch by a flow arrow and the time in the queue by an async slice.
+/// \param inRecords The records, in the order they were written.
+/// \param inNames The event names, events without one show their hash.
+/// \result The JSON document.
+//-----------------------------------------------------------------------------
+QByteArray
+NotificationTrace::toChromeTrace(const TraceRecordList& inRecords, const TraceNameMap& inNames)
+{
+    const quint64 origin = inRecords.isEmpty() ? 0 : inRecords.first().timestamp;
+
+    QVariantList events;
+    QSet<quint16> threads;
+    QSet<quint32> posted;                       // Serials of the posts seen, which flows start from
+    QSet<quint32> queued;                       // Serials of the posts waiting in the queue
+    Q_FOREACH(const TraceRecord& record, inRecords) {
+        if (!threads.contains(record.thread)) {
+            threads.insert(record.thread);
+
+            QVariantMap args;
+            args["name"] = QString("Thread %1").arg(record.thread);
+            QVariantMap metadata = chromeEvent("M", record, origin);
+            metadata.remove("ts");
+            metadata["name"] = "thread_name";
+            metadata["args"] = args;
+            events.push_back(metadata);
+        }
+
+        const QString eventName = inNames.value(record.eventHash,
+                                                QString("0x%1").arg(record.eventHash, 8, 16, QChar('0')));
+        QVariantMap args;
+        args["event"] = eventName;
+
+        switch (record.operation) {
+            case TRACE_DISPATCH_BEGIN:
+            case TRACE_DISPATCH_END: {
+                const bool begin = (record.operation == TRACE_DISPATCH_BEGIN);
+                QVariantMap event = chromeEvent(begin ? "B" : "E", record, origin);
+                event["cat"] = "dispatch";
+                event["name"] = eventName;
+                events.push_back(event);
+
+                if (begin && posted.remove(record.argument)) {
+                    QVariantMap flow = chromeEvent("f", record, origin);
+                    flow["cat"] = "post";
+                    flow["name"] = "post";
+                    flow["id"] = record.argument;
+                    flow["bp"] = "e";
+                    events.push_back(flow);
+                }
+
+                if (begin && queued.remove(record.argument)) {
+                    QVariantMap wait = chromeEvent("e", record, origin);
+                    wait["cat"] = "queue";
+                    wait["name"] = eventName;
+                    wait["id"] = record.argument;
+                    events.push_back(wait);
+                }
+            }
+            break;
+
+            case TRACE_LISTENER_BEGIN:
+            case TRACE_LISTENER_END: {
+                QVariantMap event = chromeEvent(record.operation == TRACE_LISTENER_BEGIN ? "B" : "E", record, origin);
+                event["cat"] = "listener";
+                event["name"] = QString("%1 %2").arg(listenerTypeName(record.argument)).arg(record.connection);
+                args["connection"] = record.connection;
+                event["args"] = args;
+                events.push_back(event);
+            }
+            break;
+
+            case TRACE_POST:
+            case TRACE_POST_NOW: {
+                // Flows start from a slice, so the post gets a short one.
+                QVariantMap event = chromeEvent("X", record, origin);
+                event["cat"] = "post";
+                event["name"] = operationName(record.operation);
+                event["dur"] = 0.001;
+                event["args"] = args;
+                events.push_back(event);
+
+                if (record.argument != 0) {
+                    posted.insert(record.argument);
+
+                    QVariantMap flow = chromeEvent("s", record, origin);
+                    flow["cat"] = "post";
+                    flow["name"] = "post";
+                    flow["id"] = record.argument;
+                    events.push_back(flow);
+
+                    if (record.operation == TRACE_POST) {
+                        queued.insert(record.argument);
+
+                        QVariantMap wait = chromeEvent("b", record, origin);
+                        wait["cat"] = "queue";
+                        wait["name"] = eventName;
+                        wait["id"] = record.argument;
+                        events.push_back(wait);
+                    }
+                }
+            }
+            break;
+
+            default: {
+                QVariantMap event = chromeEvent("i", record, origin);
+                event["cat"] = "notification";
+                event["name"] = operationName(record.operation);
+                event["s"] = "t";
+                if (record.operation == TRACE_CONNECT || record.operation == TRACE_DISCONNECT) {
+                    args["connection"] = record.connection;
+                }
+                event["args"] = args;
+                events.push_back(event);
+            }
+            break;
+        }
+    }
+
+    QVariantMap trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ns";
+    return toJson(trace);
+}
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::writeChromeTrace()
+//
+/// Write a snapshot of the trace to a file in the Chrome Trace Event
+/// format. Turn recording on with setEnabled() and clear() the trace to
+/// start the window to capture.
+/// \param inPath The file to write.
+/// \result False if the file could not be written.
+//-----------------------------------------------------------------------------
+bool
+NotificationTrace::writeChromeTrace(const QString& inPath)
+{
+    const QByteArray json = toChromeTrace(snapshot(), eventNames());
+
+    QFile file(inPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    return file.write(json) == json.size();
+}
@@ -0,0 +1,195 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef AF_NC_TRACE_HAS_BEEN_INCLUDED
+#define AF_NC_TRACE_HAS_BEEN_INCLUDED
+
+// Qt
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Define this to compile the trace points out of the notification center.
+//#define NC_DISABLE_TRACE
+
+namespace framework {
+
+//=============================================================================
+// enum TraceOperation
+//
+/// What a trace record describes.
+//=============================================================================
+enum TraceOperation
+{
+    TRACE_POST = 1,         ///< An event was posted to the queue.
+    TRACE_POST_NOW,         ///< An event was posted for immediate delivery.
+    TRACE_SEND,             ///< A caller owned event was sent.
+    TRACE_DISPATCH_BEGIN,   ///< The listeners of an event are about to be called.
+    TRACE_DISPATCH_END,     ///< The listeners of an event returned.
+    TRACE_CONNECT,          ///< A connection was made.
+    TRACE_DISCONNECT,       ///< A connection was removed.
+    TRACE_REGISTER,         ///< An event was registered.
+    TRACE_UNREGISTER,       ///< An event was unregistered.
+    TRACE_LISTENER_BEGIN,   ///< A listener is about to be called.
+    TRACE_LISTENER_END,     ///< A listener returned.
+    TRACE_OPERATION_COUNT
+};
+
+
+//=============================================================================
+// struct TraceRecord
+//
+/// One fixed size entry of the trace. Nothing is formatted when it is
+/// written, the decoder turns records into text.
+//=============================================================================
+struct TraceRecord
+{
+    quint64 timestamp;      ///< Nanoseconds of monotonicNanoseconds().
+    quint32 eventHash;      ///< The hash of the EventId.
+    quint32 connection;     ///< The ConnectionId of connect, disconnect and listener records.
+    quint16 operation;      ///< A TraceOperation.
+    quint16 thread;         ///< The trace buffer, one per thread.
+    quint32 argument;       ///< The Event::serial of post and dispatch records, or the ConnectionType of a listener.
+};
+
+typedef QVector<TraceRecord> TraceRecordList;               /**< @class TraceRecordList @brief */
+typedef QHash<quint32, QString> TraceNameMap;               /**< @class TraceNameMap @brief */
+
+
+//=============================================================================
+// class NotificationTrace
+//
+/// Binary trace of the notification center. Every thread writes into a
+/// ring buffer of its own, so recording takes no lock and only keeps the
+/// most recent records. The buffers are read with snapshot() or written
+/// to a file with write(), which the decoder in tracedecode turns into
+/// text. writeChromeTrace() writes the Chrome Trace Event format instead,
+/// for chrome://tracing or Perfetto.
+//=============================================================================
+class NotificationTrace
+{
+public:
+    static bool isEnabled();
+    static void setEnabled(bool inEnabled);
+
+    static void record(TraceOperation inOperation, quint32 inEventHash, quint32 inConnection, quint32 inArgument = 0);
+    static void nameEvent(quint32 inEventHash, const QString& inName);
+
+    static TraceRecordList snapshot();
+    static TraceNameMap eventNames();
+    static void clear();
+
+    static bool write(const QString& inPath);
+    static bool read(const QString& inPath, TraceRecordList& outRecords, TraceNameMap& outNames);
+
+    static QByteArray toChromeTrace(const TraceRecordList& inRecords, const TraceNameMap& inNames);
+    static bool writeChromeTrace(const QString& inPath);
+
+    static const char* operationName(quint16 inOperation);
+    static QString describe(const TraceRecord& inRecord,
+                            const TraceNameMap& inNames,
+                            quint64 inOrigin = 0);
+
+private:
+    static volatile bool sEnabled;
+};
+
+
+//=============================================================================
+// class TraceScope
+//
+/// Records the beginning of an operation and its end when leaving the
+/// scope. Both records carry the same connection and argument.
+//=============================================================================
+class TraceScope
+{
+public:
+    TraceScope(TraceOperation inBegin,
+               TraceOperation inEnd,
+               quint32 inEventHash,
+               quint32 inConnection = 0,
+               quint32 inArgument = 0)
+        :   mEnd(inEnd),
+            mEventHash(inEventHash),
+            mConnection(inConnection),
+            mArgument(inArgument)
+    {
+        if (NotificationTrace::isEnabled()) {
+            NotificationTrace::record(inBegin, inEventHash, inConnection, inArgument);
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (NotificationTrace::isEnabled()) {
+            NotificationTrace::record(mEnd, mEventHash, mConnection, mArgument);
+        }
+    }
+
+private:
+    TraceScope(const TraceScope& );
+    TraceScope& operator=(const TraceScope& );
+
+    TraceOperation mEnd;
+    quint32 mEventHash;
+    quint32 mConnection;
+    quint32 mArgument;
+};
+
+
+//-----------------------------------------------------------------------------
+// NotificationTrace::isEnabled()
+//
+/// Whether records are written. Tracing is on unless turned off.
+//-----------------------------------------------------------------------------
+inline bool NotificationTrace::isEnabled() { return sEnabled; }
+
+} // namespace framework
+
+
+// Trace points. They compile to nothing with NC_DISABLE_TRACE.
+#ifndef NC_DISABLE_TRACE
+#define NC_TRACE(inOperation, inEventHash, inConnection) \
+    do { \
+        if (framework::NotificationTrace::isEnabled()) \
+            framework::NotificationTrace::record(inOperation, inEventHash, inConnection); \
+    } while (0)
+#define NC_TRACE_ARG(inOperation, inEventHash, inConnection, inArgument) \
+    do { \
+        if (framework::NotificationTrace::isEnabled()) \
+            framework::NotificationTrace::record(inOperation, inEventHash, inConnection, inArgument); \
+    } while (0)
+#define NC_TRACE_SCOPE(inBegin, inEnd, inEventHash) \
+    framework::TraceScope _traceScope(inBegin, inEnd, inEventHash)
+#define NC_TRACE_SCOPE_ARG(inBegin, inEnd, inEventHash, inConnection, inArgument) \
+    framework::TraceScope _traceScope(inBegin, inEnd, inEventHash, inConnection, inArgument)
+#else
+#define NC_TRACE(inOperation, inEventHash, inConnection) ((void)0)
+#define NC_TRACE_ARG(inOperation, inEventHash, inConnection, inArgument) ((void)0)
+#define NC_TRACE_SCOPE(inBegin, inEnd, inEventHash) ((void)0)
+#define NC_TRACE_SCOPE_ARG(inBegin, inEnd, inEventHash, inConnection, inArgument) ((void)0)
+#endif
+
+#endif // AF_NC_TRACE_HAS_BEEN_INCLUDED
@@ -398,6 +398,19 @@ QtForPython_HashToPython(const QHash<QString, QVariant>& source)
 }
 
 
+PyObject*
+QtForPython_DictionaryToPython(const framework::EventDictionary& source)
+{
+    AccumToPyDict convert;
+    framework::EventDictionary::const_iterator ii;
+    for (ii = source.constBegin(); ii != source.constEnd(); ++ii)
+        convert(ii);
+
+    //Note: mPyDict will be NULL if an error occurred.
+    return *convert.mPyDict;
+}
+
+
 PyObject *
 QtForPython_QStringSetToPyList(const QSet<QString>& source)
 {
@@ -35,6 +35,8 @@ THE SOFTWARE.
 
 #include <boost/any.hpp>
 
+#include "EventDictionary.h"
+
 
 // Python
 struct _object;
@@ -64,6 +66,12 @@ QtForPython_MapToPython(const QMap<QString, QVariant>& source);
 PyObject*
 QtForPython_HashToPython(const QHash<QString, QVariant>& source);
 
+/**
+   convert an event dictionary to a py dict
+*/
+PyObject*
+QtForPython_DictionaryToPython(const framework::EventDictionary& source);
+
 //This may throw if python returns an error
 PyObject * QtForPython_StringVecToPyList(const std::vector<std::string>& source);
 
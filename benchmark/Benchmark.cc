@@ -0,0 +1,79 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// System
+#include <cstdio>
+#include <sys/time.h>
+
+#if defined(Q_OS_MAC) || defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// heapBytesInUse()
+//
+/// Bytes currently allocated from the heap by the process.
+//-----------------------------------------------------------------------------
+size_t
+heapBytesInUse()
+{
+#if defined(Q_OS_MAC) || defined(__APPLE__)
+    return mstats().bytes_used;
+#else
+    return static_cast<size_t>(mallinfo().uordblks);
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkSeconds()
+//
+/// Wall clock time in seconds, for measuring intervals.
+//-----------------------------------------------------------------------------
+double
+benchmarkSeconds()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec * 1.0e-6;
+}
+
+
+//-----------------------------------------------------------------------------
+// reportResult()
+//
+/// Print one benchmark result line.
+//-----------------------------------------------------------------------------
+void
+reportResult(const char* inBenchmark, const char* inMeasure, double inValue, const char* inUnit)
+{
+    std::printf("%-32s %-40s %14.2f %s\n", inBenchmark, inMeasure, inValue, inUnit);
+    std::fflush(stdout);
+}
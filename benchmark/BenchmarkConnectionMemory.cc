@@ -0,0 +1,142 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// Qt
+#include <QList>
+#include <QString>
+
+// Local, found through the include path so the benchmark also builds
+// against other revisions, see connection_memory.pro.
+#include "BindToEvent.h"
+#include "NotificationCenter.h"
+#include "BenchmarkReceiver.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+// Constants
+static const int kConnectionCount = 200000;
+static const int kEventCount = 1000;
+static const char* kBenchmarkName = "connection_memory";
+
+
+//-----------------------------------------------------------------------------
+// makeEventIds()
+//
+/// Create and register the events the connections are spread over.
+//-----------------------------------------------------------------------------
+static QList<EventId>
+makeEventIds(NotificationCenter& inCenter)
+{
+    QList<EventId> eventIds;
+    for (int index = 0; index < kEventCount; ++index) {
+        EventId eventId(QString("com.mightytoad.benchmark.memory.%1").arg(index));
+        inCenter.registerEvent(eventId);
+        eventIds.push_back(eventId);
+    }
+    return eventIds;
+}
+
+
+//-----------------------------------------------------------------------------
+// measureQt()
+//
+/// Heap used by live Qt connections, including the dynamic connections.
+//-----------------------------------------------------------------------------
+static void
+measureQt(BenchmarkReceiver* inReceiver)
+{
+    NotificationCenter center;
+    const QList<EventId> eventIds = makeEventIds(center);
+
+    const size_t before = heapBytesInUse();
+
+    QList<ConnectionId> connections;
+    connections.reserve(kConnectionCount);
+    for (int index = 0; index < kConnectionCount; ++index) {
+        connections.push_back(center.connect(eventIds.at(index % kEventCount),
+                                             inReceiver,
+                                             "qtCallback(const framework::Event&)"));
+    }
+
+    reportResult(kBenchmarkName, "qt bytes/connection",
+                 double(heapBytesInUse() - before) / kConnectionCount, "B");
+
+    Q_FOREACH(ConnectionId connectionId, connections) {
+        center.disconnect(connectionId);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// measureBoost()
+//
+/// Heap used by live boost connections, including the signal slots.
+//-----------------------------------------------------------------------------
+static void
+measureBoost(BenchmarkReceiver* inReceiver)
+{
+    NotificationCenter center;
+    const QList<EventId> eventIds = makeEventIds(center);
+
+    const size_t before = heapBytesInUse();
+
+    QList<ConnectionId> connections;
+    connections.reserve(kConnectionCount);
+    for (int index = 0; index < kConnectionCount; ++index) {
+        connections.push_back(center.connect(eventIds.at(index % kEventCount),
+                                             BindToEvent(BenchmarkReceiver::boostCallback, inReceiver)));
+    }
+
+    reportResult(kBenchmarkName, "boost bytes/connection",
+                 double(heapBytesInUse() - before) / kConnectionCount, "B");
+
+    Q_FOREACH(ConnectionId connectionId, connections) {
+        center.disconnect(connectionId);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkConnectionMemory()
+//
+/// Heap cost of a connection, measured over kConnectionCount connections
+/// spread across kEventCount events. Everything the center allocates for
+/// the connections counts, not only the connection records. Only API
+/// every revision has is used, so building connection_memory.pro against
+/// an older checkout measures it the same way.
+//-----------------------------------------------------------------------------
+void
+benchmarkConnectionMemory()
+{
+    BenchmarkReceiver receiver;
+
+    measureBoost(&receiver);
+    measureQt(&receiver);
+}
@@ -0,0 +1,117 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// Qt
+#include <QHash>
+#include <QString>
+#include <QVariant>
+
+// Local
+#include "../EventDictionary.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+// Constants
+static const int kEventCount = 1000000;
+static const char* kBenchmarkName = "event_dictionary";
+
+static const EventKey kIdKey("id");
+static const EventKey kTypeKey("type");
+static const EventKey kNodeKey("node");
+static const EventKey kValueKey("value");
+
+// Globals
+static int gChecksum = 0;
+
+
+//-----------------------------------------------------------------------------
+// measureHash()
+//
+/// A four key payload built and read the way events used to carry it.
+//-----------------------------------------------------------------------------
+static void
+measureHash()
+{
+    const QString id("id");
+    const QString type("type");
+    const QString node("node");
+    const QString value("value");
+
+    gChecksum = 0;
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kEventCount; ++index) {
+        QHash<QString, QVariant> dictionary;
+        dictionary[id] = index;
+        dictionary[type] = 1;
+        dictionary[node] = index;
+        dictionary[value] = 2;
+        gChecksum += dictionary.value(node).toInt() + dictionary.value(value).toInt();
+    }
+    const double elapsed = benchmarkSeconds() - start;
+
+    reportResult(kBenchmarkName, "QHash ns/event", elapsed / kEventCount * 1.0e9, "ns");
+}
+
+
+//-----------------------------------------------------------------------------
+// measureDictionary()
+//
+/// The same payload in an EventDictionary with interned keys.
+//-----------------------------------------------------------------------------
+static void
+measureDictionary()
+{
+    gChecksum = 0;
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kEventCount; ++index) {
+        EventDictionary dictionary;
+        dictionary[kIdKey] = index;
+        dictionary[kTypeKey] = 1;
+        dictionary[kNodeKey] = index;
+        dictionary[kValueKey] = 2;
+        gChecksum += dictionary.value(kNodeKey).toInt() + dictionary.value(kValueKey).toInt();
+    }
+    const double elapsed = benchmarkSeconds() - start;
+
+    reportResult(kBenchmarkName, "EventDictionary ns/event", elapsed / kEventCount * 1.0e9, "ns");
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkEventDictionary()
+//
+/// Cost of building and reading a small event payload.
+//-----------------------------------------------------------------------------
+void
+benchmarkEventDictionary()
+{
+    measureHash();
+    measureDictionary();
+}
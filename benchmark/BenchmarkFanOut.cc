@@ -0,0 +1,187 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// Qt
+#include <QString>
+
+// System
+#include <cstdio>
+#include <vector>
+
+// Local
+#include "../BindToEvent.h"
+#include "../NotificationCenter.h"
+#include "../NotificationTrace.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+// Constants
+static const EventId sFanOutId("com.mightytoad.benchmark.fanout");
+static const int kCallsPerMeasure = 2000000;
+static const int kListenerCounts[] = { 10, 100, 1000, 10000, 100000 };
+static const char* kBenchmarkName = "fan_out";
+
+
+//-----------------------------------------------------------------------------
+// struct FanOutListener
+//
+/// A listener with some state of its own, so each call touches the
+/// listener's memory as real observers do.
+//-----------------------------------------------------------------------------
+struct FanOutListener
+{
+    FanOutListener() : mCount(0) {}
+
+    void callback(const Event& inEvent)
+    {
+        Q_UNUSED(inEvent);
+        ++mCount;
+    }
+
+    int mCount;
+    char mPadding[60];
+};
+
+
+//-----------------------------------------------------------------------------
+// measureFanOut()
+//
+/// Time per listener of dispatching an event to inListenerCount callbacks.
+//-----------------------------------------------------------------------------
+static void
+measureFanOut(int inListenerCount, bool inSealed, bool inParallel)
+{
+    NotificationCenter center;
+    center.registerEvent(sFanOutId);
+    center.setParallelDispatch(sFanOutId, inParallel);
+
+    std::vector<FanOutListener> listeners(inListenerCount);
+    ConnectionList connections;
+    for (int index = 0; index < inListenerCount; ++index) {
+        connections.push_back(center.connect(sFanOutId, BindToEvent(FanOutListener::callback, &listeners[index])));
+    }
+
+    if (inSealed) {
+        center.seal();
+    }
+
+    const Event event(sFanOutId);
+    center.sendEvent(event);
+
+    const int dispatchCount = qMax(10, kCallsPerMeasure / inListenerCount);
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < dispatchCount; ++index) {
+        center.sendEvent(event);
+    }
+    const double elapsed = benchmarkSeconds() - start;
+
+    // A partition that skipped or repeated listeners would flatter the
+    // parallel numbers.
+    for (int index = 0; index < inListenerCount; ++index) {
+        if (listeners[index].mCount != dispatchCount + 1) {
+            std::fprintf(stderr, "fan_out: listener %d was called %d times, expected %d\n",
+                         index, listeners[index].mCount, dispatchCount + 1);
+            break;
+        }
+    }
+
+    const QString measure = QString("%1 ns/listener (%2 listeners)")
+        .arg(inParallel ? "parallel" : (inSealed ? "sealed" : "generic"))
+        .arg(inListenerCount);
+    reportResult(kBenchmarkName, qPrintable(measure), elapsed / dispatchCount / inListenerCount * 1.0e9, "ns");
+
+    center.unseal();
+    center.disconnect(connections);
+}
+
+
+//-----------------------------------------------------------------------------
+// measureConnectDisconnect()
+//
+/// Time per connection of connecting inListenerCount callbacks one by one,
+/// then disconnecting them one by one, oldest first. Disconnecting from
+/// the front of the listener list is the case that shifts the most.
+//-----------------------------------------------------------------------------
+static void
+measureConnectDisconnect(int inListenerCount)
+{
+    NotificationCenter center;
+    center.registerEvent(sFanOutId);
+
+    std::vector<FanOutListener> listeners(inListenerCount);
+    ConnectionList connections;
+    connections.reserve(inListenerCount);
+
+    const double connectStart = benchmarkSeconds();
+    for (int index = 0; index < inListenerCount; ++index) {
+        connections.push_back(center.connect(sFanOutId, BindToEvent(FanOutListener::callback, &listeners[index])));
+    }
+    const double connectElapsed = benchmarkSeconds() - connectStart;
+
+    const double disconnectStart = benchmarkSeconds();
+    Q_FOREACH(ConnectionId connection, connections) {
+        center.disconnect(connection);
+    }
+    const double disconnectElapsed = benchmarkSeconds() - disconnectStart;
+
+    reportResult(kBenchmarkName,
+                 qPrintable(QString("connect ns/connection (%1 listeners)").arg(inListenerCount)),
+                 connectElapsed / inListenerCount * 1.0e9, "ns");
+    reportResult(kBenchmarkName,
+                 qPrintable(QString("disconnect ns/connection (%1 listeners)").arg(inListenerCount)),
+                 disconnectElapsed / inListenerCount * 1.0e9, "ns");
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkFanOut()
+//
+/// Per listener cost of events with up to 100k callback listeners, and
+/// of connecting and disconnecting them. A flat ns/listener across the
+/// counts is linear scaling. Tracing is turned off, the trace benchmark
+/// measures its cost.
+//-----------------------------------------------------------------------------
+void
+benchmarkFanOut()
+{
+    const bool wasEnabled = NotificationTrace::isEnabled();
+    NotificationTrace::setEnabled(false);
+
+    const int countCount = sizeof(kListenerCounts) / sizeof(kListenerCounts[0]);
+    for (int index = 0; index < countCount; ++index) {
+        measureFanOut(kListenerCounts[index], false, false);
+        measureFanOut(kListenerCounts[index], true, false);
+        measureConnectDisconnect(kListenerCounts[index]);
+    }
+
+    measureFanOut(100000, true, true);
+
+    NotificationTrace::setEnabled(wasEnabled);
+}
@@ -0,0 +1,151 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// Local
+#include "../NotificationCenter.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+// Constants
+static const EventId sNodeChangedId("com.mightytoad.benchmark.node.changed");
+static const int kObserverCount = 100000;
+static const int kFilteredPostCount = 100;
+static const int kKeyedPostCount = 100000;
+static const char* kBenchmarkName = "keyed_dispatch";
+
+// Globals
+static int gDeliveredCount = 0;
+
+
+//-----------------------------------------------------------------------------
+// struct FilteringObserver
+//
+/// Observer of one node that receives every change and filters in the
+/// callback.
+//-----------------------------------------------------------------------------
+struct FilteringObserver
+{
+    FilteringObserver(quint64 inNode) : mNode(inNode) {}
+
+    void operator()(const Event& inEvent) const
+    {
+        if (inEvent.dictionary.value("node").toULongLong() == mNode) {
+            ++gDeliveredCount;
+        }
+    }
+
+    quint64 mNode;
+};
+
+
+//-----------------------------------------------------------------------------
+// keyedObserver()
+//
+/// Observer connected with the key of its node.
+//-----------------------------------------------------------------------------
+static void
+keyedObserver(const Event& inEvent)
+{
+    Q_UNUSED(inEvent);
+    ++gDeliveredCount;
+}
+
+
+//-----------------------------------------------------------------------------
+// measureFiltered()
+//
+/// One shared event, filtered by every observer.
+//-----------------------------------------------------------------------------
+static void
+measureFiltered()
+{
+    NotificationCenter center;
+    center.registerEvent(sNodeChangedId);
+
+    ConnectionList connections;
+    for (int node = 0; node < kObserverCount; ++node) {
+        connections.push_back(center.connect(sNodeChangedId, FilteringObserver(node)));
+    }
+
+    gDeliveredCount = 0;
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kFilteredPostCount; ++index) {
+        Event* event = new Event(sNodeChangedId);
+        event->dictionary["node"] = static_cast<qulonglong>(index);
+        center.postEvent(event, NotificationCenter::POST_NOW);
+    }
+    const double elapsed = benchmarkSeconds() - start;
+
+    reportResult(kBenchmarkName, "filtered ns/post", elapsed / kFilteredPostCount * 1.0e9, "ns");
+
+    center.disconnect(connections);
+}
+
+
+//-----------------------------------------------------------------------------
+// measureKeyed()
+//
+/// One keyed event, delivered through the key index.
+//-----------------------------------------------------------------------------
+static void
+measureKeyed()
+{
+    NotificationCenter center;
+    center.registerEvent(sNodeChangedId);
+
+    ConnectionList connections;
+    for (int node = 0; node < kObserverCount; ++node) {
+        connections.push_back(center.connect(sNodeChangedId, node, keyedObserver));
+    }
+
+    gDeliveredCount = 0;
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kKeyedPostCount; ++index) {
+        center.postEvent(new Event(sNodeChangedId, index % kObserverCount), NotificationCenter::POST_NOW);
+    }
+    const double elapsed = benchmarkSeconds() - start;
+
+    reportResult(kBenchmarkName, "keyed ns/post", elapsed / kKeyedPostCount * 1.0e9, "ns");
+
+    center.disconnect(connections);
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkKeyedDispatch()
+//
+/// Cost of notifying one of kObserverCount node observers.
+//-----------------------------------------------------------------------------
+void
+benchmarkKeyedDispatch()
+{
+    measureFiltered();
+    measureKeyed();
+}
@@ -0,0 +1,96 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// Qt
+#include <QString>
+
+// Local
+#include "../NotificationCenter.h"
+#include "BenchmarkReceiver.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+// Constants
+static const EventId sConnectId("com.mightytoad.benchmark.qtconnect");
+static const int kConnectionCount = 10000;
+static const char* kBenchmarkName = "qt_connect";
+
+
+//-----------------------------------------------------------------------------
+// measureConnect()
+//
+/// Time per Qt connection of connecting and disconnecting one receiver
+/// kConnectionCount times.
+//-----------------------------------------------------------------------------
+static void
+measureConnect(bool inSignature)
+{
+    NotificationCenter center;
+    center.registerEvent(sConnectId);
+
+    BenchmarkReceiver receiver;
+    ConnectionList connections;
+
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kConnectionCount; ++index) {
+        if (inSignature) {
+            connections.push_back(center.connect(sConnectId, &receiver, "qtCallback(framework::Event)"));
+        } else {
+            connections.push_back(center.connect(sConnectId, &receiver, &BenchmarkReceiver::qtCallback));
+        }
+    }
+    const double connected = benchmarkSeconds();
+    center.disconnect(connections);
+    const double elapsed = benchmarkSeconds() - start;
+
+    const char* kind = inSignature ? "signature" : "member";
+    reportResult(kBenchmarkName,
+                 qPrintable(QString("%1 connect").arg(kind)),
+                 (connected - start) / kConnectionCount * 1.0e9,
+                 "ns");
+    reportResult(kBenchmarkName,
+                 qPrintable(QString("%1 connect and disconnect").arg(kind)),
+                 elapsed / kConnectionCount * 1.0e9,
+                 "ns");
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkQtConnect()
+//
+/// Cost of making Qt connections from slot signatures, which are parsed
+/// and looked up, and from member function pointers, which are not.
+//-----------------------------------------------------------------------------
+void
+benchmarkQtConnect()
+{
+    measureConnect(true);
+    measureConnect(false);
+}
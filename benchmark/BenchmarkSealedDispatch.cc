@@ -0,0 +1,113 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// Qt
+#include <QString>
+
+// Local
+#include "../BindToEvent.h"
+#include "../NotificationCenter.h"
+#include "BenchmarkReceiver.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+// Constants
+static const EventId sDispatchId("com.mightytoad.benchmark.dispatch");
+static const int kDispatchCount = 100000;
+static const char* kBenchmarkName = "sealed_dispatch";
+
+
+//-----------------------------------------------------------------------------
+// measureDispatch()
+//
+/// Average time of a synchronous dispatch to the connected listeners.
+//-----------------------------------------------------------------------------
+static double
+measureDispatch(NotificationCenter* inCenter)
+{
+    // Warm up, this also compiles the plans of a sealed center.
+    inCenter->postEvent(sDispatchId, NotificationCenter::POST_NOW);
+
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kDispatchCount; ++index) {
+        inCenter->postEvent(sDispatchId, NotificationCenter::POST_NOW);
+    }
+
+    return (benchmarkSeconds() - start) / kDispatchCount;
+}
+
+
+//-----------------------------------------------------------------------------
+// runDispatch()
+//
+/// Compare the generic and the sealed dispatch path for one topology.
+//-----------------------------------------------------------------------------
+static void
+runDispatch(int inBoostCount, int inQtCount)
+{
+    NotificationCenter center;
+    center.registerEvent(sDispatchId);
+
+    BenchmarkReceiver receiver;
+    ConnectionList connections;
+    for (int index = 0; index < inBoostCount; ++index) {
+        connections.push_back(center.connect(sDispatchId, BindToEvent(BenchmarkReceiver::boostCallback, &receiver)));
+    }
+    for (int index = 0; index < inQtCount; ++index) {
+        connections.push_back(center.connect(sDispatchId, &receiver, "qtCallback(const framework::Event&)"));
+    }
+
+    const QString topology = QString("boost %1 qt %2").arg(inBoostCount).arg(inQtCount);
+
+    const double generic = measureDispatch(&center);
+    reportResult(kBenchmarkName, qPrintable(topology + " generic"), generic * 1.0e9, "ns/dispatch");
+
+    center.seal();
+    const double sealed = measureDispatch(&center);
+    reportResult(kBenchmarkName, qPrintable(topology + " sealed"), sealed * 1.0e9, "ns/dispatch");
+
+    center.unseal();
+    center.disconnect(connections);
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkSealedDispatch()
+//
+/// Dispatch cost of the generic path against sealed dispatch plans.
+//-----------------------------------------------------------------------------
+void
+benchmarkSealedDispatch()
+{
+    runDispatch(1, 1);
+    runDispatch(0, 10);
+    runDispatch(10, 10);
+    runDispatch(0, 100);
+}
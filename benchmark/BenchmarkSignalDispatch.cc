@@ -0,0 +1,107 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// Local
+#include "../BindToEvent.h"
+#include "../NotificationCenter.h"
+#include "BenchmarkReceiver.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+// Constants
+static const EventId sSignalId("com.mightytoad.benchmark.signal");
+static const int kCallCount = 1000000;
+static const char* kBenchmarkName = "signal_dispatch";
+
+
+//-----------------------------------------------------------------------------
+// measureSignal()
+//
+/// Calls per second through an EventCallbackSignal holding inSlotCount
+/// member function slots.
+//-----------------------------------------------------------------------------
+static void
+measureSignal(int inSlotCount)
+{
+    BenchmarkReceiver receiver;
+    EventCallbackSignal signal;
+    for (int slot = 0; slot < inSlotCount; ++slot) {
+        signal.connect(BindToEvent(BenchmarkReceiver::boostCallback, &receiver));
+    }
+
+    const Event event(sSignalId);
+    const int emitCount = kCallCount / inSlotCount;
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < emitCount; ++index) {
+        signal(event);
+    }
+    const double elapsed = benchmarkSeconds() - start;
+
+    const QString metric = QString("signal calls/s (%1 slots)").arg(inSlotCount);
+    reportResult(kBenchmarkName, qPrintable(metric), emitCount * inSlotCount / elapsed, "calls/s");
+}
+
+
+//-----------------------------------------------------------------------------
+// measureDelegate()
+//
+/// Calls per second through a single bound delegate, the floor the signal
+/// is measured against.
+//-----------------------------------------------------------------------------
+static void
+measureDelegate()
+{
+    BenchmarkReceiver receiver;
+    const EventDelegate callback = BindToEvent(BenchmarkReceiver::boostCallback, &receiver);
+
+    const Event event(sSignalId);
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kCallCount; ++index) {
+        callback(event);
+    }
+    const double elapsed = benchmarkSeconds() - start;
+
+    reportResult(kBenchmarkName, "delegate calls/s", kCallCount / elapsed, "calls/s");
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkSignalDispatch()
+//
+/// Per-slot cost of emitting an event callback signal.
+//-----------------------------------------------------------------------------
+void
+benchmarkSignalDispatch()
+{
+    measureDelegate();
+    measureSignal(1);
+    measureSignal(10);
+    measureSignal(1000);
+}
@@ -0,0 +1,92 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Self
+#include "Benchmark.h"
+
+// Local
+#include "../BindToEvent.h"
+#include "../NotificationCenter.h"
+#include "../NotificationTrace.h"
+#include "BenchmarkReceiver.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+// Constants
+static const EventId sTraceId("com.mightytoad.benchmark.trace");
+static const int kRecordCount = 1000000;
+static const int kDispatchCount = 200000;
+static const char* kBenchmarkName = "trace";
+
+
+//-----------------------------------------------------------------------------
+// measureDispatch()
+//
+/// Time per event of sending kDispatchCount events to one listener.
+//-----------------------------------------------------------------------------
+static double
+measureDispatch(NotificationCenter& inCenter)
+{
+    const Event event(sTraceId);
+
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kDispatchCount; ++index) {
+        inCenter.sendEvent(event);
+    }
+    return (benchmarkSeconds() - start) / kDispatchCount * 1.0e9;
+}
+
+
+//-----------------------------------------------------------------------------
+// benchmarkTrace()
+//
+/// Cost of a trace record, and of tracing while events are dispatched.
+//-----------------------------------------------------------------------------
+void
+benchmarkTrace()
+{
+    const bool wasEnabled = NotificationTrace::isEnabled();
+    NotificationTrace::setEnabled(true);
+
+    const double start = benchmarkSeconds();
+    for (int index = 0; index < kRecordCount; ++index) {
+        NotificationTrace::record(TRACE_POST, sTraceId.getHash(), 0);
+    }
+    reportResult(kBenchmarkName, "record", (benchmarkSeconds() - start) / kRecordCount * 1.0e9, "ns");
+
+    NotificationCenter center;
+    center.registerEvent(sTraceId);
+
+    BenchmarkReceiver receiver;
+    center.connect(sTraceId, BindToEvent(BenchmarkReceiver::boostCallback, &receiver));
+
+    reportResult(kBenchmarkName, "send traced", measureDispatch(center), "ns");
+    NotificationTrace::setEnabled(false);
+    reportResult(kBenchmarkName, "send untraced", measureDispatch(center), "ns");
+
+    NotificationTrace::setEnabled(wasEnabled);
+}
@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2011 Gene Z. Ragan
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+# Measures the heap cost of a connection at an older revision and in the
+# working tree with the same harness, connection_memory.pro, and prints
+# both with their ratio:
+#
+#     benchmark/compare_connection_memory.sh [revision]
+#
+# The revision defaults to the baseline before the connection records were
+# split per type. Set QMAKE to pick another qmake. The older revision uses
+# boost::signals, so its boost needs the signals library.
+
+set -e
+
+BEFORE=${1:-2c68708}
+QMAKE=${QMAKE:-qmake}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+measure()
+{
+    mkdir -p "$WORK/build-$1"
+    (cd "$WORK/build-$1" \
+        && "$QMAKE" NC_SOURCE="$2" "$ROOT/benchmark/connection_memory.pro" > /dev/null \
+        && make -s > /dev/null \
+        && ./connection_memory_benchmark) > "$WORK/$1.txt"
+}
+
+mkdir -p "$WORK/before"
+git -C "$ROOT" archive "$BEFORE" | tar -x -C "$WORK/before"
+
+measure before "$WORK/before"
+measure after "$ROOT"
+
+# Result lines are: benchmark, measure words..., value, unit.
+awk '
+    {
+        name = $2; for (i = 3; i < NF - 1; ++i) name = name " " $i
+        value = $(NF - 1)
+        if (FILENAME ~ /before/) { before[name] = value; order[++count] = name }
+        else { after[name] = value }
+    }
+    END {
+        printf "%-28s %12s %12s %8s\n", "measure", "before", "after", "ratio"
+        for (i = 1; i <= count; ++i) {
+            name = order[i]
+            ratio = after[name] > 0 ? before[name] / after[name] : 0
+            printf "%-28s %12.2f %12.2f %7.1fx\n", name, before[name], after[name], ratio
+        }
+    }
+' "$WORK/before.txt" "$WORK/after.txt"
@@ -0,0 +1,92 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+# Builds the connection memory benchmark alone, against the sources in
+# NC_SOURCE. This is the repository root by default. Point it at a checkout
+# of another revision to measure that revision with the same harness:
+#
+#     qmake NC_SOURCE=/path/to/checkout connection_memory.pro
+#
+# Sources that only some revisions have are added if they exist.
+
+CONFIG	+=	qt ordered no_keywords console release
+
+QT		-=	gui
+
+TARGET	=	connection_memory_benchmark
+
+isEmpty(NC_SOURCE) {
+NC_SOURCE = ..
+}
+
+SOURCES += 	ConnectionMemoryMain.cc \
+		    Benchmark.cc \
+		    BenchmarkConnectionMemory.cc \
+		    $$NC_SOURCE/NotificationCenter.cc \
+
+HEADERS +=	$$NC_SOURCE/BindToEvent.h \
+			$$NC_SOURCE/NotificationCenter.h \
+			$$NC_SOURCE/NotificationLogging.h \
+		    Benchmark.h \
+		    BenchmarkReceiver.h \
+
+for(source, EventDictionary JsonWriter LatencyHistogram NotificationTrace) {
+exists($$NC_SOURCE/$${source}.cc) {
+SOURCES	+=	$$NC_SOURCE/$${source}.cc
+HEADERS	+=	$$NC_SOURCE/$${source}.h
+}
+}
+
+OBJECTS_DIR = ./obj_connection_memory
+
+MOC_DIR = ./moc_connection_memory
+
+DEFINES 	+= 	USE_LOCAL_LOGGING \
+                DISABLE_PYTHON
+
+INCLUDEPATH	+=	$$NC_SOURCE
+
+# Revisions before EventSignal.h dispatch through boost::signals.
+!exists($$NC_SOURCE/EventSignal.h) {
+LIBS		+=	-lboost_signals
+}
+
+macx {
+CONFIG 		-= 	app_bundle
+
+INCLUDEPATH	+=	/usr/local/include \
+				/usr/local/include/boost \
+			   	/Library/Frameworks/Python.framework/Versions/2.7/include/python2.7 \
+
+LIBS		+=	-L/usr/local/lib \
+   				-lboost_system \
+				-lpython \
+}
+
+unix:!macx {
+INCLUDEPATH	+=	/usr/include/python2.7 \
+
+LIBS		+=	-lboost_system \
+				-lpython2.7 \
+}
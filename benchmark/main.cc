@@ -0,0 +1,84 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Qt
+#include <QCoreApplication>
+#include <QStringList>
+
+// System
+#include <cstdio>
+#include <cstring>
+
+// Local
+#include "Benchmark.h"
+
+
+// Benchmarks known to the driver
+static const BenchmarkEntry kBenchmarks[] = {
+    { "connection_memory", benchmarkConnectionMemory },
+    { "sealed_dispatch", benchmarkSealedDispatch },
+    { "keyed_dispatch", benchmarkKeyedDispatch },
+    { "signal_dispatch", benchmarkSignalDispatch },
+    { "event_dictionary", benchmarkEventDictionary },
+    { "fan_out", benchmarkFanOut },
+    { "qt_connect", benchmarkQtConnect },
+    { "trace", benchmarkTrace },
+};
+
+static const int kBenchmarkCount = sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
+
+
+//=============================================================================
+// main
+//
+// Runs every benchmark, or only those named on the command line.
+//=============================================================================
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList selected = app.arguments();
+    selected.removeFirst();
+
+    int result = 0;
+    Q_FOREACH(const QString& name, selected) {
+        bool found = false;
+        for (int index = 0; index < kBenchmarkCount; ++index) {
+            found = found || (name == kBenchmarks[index].name);
+        }
+        if (!found) {
+            std::fprintf(stderr, "Unknown benchmark: %s\n", qPrintable(name));
+            result = 1;
+        }
+    }
+
+    for (int index = 0; index < kBenchmarkCount; ++index) {
+        if (selected.isEmpty() || selected.contains(kBenchmarks[index].name)) {
+            kBenchmarks[index].function();
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,85 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+CONFIG	+=	qt ordered no_keywords console release
+
+QT		-=	gui
+
+TARGET	=	notification_benchmark
+
+SOURCES += 	main.cc \
+		    ../EventDictionary.cc \
+		    ../JsonWriter.cc \
+		    ../LatencyHistogram.cc \
+		    ../NotificationCenter.cc \
+		    ../NotificationTrace.cc \
+		    Benchmark.cc \
+		    BenchmarkConnectionMemory.cc \
+		    BenchmarkSealedDispatch.cc \
+		    BenchmarkKeyedDispatch.cc \
+		    BenchmarkSignalDispatch.cc \
+		    BenchmarkEventDictionary.cc \
+		    BenchmarkFanOut.cc \
+		    BenchmarkQtConnect.cc \
+		    BenchmarkTrace.cc \
+
+HEADERS +=	../BindToEvent.h \
+			../EventDictionary.h \
+			../EventSignal.h \
+			../JsonWriter.h \
+			../LatencyHistogram.h \
+			../MonotonicClock.h \
+			../NotificationCenter.h \
+			../NotificationLogging.h \
+			../NotificationTrace.h \
+		    Benchmark.h \
+		    BenchmarkReceiver.h \
+
+OBJECTS_DIR = ./obj
+
+MOC_DIR = ./moc
+
+DEFINES 	+= 	USE_LOCAL_LOGGING \
+                DISABLE_PYTHON
+
+macx {
+CONFIG 		-= 	app_bundle
+
+INCLUDEPATH	+=	/usr/local/include \
+				/usr/local/include/boost \
+			   	/Library/Frameworks/Python.framework/Versions/2.7/include/python2.7 \
+			   	../ \
+
+LIBS		=	-L/usr/local/lib \
+   				-lboost_system \
+				-lpython \
+}
+
+unix:!macx {
+INCLUDEPATH	+=	/usr/include/python2.7 \
+				../ \
+
+LIBS		+=	-lboost_system \
+				-lpython2.7 \
+}
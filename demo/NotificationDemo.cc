@@ -33,6 +33,7 @@ THE SOFTWARE.
 
 // Local
 #include "../BindToEvent.h"
+#include "../NotificationMetricsServer.h"
 #include "NotificationLogging.h"
 
 
@@ -70,6 +71,15 @@ NotificationDemo::NotificationDemo()
 	mQtId = mNotificationCenter.connect(sQtId, 
                               			this, 
                               			"qtCallback(const framework::Event&)"); 
+
+	// Serve the metrics on the socket named by NC_METRICS_SOCKET
+	const QString metricsSocket = QString::fromLocal8Bit(qgetenv("NC_METRICS_SOCKET"));
+	if (!metricsSocket.isEmpty()) {
+		NotificationMetricsServer* server = new NotificationMetricsServer(&mNotificationCenter, this);
+		if (!server->listenOnSocket(metricsSocket)) {
+			qWarning() << "Metrics server:" << server->errorString();
+		}
+	}
 		
 	// Create the layouts
 	QVBoxLayout* vBoxLayout = new QVBoxLayout(this);
@@ -24,13 +24,27 @@ THE SOFTWARE.
 
 CONFIG	+=	qt ordered no_keywords
 
+QT		+=	network
+
 SOURCES += 	main.cc \
+		    ../EventDictionary.cc \
+		    ../JsonWriter.cc \
+		    ../LatencyHistogram.cc \
 		    ../NotificationCenter.cc \
+		    ../NotificationMetricsServer.cc \
+		    ../NotificationTrace.cc \
             NotificationDemo.cc \
 		    		    
 HEADERS +=	../BindToEvent.h \
+			../EventDictionary.h \
+			../EventSignal.h \
+			../JsonWriter.h \
+			../LatencyHistogram.h \
+			../MonotonicClock.h \
 			../NotificationCenter.h \
 			../NotificationLogging.h \
+			../NotificationMetricsServer.h \
+			../NotificationTrace.h \
 		    NotificationDemo.h \
 		    
 OBJECTS_DIR = ./obj
@@ -58,7 +72,6 @@ LIBS		=	-framework Carbon \
    				-lboost_python \
    				-lboost_regex \
    				-lboost_serialization \
-   				-lboost_signals \
    				-lboost_system \
    				-lboost_thread \
 				-lpython \
@@ -0,0 +1,86 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2011 Gene Z. Ragan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Qt
+#include <QCoreApplication>
+#include <QStringList>
+
+// System
+#include <cstdio>
+
+// Local
+#include "../NotificationTrace.h"
+
+
+// Namespaces
+using namespace framework;
+
+
+//=============================================================================
+// main
+//
+// Prints the records of trace files written by NotificationTrace::write(),
+// one line per record. Times are relative to the first record of a file.
+// With --chrome, prints each file in the Chrome Trace Event format instead.
+//=============================================================================
+int
+main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList paths = app.arguments();
+    paths.removeFirst();
+    const bool chrome = paths.removeAll("--chrome") > 0;
+    if (paths.isEmpty()) {
+        std::fprintf(stderr, "Usage: notification_trace_decode [--chrome] <trace file>...\n");
+        return 1;
+    }
+
+    int result = 0;
+    Q_FOREACH(const QString& path, paths) {
+        TraceRecordList records;
+        TraceNameMap names;
+        if (!NotificationTrace::read(path, records, names)) {
+            std::fprintf(stderr, "Not a notification center trace: %s\n", qPrintable(path));
+            result = 1;
+            continue;
+        }
+
+        if (chrome) {
+            std::printf("%s\n", NotificationTrace::toChromeTrace(records, names).constData());
+            continue;
+        }
+
+        if (paths.size() > 1) {
+            std::printf("%s:\n", qPrintable(path));
+        }
+
+        const quint64 origin = records.isEmpty() ? 0 : records.first().timestamp;
+        Q_FOREACH(const TraceRecord& record, records) {
+            std::printf("%s\n", qPrintable(NotificationTrace::describe(record, names, origin)));
+        }
+    }
+
+    return result;
+}
@@ -27,11 +27,15 @@ THE SOFTWARE.
 
 // Local
 #include "../NotificationCenter.h"
+#include "../NotificationMetricsServer.h"
+#include "../NotificationTrace.h"
 
 // Qt
+#include <QAtomicInt>
 #include <QCoreApplication>
 #include <QObject>
 #include <QVariant>
+#include <QVector>
 
 // Studio
 #include <cppunit/extensions/HelperMacros.h>
@@ -43,14 +47,88 @@ THE SOFTWARE.
 static const framework::EventId BoostId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Boost");
 static const framework::EventId QtId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Qt");
 static const framework::EventId DeferredId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Deferred");
+static const framework::EventId UnregisterId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Unregister");
+static const framework::EventId ReleaseId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Release");
+static const framework::EventId SealedId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Sealed");
+static const framework::EventId KeyedId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Keyed");
+static const framework::EventId ReentrantId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Reentrant");
+static const framework::EventId LazyId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Lazy");
+static const framework::EventId CascadeId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Cascade");
+static const framework::EventId CascadePeerId("com.mightytoad.ApplicationFramework.TestNotificationCenter.CascadePeer");
+static const framework::EventId StickyId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Sticky");
+static const framework::EventId StateId("com.mightytoad.ApplicationFramework.TestNotificationCenter.State");
+static const framework::EventId ParallelId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Parallel");
+
+// Typed event payload
+struct TypedPayload
+{
+    TypedPayload() : value(0) {}
+    explicit TypedPayload(int inValue) : value(inValue) {}
+
+    int value;
+};
+
+namespace framework {
+template <>
+struct TypedEventTraits<TypedPayload>
+{
+    static void toDictionary(const TypedPayload& inPayload, EventDictionary& outDictionary)
+    {
+        outDictionary["value"] = inPayload.value;
+    }
+
+    static bool fromDictionary(const EventDictionary& inDictionary, TypedPayload& outPayload)
+    {
+        if (!inDictionary.contains("value"))
+            return false;
+
+        outPayload.value = inDictionary.value("value").toInt();
+        return true;
+    }
+};
+}
+
+// Listener of a parallel event, called from the thread pool
+struct ParallelListener
+{
+    void callback(const framework::Event& inEvent) { Q_UNUSED(inEvent); count.ref(); }
+
+    QAtomicInt count;
+};
+
+static const framework::TypedEventId<TypedPayload> TypedId("com.mightytoad.ApplicationFramework.TestNotificationCenter.Typed");
 
 // Local prototypes
 static void boostCallback(const framework::Event& inEvent);
+static void reentrantCallback(const framework::Event& inEvent);
+static void cascadeCallback(const framework::Event& inEvent);
+static void repostCallback(const framework::Event& inEvent);
+static void pingPongCallback(const framework::Event& inEvent);
+static void deduplicatedCascadeCallback(const framework::Event& inEvent);
+static void keyedCallback(const framework::Event& inEvent);
+static void typedCallback(const TypedPayload& inPayload);
+static void untypedCallback(const framework::Event& inEvent);
+static void stateCallback(const framework::Event& inEvent);
+static void buildPayload(framework::EventDictionary& outDictionary);
+static framework::ListenerProfile listenerProfile(framework::ConnectionId inConnection);
 
 // Globals
 static framework::ConnectionId gBoostId;
 static framework::ConnectionId gBoostDeferredId;
 static framework::ConnectionId gQtId;
+static framework::ConnectionId gReentrantId;
+static int gReentrantCount = 0;
+static int gCascadeCount = 0;
+static int gCascadeDepth = 0;
+static int gRepostCount = 0;
+static int gPingPongCount = 0;
+static int gDeduplicatedCascadeCount = 0;
+static int gKeyedCount = 0;
+static int gTypedValue = 0;
+static int gUntypedValue = 0;
+static int gStateCount = 0;
+static framework::EventDictionary gStateChanges;
+static int gBuildCount = 0;
 static framework::NotificationCenter* sNotificationCenter = NULL;
 
 
@@ -172,6 +250,74 @@ public:
         }
     }
 
+    void 
+    testEventUnregistration() 
+    {
+        const int beforeCount = sNotificationCenter->registeredEventCount();
+
+        sNotificationCenter->registerEvent(UnregisterId);
+        const int eventType = UnregisterId.getEventType();
+
+        // The listener keeps the event alive after the publisher is gone.
+        const framework::ConnectionId connectionId = sNotificationCenter->connect(UnregisterId, boostCallback);
+        sNotificationCenter->unregisterEvent(UnregisterId);
+        QCoreApplication::processEvents();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test event held by listener", 
+                                     beforeCount + 1,
+                                     sNotificationCenter->registeredEventCount());
+
+        // Once the last listener is gone the event is released.
+        sNotificationCenter->disconnect(connectionId);
+        QCoreApplication::processEvents();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test event unregistration", 
+                                     beforeCount,
+                                     sNotificationCenter->registeredEventCount());
+
+        // The released event type is handed to the next registration.
+        sNotificationCenter->registerEvent(UnregisterId);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test event type reuse", 
+                                     eventType,
+                                     UnregisterId.getEventType());
+
+        sNotificationCenter->unregisterEvent(UnregisterId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testEventRelease()
+    {
+        sNotificationCenter->registerEvent(UnregisterId);
+        const int methodCount = sNotificationCenter->metaObject()->methodCount();
+        sNotificationCenter->setSticky(UnregisterId, true);
+        sNotificationCenter->sendEvent(framework::Event(UnregisterId));
+        sNotificationCenter->unregisterEvent(UnregisterId);
+        QCoreApplication::processEvents();
+
+        // Nothing is left of a released event.
+        bool found = false;
+        Q_FOREACH(const framework::EventSnapshot& snapshot, sNotificationCenter->eventSnapshots()) {
+            found = found || snapshot.eventHash == UnregisterId.getHash();
+        }
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test released event snapshot", false, found);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test released event sticky", false, sNotificationCenter->isSticky(UnregisterId));
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test released event latency",
+                                     quint64(0),
+                                     sNotificationCenter->latency(UnregisterId).dispatch.count());
+
+        // Its signal is renamed for the next event.
+        sNotificationCenter->registerEvent(ReleaseId);
+        const QByteArray signal = ReleaseId.getStringId().toAscii() + "(framework::Event)";
+        CPPUNIT_ASSERT(sNotificationCenter->metaObject()->indexOfSignal(signal.constData()) >= 0);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test released signal reuse",
+                                     methodCount,
+                                     sNotificationCenter->metaObject()->methodCount());
+
+        sNotificationCenter->unregisterEvent(ReleaseId);
+        QCoreApplication::processEvents();
+    }
+
     void 
     testQtEventPosting() 
     {
@@ -231,6 +377,116 @@ public:
                                      false, 
                                      testApp->mSlotCalled);    
     }
+
+    void
+    testQtIndependentDisconnect()
+    {
+        TestNotificationApp* testApp = qobject_cast<TestNotificationApp*>(qApp);
+        CPPUNIT_ASSERT(testApp != NULL);
+
+        // Disconnecting one slot of an event leaves the others connected.
+        const framework::ConnectionId firstId = sNotificationCenter->connect(QtId,
+                                                                             testApp,
+                                                                             "testSlot(framework::Event)");
+        const framework::ConnectionId secondId = sNotificationCenter->connect(QtId,
+                                                                              testApp,
+                                                                              "testSlot(framework::Event)");
+        sNotificationCenter->disconnect(firstId);
+
+        testApp->mSlotCalled = false;
+        sNotificationCenter->postEvent(QtId, framework::NotificationCenter::POST_NOW);
+        QCoreApplication::processEvents();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test qt independent disconnect",
+                                     true,
+                                     testApp->mSlotCalled);
+
+        sNotificationCenter->disconnect(secondId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testQtMemberConnection()
+    {
+        TestNotificationApp* testApp = qobject_cast<TestNotificationApp*>(qApp);
+        CPPUNIT_ASSERT(testApp != NULL);
+
+        testApp->mSlotCalled = false;
+
+        const framework::ConnectionId memberId = sNotificationCenter->connect(QtId,
+                                                                              testApp,
+                                                                              &TestNotificationApp::testSlot);
+        sNotificationCenter->postEvent(QtId, framework::NotificationCenter::POST_NOW);
+        QCoreApplication::processEvents();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test qt member connection",
+                                     true,
+                                     testApp->mSlotCalled);
+
+        sNotificationCenter->disconnect(memberId);
+
+        // A functor is not called once its context object is gone.
+        gKeyedCount = 0;
+        QObject* context = new QObject();
+        const framework::ConnectionId contextId = sNotificationCenter->connect(QtId, context, keyedCallback);
+
+        sNotificationCenter->postEvent(QtId, framework::NotificationCenter::POST_NOW);
+        delete context;
+        sNotificationCenter->postEvent(QtId, framework::NotificationCenter::POST_NOW);
+        QCoreApplication::processEvents();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test qt context connection",
+                                     1,
+                                     gKeyedCount);
+
+        sNotificationCenter->disconnect(contextId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testEventSignal()
+    {
+        TestNotificationApp* testApp = qobject_cast<TestNotificationApp*>(qApp);
+        CPPUNIT_ASSERT(testApp != NULL);
+
+        testApp->mSlotCalled = false;
+
+        // Every registered event is a signal of the Notification Center.
+        const QByteArray signal = "2" + QtId.getStringId().toAscii() + "(framework::Event)";
+        CPPUNIT_ASSERT(sNotificationCenter->metaObject()->indexOfSignal(signal.constData() + 1) >= 0);
+        CPPUNIT_ASSERT(QObject::connect(sNotificationCenter,
+                                        signal.constData(),
+                                        testApp,
+                                        SLOT(testSlot(framework::Event))));
+
+        quint64 dropped = 0;
+        Q_FOREACH(const framework::EventSnapshot& snapshot, sNotificationCenter->eventSnapshots()) {
+            if (snapshot.eventHash == QtId.getHash()) {
+                dropped = snapshot.statistics.dropped;
+            }
+        }
+
+        sNotificationCenter->postEvent(QtId, framework::NotificationCenter::POST_NOW);
+        QCoreApplication::processEvents();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test event signal",
+                                     true,
+                                     testApp->mSlotCalled);
+
+        // The receiver of the signal is a listener.
+        Q_FOREACH(const framework::EventSnapshot& snapshot, sNotificationCenter->eventSnapshots()) {
+            if (snapshot.eventHash == QtId.getHash()) {
+                CPPUNIT_ASSERT_EQUAL_MESSAGE("test event signal not dropped",
+                                             dropped,
+                                             snapshot.statistics.dropped);
+            }
+        }
+
+        QObject::disconnect(sNotificationCenter,
+                            signal.constData(),
+                            testApp,
+                            SLOT(testSlot(framework::Event)));
+    }
  	
     void 
     testBoostEventPosting() 
@@ -266,6 +522,21 @@ public:
                                      mTestValue);    
     }
 
+    void 
+    testStackEventSending() 
+    {
+        mTestValue = false;
+        
+        framework::Event event(BoostId);
+        event.dictionary["test"] = qVariantFromValue((void *) this);
+
+        sNotificationCenter->sendEvent(event);
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test stack event sending", 
+                                     true, 
+                                     mTestValue);    
+    }
+
     void 
     testBoostEventDisconnect() 
     {
@@ -284,6 +555,792 @@ public:
                                      mTestValue);    
     }
 
+    void 
+    testReentrantConnections() 
+    {
+        mTestValue = false;
+        gReentrantCount = 0;
+
+        sNotificationCenter->registerEvent(ReentrantId);
+        gReentrantId = sNotificationCenter->connect(ReentrantId, reentrantCallback);
+
+        // The callback swaps itself for boostCallback. The new listener
+        // is attached after the dispatch, so it misses this event.
+        framework::Event* event = new framework::Event(ReentrantId);
+        event->dictionary["test"] = qVariantFromValue((void *) this);
+        sNotificationCenter->postEvent(event, framework::NotificationCenter::POST_NOW);
+        QCoreApplication::processEvents();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test connect during dispatch", 
+                                     false, 
+                                     mTestValue);    
+
+        event = new framework::Event(ReentrantId);
+        event->dictionary["test"] = qVariantFromValue((void *) this);
+        sNotificationCenter->postEvent(event, framework::NotificationCenter::POST_NOW);
+        QCoreApplication::processEvents();
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test disconnect during dispatch", 
+                                     1, 
+                                     gReentrantCount);    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test pending connection attached", 
+                                     true, 
+                                     mTestValue);    
+
+        sNotificationCenter->disconnect(gReentrantId);
+        sNotificationCenter->unregisterEvent(ReentrantId);
+        QCoreApplication::processEvents();
+    }
+
+    void 
+    testSealedDispatch() 
+    {
+        TestNotificationApp* testApp = qobject_cast<TestNotificationApp*>(qApp);
+        CPPUNIT_ASSERT(testApp != NULL);
+
+        sNotificationCenter->registerEvent(SealedId);
+        const framework::ConnectionId qtId = sNotificationCenter->connect(SealedId, 
+                                                                          testApp, 
+                                                                          "testSlot(framework::Event)");
+        sNotificationCenter->seal();
+        CPPUNIT_ASSERT(sNotificationCenter->isSealed());
+
+        testApp->mSlotCalled = false;
+        sNotificationCenter->postEvent(SealedId, framework::NotificationCenter::POST_NOW);
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test sealed qt dispatch", 
+                                     true, 
+                                     testApp->mSlotCalled);    
+
+        // A connection made after sealing is picked up by the next dispatch.
+        mTestValue = false;
+        const framework::ConnectionId boostId = sNotificationCenter->connect(SealedId, boostCallback);
+
+        framework::Event* event = new framework::Event(SealedId);
+        event->dictionary["test"] = qVariantFromValue((void *) this);
+        sNotificationCenter->postEvent(event, framework::NotificationCenter::POST_NOW);
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test sealed connect", 
+                                     true, 
+                                     mTestValue);    
+
+        // And a disconnected slot is no longer called.
+        sNotificationCenter->disconnect(qtId);
+        testApp->mSlotCalled = false;
+        sNotificationCenter->postEvent(SealedId, framework::NotificationCenter::POST_NOW);
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test sealed disconnect", 
+                                     false, 
+                                     testApp->mSlotCalled);    
+
+        sNotificationCenter->unseal();
+        sNotificationCenter->disconnect(boostId);
+        sNotificationCenter->unregisterEvent(SealedId);
+        QCoreApplication::processEvents();
+    }
+
+    void 
+    testKeyedDispatch() 
+    {
+        gKeyedCount = 0;
+
+        sNotificationCenter->registerEvent(KeyedId);
+        framework::ConnectionList connections;
+        connections.push_back(sNotificationCenter->connect(KeyedId, 1, keyedCallback));
+        connections.push_back(sNotificationCenter->connect(KeyedId, 2, keyedCallback));
+        connections.push_back(sNotificationCenter->connect(KeyedId, 2, keyedCallback));
+
+        // Only the listeners of the key are called.
+        sNotificationCenter->postEvent(new framework::Event(KeyedId, 2), framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test keyed dispatch", 
+                                     2, 
+                                     gKeyedCount);    
+
+        // An event without a key does not reach keyed listeners.
+        sNotificationCenter->postEvent(new framework::Event(KeyedId), framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test unkeyed dispatch", 
+                                     2, 
+                                     gKeyedCount);    
+
+        sNotificationCenter->disconnect(connections.at(0));
+        sNotificationCenter->postEvent(new framework::Event(KeyedId, 1), framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test keyed disconnect", 
+                                     2, 
+                                     gKeyedCount);    
+
+        connections.removeFirst();
+        sNotificationCenter->disconnect(connections);
+        sNotificationCenter->unregisterEvent(KeyedId);
+        QCoreApplication::processEvents();
+    }
+
+    void 
+    testTypedEventPosting() 
+    {
+        gTypedValue = 0;
+        gUntypedValue = 0;
+
+        sNotificationCenter->registerEvent(TypedId);
+        const framework::ConnectionId typedId = sNotificationCenter->connect(TypedId, typedCallback);
+
+        // The payload is passed straight through.
+        sNotificationCenter->postEvent(TypedId, TypedPayload(42), framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test typed event posting", 
+                                     42, 
+                                     gTypedValue);    
+
+        // An untyped listener reads the payload from the dictionary.
+        const framework::ConnectionId untypedId = sNotificationCenter->connect(TypedId, untypedCallback);
+        sNotificationCenter->postEvent(TypedId, TypedPayload(7), framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test typed event dictionary", 
+                                     7, 
+                                     gUntypedValue);    
+
+        // And an untyped event reaches the typed listener through the traits.
+        framework::Event* event = new framework::Event(TypedId);
+        event->dictionary["value"] = 3;
+        sNotificationCenter->postEvent(event, framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test untyped event to typed listener", 
+                                     3, 
+                                     gTypedValue);    
+
+        // A payload filled in place is not copied on the way.
+        framework::TypedEvent<TypedPayload>* typedEvent = new framework::TypedEvent<TypedPayload>(TypedId);
+        typedEvent->payload.value = 9;
+        sNotificationCenter->postEvent(typedEvent, framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test typed event filled in place", 
+                                     9, 
+                                     gTypedValue);    
+
+        sNotificationCenter->disconnect(untypedId);
+        sNotificationCenter->disconnect(typedId);
+        sNotificationCenter->unregisterEvent(TypedId);
+        QCoreApplication::processEvents();
+    }
+
+    void 
+    testLazyEventPosting() 
+    {
+        gBuildCount = 0;
+        gUntypedValue = 0;
+
+        sNotificationCenter->registerEvent(LazyId);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test no listeners", 
+                                     false, 
+                                     sNotificationCenter->hasListeners(LazyId));    
+
+        // Nobody listens, so the payload is never built.
+        sNotificationCenter->postEvent(LazyId, buildPayload, framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test lazy event without listeners", 
+                                     0, 
+                                     gBuildCount);    
+
+        const framework::ConnectionId lazyId = sNotificationCenter->connect(LazyId, untypedCallback);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test listeners", 
+                                     true, 
+                                     sNotificationCenter->hasListeners(LazyId));    
+
+        sNotificationCenter->postEvent(LazyId, buildPayload, framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test lazy event build count", 
+                                     1, 
+                                     gBuildCount);    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test lazy event payload", 
+                                     5, 
+                                     gUntypedValue);    
+
+        sNotificationCenter->disconnect(lazyId);
+        sNotificationCenter->unregisterEvent(LazyId);
+        QCoreApplication::processEvents();
+    }
+
+    void 
+    testEventDictionary() 
+    {
+        framework::EventDictionary dictionary;
+        dictionary["id"] = 1;
+        dictionary[QString("type")] = 2;
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary lookup", 
+                                     2, 
+                                     dictionary.value("type").toInt());    
+
+        // Large dictionaries are indexed.
+        for (int index = 0; index < 32; ++index) {
+            dictionary[QString("key%1").arg(index)] = index;
+        }
+        dictionary.remove("key3");
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test indexed dictionary lookup", 
+                                     31, 
+                                     dictionary.value("key31").toInt());    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary remove", 
+                                     false, 
+                                     dictionary.contains("key3"));    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary size", 
+                                     33, 
+                                     dictionary.size());    
+
+        // Lookups never intern their key, text no key was made from is
+        // simply not found.
+        const int atomCount = framework::EventKey::atomCount();
+        const framework::EventDictionary& constDictionary = dictionary;
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary lookup of an unknown key", 
+                                     false, 
+                                     constDictionary.contains(QString("unknown%1").arg(7)));    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary lookup does not intern", 
+                                     atomCount, 
+                                     framework::EventKey::atomCount());    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary const lookup", 
+                                     31, 
+                                     constDictionary["key31"].toInt());    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary remove of an unknown key", 
+                                     0, 
+                                     dictionary.remove("unknown"));    
+
+        // Copies share their entries until one of them changes.
+        framework::EventDictionary copy = dictionary;
+        copy["id"] = 7;
+        copy.remove("key31");
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary copy is detached", 
+                                     1, 
+                                     dictionary.value("id").toInt());    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary copy keeps the original", 
+                                     31, 
+                                     dictionary.value("key31").toInt());    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary copy changes", 
+                                     7, 
+                                     copy.value("id").toInt());    
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary copy size", 
+                                     32, 
+                                     copy.size());    
+
+        copy.clear();
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test dictionary clear of a copy", 
+                                     33, 
+                                     dictionary.size());    
+    }
+
+    void 
+    testMemberEventPosting() 
+    {
+        mTestValue = false;
+
+        // The member function is bound at compile time.
+        const framework::ConnectionId memberId = 
+            sNotificationCenter->connect<TestNotificationCenter, &TestNotificationCenter::memberCallback>(BoostId, this);
+        sNotificationCenter->postEvent(BoostId, framework::NotificationCenter::POST_NOW);
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test member event posting", 
+                                     true, 
+                                     mTestValue);    
+
+        sNotificationCenter->disconnect(memberId);
+        sNotificationCenter->postEvent(BoostId, framework::NotificationCenter::POST_NOW);
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test member event disconnect", 
+                                     true, 
+                                     mTestValue);    
+    }
+
+    void
+    testTrace()
+    {
+        framework::NotificationTrace::setEnabled(true);
+        framework::NotificationTrace::clear();
+
+        const framework::ConnectionId connection = sNotificationCenter->connect(QtId, untypedCallback);
+        sNotificationCenter->sendEvent(framework::Event(QtId));
+        sNotificationCenter->disconnect(connection);
+
+        // Only the records of the event, the center posts its own events.
+        QList<quint16> operations;
+        Q_FOREACH(const framework::TraceRecord& record, framework::NotificationTrace::snapshot()) {
+            const bool listener = (record.operation == framework::TRACE_LISTENER_BEGIN
+                                   || record.operation == framework::TRACE_LISTENER_END);
+            if (record.eventHash == QtId.getHash() && (!listener || record.connection == connection)) {
+                operations.push_back(record.operation);
+            }
+        }
+
+        QList<quint16> expected;
+        expected << framework::TRACE_CONNECT
+                 << framework::TRACE_SEND
+                 << framework::TRACE_DISPATCH_BEGIN
+                 << framework::TRACE_LISTENER_BEGIN
+                 << framework::TRACE_LISTENER_END
+                 << framework::TRACE_DISPATCH_END
+                 << framework::TRACE_DISCONNECT;
+        CPPUNIT_ASSERT_MESSAGE("test trace records", operations == expected);
+
+        // A listener connected while tracing was off is recorded once
+        // tracing is turned on.
+        framework::NotificationTrace::setEnabled(false);
+        const framework::ConnectionId untraced = sNotificationCenter->connect(QtId, untypedCallback);
+        framework::NotificationTrace::setEnabled(true);
+        framework::NotificationTrace::clear();
+        sNotificationCenter->sendEvent(framework::Event(QtId));
+        sNotificationCenter->disconnect(untraced);
+
+        int listenerRecords = 0;
+        Q_FOREACH(const framework::TraceRecord& record, framework::NotificationTrace::snapshot()) {
+            if (record.connection == untraced
+                    && (record.operation == framework::TRACE_LISTENER_BEGIN
+                        || record.operation == framework::TRACE_LISTENER_END)) {
+                ++listenerRecords;
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test trace turned on after connecting", 2, listenerRecords);
+
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testParallelDispatch()
+    {
+        sNotificationCenter->registerEvent(ParallelId);
+        sNotificationCenter->setParallelDispatch(ParallelId, true);
+
+        // Enough listeners for several partitions of 1024, and not a
+        // multiple of it.
+        QVector<ParallelListener> listeners(4 * 1024 + 7);
+        framework::ConnectionList connections;
+        for (int index = 0; index < listeners.size(); ++index) {
+            connections.push_back(sNotificationCenter->connect<ParallelListener, &ParallelListener::callback>(ParallelId, &listeners[index]));
+        }
+
+        // The partitions run another loop while tracing is on.
+        const bool wasTracing = framework::NotificationTrace::isEnabled();
+        framework::NotificationTrace::setEnabled(true);
+        sNotificationCenter->sendEvent(framework::Event(ParallelId));
+        framework::NotificationTrace::setEnabled(false);
+        sNotificationCenter->sendEvent(framework::Event(ParallelId));
+        framework::NotificationTrace::setEnabled(wasTracing);
+
+        int miscounted = 0;
+        for (int index = 0; index < listeners.size(); ++index) {
+            if (listeners[index].count != 2) {
+                ++miscounted;
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test every listener called once per dispatch", 
+                                     0, 
+                                     miscounted);    
+
+        sNotificationCenter->disconnect(connections);
+        sNotificationCenter->setParallelDispatch(ParallelId, false);
+        sNotificationCenter->unregisterEvent(ParallelId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testCascadeLimits()
+    {
+        sNotificationCenter->registerEvent(CascadeId);
+        const framework::ConnectionId connection = sNotificationCenter->connect(CascadeId, cascadeCallback);
+
+        // The listener posts its own event again, which is cut by the
+        // cycle limit.
+        gCascadeCount = 0;
+        gCascadeDepth = 0;
+        sNotificationCenter->setMaxCycleRepeats(4);
+        sNotificationCenter->sendEvent(framework::Event(CascadeId));
+
+        CPPUNIT_ASSERT_EQUAL(4, gCascadeCount);
+        CPPUNIT_ASSERT_EQUAL(3, gCascadeDepth);
+
+        const framework::CascadeStatistics statistics = sNotificationCenter->cascadeStatistics(CascadeId);
+        CPPUNIT_ASSERT_EQUAL(quint64(1), statistics.trees);
+        CPPUNIT_ASSERT_EQUAL(quint64(4), statistics.events);
+        CPPUNIT_ASSERT_EQUAL(quint64(1), statistics.suppressed);
+        CPPUNIT_ASSERT_EQUAL(3, statistics.maxDepth);
+
+        // The depth limit cuts the same loop earlier.
+        gCascadeCount = 0;
+        sNotificationCenter->setMaxCascadeDepth(1);
+        sNotificationCenter->sendEvent(framework::Event(CascadeId));
+        CPPUNIT_ASSERT_EQUAL(2, gCascadeCount);
+
+        sNotificationCenter->setMaxCascadeDepth(0);
+        sNotificationCenter->setMaxCycleRepeats(0);
+        sNotificationCenter->disconnect(connection);
+        sNotificationCenter->unregisterEvent(CascadeId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testQueuedRepostIsNotCut()
+    {
+        sNotificationCenter->registerEvent(CascadeId);
+        const framework::ConnectionId connection = sNotificationCenter->connect(CascadeId, repostCallback);
+
+        // A poll loop reposting its own event through the queue is no
+        // cascade, however often it goes round.
+        gRepostCount = 0;
+        sNotificationCenter->resetCascades();
+        sNotificationCenter->setMaxCycleRepeats(2);
+        sNotificationCenter->postEvent(CascadeId);
+        for (int round = 0; round < 20; ++round) {
+            QCoreApplication::processEvents();
+        }
+
+        CPPUNIT_ASSERT_EQUAL(10, gRepostCount);
+        CPPUNIT_ASSERT_EQUAL(quint64(0), sNotificationCenter->cascadeStatistics(CascadeId).suppressed);
+
+        sNotificationCenter->setMaxCycleRepeats(0);
+        sNotificationCenter->disconnect(connection);
+        sNotificationCenter->unregisterEvent(CascadeId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testQueuedLoopIsCut()
+    {
+        sNotificationCenter->registerEvent(CascadeId);
+        sNotificationCenter->registerEvent(CascadePeerId);
+        const framework::ConnectionId connection = sNotificationCenter->connect(CascadeId, pingPongCallback);
+        const framework::ConnectionId peerConnection = sNotificationCenter->connect(CascadePeerId, pingPongCallback);
+
+        // Two events posting each other through the queue stay one
+        // cascade, which the cycle limit cuts when the first comes round
+        // a third time.
+        gPingPongCount = 0;
+        sNotificationCenter->resetCascades();
+        sNotificationCenter->setMaxCycleRepeats(2);
+        sNotificationCenter->postEvent(CascadeId);
+        for (int round = 0; round < 10; ++round) {
+            QCoreApplication::processEvents();
+        }
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test queued loop dispatches", 4, gPingPongCount);
+
+        const framework::CascadeStatistics statistics = sNotificationCenter->cascadeStatistics(CascadeId);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test queued loop trees", quint64(1), statistics.trees);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test queued loop events", quint64(4), statistics.events);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test queued loop suppressed", quint64(1), statistics.suppressed);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("test queued loop depth", 3, statistics.maxDepth);
+
+        sNotificationCenter->setMaxCycleRepeats(0);
+        sNotificationCenter->disconnect(connection);
+        sNotificationCenter->disconnect(peerConnection);
+        sNotificationCenter->unregisterEvent(CascadeId);
+        sNotificationCenter->unregisterEvent(CascadePeerId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testDeduplication()
+    {
+        const framework::ConnectionId connection = sNotificationCenter->connect(QtId, keyedCallback);
+        sNotificationCenter->setDeduplicated(QtId, true);
+        gKeyedCount = 0;
+
+        // Three publishers announce the same path, a fourth another one.
+        for (int index = 0; index < 3; ++index) {
+            framework::Event* event = new framework::Event(QtId);
+            event->dictionary["path"] = QString("/tmp/a");
+            event->dictionary["size"] = 10;
+            sNotificationCenter->postEvent(event);
+        }
+        framework::Event* other = new framework::Event(QtId);
+        other->dictionary["size"] = 10;
+        other->dictionary["path"] = QString("/tmp/b");
+        sNotificationCenter->postEvent(other);
+
+        QCoreApplication::processEvents();
+        CPPUNIT_ASSERT_EQUAL(2, gKeyedCount);
+
+        // Once dispatched, the same content is queued again.
+        framework::Event* again = new framework::Event(QtId);
+        again->dictionary["size"] = 10;
+        again->dictionary["path"] = QString("/tmp/a");
+        sNotificationCenter->postEvent(again);
+        QCoreApplication::processEvents();
+        CPPUNIT_ASSERT_EQUAL(3, gKeyedCount);
+
+        // So is the content of an event removed from the queue undispatched.
+        framework::Event* removed = new framework::Event(QtId);
+        removed->dictionary["path"] = QString("/tmp/c");
+        sNotificationCenter->postEvent(removed);
+        QCoreApplication::removePostedEvents(sNotificationCenter);
+
+        framework::Event* requeued = new framework::Event(QtId);
+        requeued->dictionary["path"] = QString("/tmp/c");
+        sNotificationCenter->postEvent(requeued);
+        QCoreApplication::processEvents();
+        CPPUNIT_ASSERT_EQUAL(4, gKeyedCount);
+
+        framework::EventSnapshot snapshot;
+        Q_FOREACH(const framework::EventSnapshot& each, sNotificationCenter->eventSnapshots()) {
+            if (each.eventHash == QtId.getHash()) {
+                snapshot = each;
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(quint64(2), snapshot.deduplicated);
+
+        sNotificationCenter->setDeduplicated(QtId, false);
+        sNotificationCenter->disconnect(connection);
+    }
+
+    void
+    testDeduplicationWithCascadeLimits()
+    {
+        sNotificationCenter->registerEvent(CascadeId);
+        const framework::ConnectionId connection = sNotificationCenter->connect(CascadeId, deduplicatedCascadeCallback);
+        sNotificationCenter->setDeduplicated(CascadeId, true);
+        sNotificationCenter->setMaxCycleRepeats(2);
+        sNotificationCenter->resetCascades();
+        gDeduplicatedCascadeCount = 0;
+
+        // The listener sends its event again, which the cycle limit cuts
+        // on the second round, then queues a copy that is deduplicated.
+        sNotificationCenter->sendEvent(framework::Event(CascadeId));
+        for (int round = 0; round < 5; ++round) {
+            QCoreApplication::processEvents();
+        }
+        CPPUNIT_ASSERT_EQUAL(5, gDeduplicatedCascadeCount);
+        CPPUNIT_ASSERT(sNotificationCenter->cascadeStatistics(CascadeId).suppressed >= 1);
+
+        // Nothing refused is left in the table of queued events.
+        framework::Event* event = new framework::Event(CascadeId);
+        event->dictionary["path"] = QString("/tmp/a");
+        sNotificationCenter->postEvent(event);
+        QCoreApplication::processEvents();
+        CPPUNIT_ASSERT_EQUAL(6, gDeduplicatedCascadeCount);
+
+        sNotificationCenter->setMaxCycleRepeats(0);
+        sNotificationCenter->setDeduplicated(CascadeId, false);
+        sNotificationCenter->disconnect(connection);
+        sNotificationCenter->unregisterEvent(CascadeId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testStickyEvents()
+    {
+        sNotificationCenter->registerEvent(StickyId);
+        sNotificationCenter->setSticky(StickyId, true);
+        CPPUNIT_ASSERT(sNotificationCenter->lastEvent(StickyId) == NULL);
+
+        framework::Event state(StickyId);
+        state.dictionary["value"] = 7;
+        sNotificationCenter->sendEvent(state);
+
+        const framework::Event* last = sNotificationCenter->lastEvent(StickyId);
+        CPPUNIT_ASSERT(last != NULL);
+        CPPUNIT_ASSERT_EQUAL(7, last->dictionary.value("value").toInt());
+
+        // A late listener receives the current state while connecting.
+        gUntypedValue = 0;
+        const framework::ConnectionId connection = sNotificationCenter->connect(StickyId, untypedCallback);
+        CPPUNIT_ASSERT_EQUAL(7, gUntypedValue);
+
+        sNotificationCenter->disconnect(connection);
+        sNotificationCenter->setSticky(StickyId, false);
+        CPPUNIT_ASSERT(sNotificationCenter->lastEvent(StickyId) == NULL);
+        sNotificationCenter->unregisterEvent(StickyId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testStateEvents()
+    {
+        sNotificationCenter->registerEvent(StateId);
+        sNotificationCenter->setStateEvent(StateId, true);
+        const framework::ConnectionId connection = sNotificationCenter->connect(StateId, stateCallback);
+        gStateCount = 0;
+
+        framework::Event* event = new framework::Event(StateId);
+        event->dictionary["quality"] = 1;
+        event->dictionary["samples"] = 64;
+        sNotificationCenter->postEvent(event, framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL(1, gStateCount);
+        CPPUNIT_ASSERT_EQUAL(2, gStateChanges.size());
+
+        // Only the changed key is delivered.
+        event = new framework::Event(StateId);
+        event->dictionary["quality"] = 1;
+        event->dictionary["samples"] = 128;
+        sNotificationCenter->postEvent(event, framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL(2, gStateCount);
+        CPPUNIT_ASSERT_EQUAL(1, gStateChanges.size());
+        CPPUNIT_ASSERT_EQUAL(128, gStateChanges.value("samples").toInt());
+
+        // The same state is not dispatched at all.
+        event = new framework::Event(StateId);
+        event->dictionary["samples"] = 128;
+        event->dictionary["quality"] = 1;
+        sNotificationCenter->postEvent(event, framework::NotificationCenter::POST_NOW);
+        CPPUNIT_ASSERT_EQUAL(2, gStateCount);
+
+        // Removed keys are delivered as invalid values.
+        framework::Event removed(StateId);
+        removed.dictionary["quality"] = 1;
+        sNotificationCenter->sendEvent(removed);
+        CPPUNIT_ASSERT_EQUAL(3, gStateCount);
+        CPPUNIT_ASSERT(gStateChanges.contains("samples"));
+        CPPUNIT_ASSERT(!gStateChanges.value("samples").isValid());
+        CPPUNIT_ASSERT_EQUAL(1, removed.dictionary.size());
+
+        const framework::EventDictionary& state = sNotificationCenter->currentState(StateId);
+        CPPUNIT_ASSERT_EQUAL(1, state.size());
+        CPPUNIT_ASSERT_EQUAL(1, state.value("quality").toInt());
+
+        // Queued states are diffed in the order they are dispatched, so
+        // returning to the state of the last dispatch changes nothing.
+        event = new framework::Event(StateId);
+        event->dictionary["quality"] = 2;
+        sNotificationCenter->postEvent(event);
+        event = new framework::Event(StateId);
+        event->dictionary["quality"] = 1;
+        sNotificationCenter->postEvent(event);
+        QCoreApplication::processEvents();
+        CPPUNIT_ASSERT_EQUAL(5, gStateCount);
+        CPPUNIT_ASSERT_EQUAL(1, gStateChanges.value("quality").toInt());
+        CPPUNIT_ASSERT_EQUAL(1, sNotificationCenter->currentState(StateId).value("quality").toInt());
+
+        sNotificationCenter->disconnect(connection);
+        sNotificationCenter->setStateEvent(StateId, false);
+        sNotificationCenter->unregisterEvent(StateId);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testChromeTrace()
+    {
+        framework::NotificationTrace::setEnabled(true);
+        framework::NotificationTrace::clear();
+
+        sNotificationCenter->postEvent(QtId);
+        QCoreApplication::processEvents();
+
+        // The post and the dispatch carry the same serial.
+        quint32 postSerial = 0;
+        quint32 dispatchSerial = 0;
+        Q_FOREACH(const framework::TraceRecord& record, framework::NotificationTrace::snapshot()) {
+            if (record.eventHash != QtId.getHash())
+                continue;
+            if (record.operation == framework::TRACE_POST) {
+                postSerial = record.argument;
+            } else if (record.operation == framework::TRACE_DISPATCH_BEGIN) {
+                dispatchSerial = record.argument;
+            }
+        }
+        CPPUNIT_ASSERT(postSerial != 0);
+        CPPUNIT_ASSERT_EQUAL(postSerial, dispatchSerial);
+
+        const QByteArray json = framework::NotificationTrace::toChromeTrace(framework::NotificationTrace::snapshot(),
+                                                                            framework::NotificationTrace::eventNames());
+        CPPUNIT_ASSERT(json.startsWith("{"));
+        CPPUNIT_ASSERT(json.contains("\"traceEvents\":["));
+        CPPUNIT_ASSERT(json.contains("\"ph\":\"s\""));
+        CPPUNIT_ASSERT(json.contains("\"ph\":\"f\""));
+        CPPUNIT_ASSERT(json.contains("\"thread_name\""));
+    }
+
+    void
+    testLatency()
+    {
+        framework::LatencyHistogram histogram;
+        for (int value = 1; value <= 100; ++value) {
+            histogram.record(value);
+        }
+        CPPUNIT_ASSERT_EQUAL(quint64(100), histogram.count());
+        CPPUNIT_ASSERT_EQUAL(quint64(1), histogram.minimum());
+        CPPUNIT_ASSERT_EQUAL(quint64(100), histogram.percentile(100.0));
+
+        // Buckets are at most an eighth wide.
+        const quint64 median = histogram.percentile(50.0);
+        CPPUNIT_ASSERT(median >= 50 && median <= 57);
+
+        // A posted event is timed in the queue and in dispatch.
+        sNotificationCenter->resetLatency();
+        sNotificationCenter->postEvent(QtId);
+        QCoreApplication::processEvents();
+
+        const framework::EventLatency latency = sNotificationCenter->latency(QtId);
+        CPPUNIT_ASSERT_EQUAL(quint64(1), latency.queue.count());
+        CPPUNIT_ASSERT_EQUAL(quint64(1), latency.dispatch.count());
+
+        const QVariantMap statistics = sNotificationCenter->latencyStatistics(QtId);
+        CPPUNIT_ASSERT_EQUAL(qulonglong(1), statistics.value("queue").toMap().value("count").toULongLong());
+    }
+
+    void
+    testListenerProfiling()
+    {
+        // Connections made before profiling was turned on are measured too.
+        const framework::ConnectionId connection = sNotificationCenter->connect(QtId, untypedCallback, "profiledCallback");
+        sNotificationCenter->setListenerProfiling(true);
+        const framework::ConnectionId later = sNotificationCenter->connect(QtId, untypedCallback);
+
+        sNotificationCenter->sendEvent(framework::Event(QtId));
+        sNotificationCenter->sendEvent(framework::Event(QtId));
+
+        const framework::ListenerProfile profile = listenerProfile(connection);
+        CPPUNIT_ASSERT_EQUAL(connection, profile.connection);
+        CPPUNIT_ASSERT(profile.name == "profiledCallback");
+        CPPUNIT_ASSERT_EQUAL(quint64(2), profile.calls);
+        CPPUNIT_ASSERT(profile.maxNanoseconds <= profile.totalNanoseconds);
+        CPPUNIT_ASSERT_EQUAL(quint64(2), listenerProfile(later).calls);
+        CPPUNIT_ASSERT(listenerProfile(later).name == QString::fromStdString(framework::DEFAULT_CALLBACK_NAME));
+
+        // Paused profiling stops counting.
+        sNotificationCenter->setListenerProfiling(false);
+        sNotificationCenter->sendEvent(framework::Event(QtId));
+        CPPUNIT_ASSERT_EQUAL(quint64(2), listenerProfile(connection).calls);
+
+        sNotificationCenter->disconnect(connection);
+        sNotificationCenter->disconnect(later);
+        CPPUNIT_ASSERT_EQUAL(framework::ConnectionId(0), listenerProfile(connection).connection);
+        QCoreApplication::processEvents();
+    }
+
+    void
+    testEventSnapshot()
+    {
+        const framework::ConnectionId connection = sNotificationCenter->connect(QtId, untypedCallback);
+        sNotificationCenter->postEvent(QtId);
+
+        framework::EventSnapshot before;
+        Q_FOREACH(const framework::EventSnapshot& snapshot, sNotificationCenter->eventSnapshots()) {
+            if (snapshot.eventHash == QtId.getHash()) {
+                before = snapshot;
+            }
+        }
+        CPPUNIT_ASSERT(before.registered);
+        CPPUNIT_ASSERT(before.statistics.boostConnections >= 1);
+        CPPUNIT_ASSERT(before.queued >= 1);
+
+        QCoreApplication::processEvents();
+
+        framework::EventSnapshot after;
+        Q_FOREACH(const framework::EventSnapshot& snapshot, sNotificationCenter->eventSnapshots()) {
+            if (snapshot.eventHash == QtId.getHash()) {
+                after = snapshot;
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(0, after.queued);
+        CPPUNIT_ASSERT(after.statistics.dispatched > before.statistics.dispatched);
+
+        sNotificationCenter->disconnect(connection);
+        CPPUNIT_ASSERT(sNotificationCenter->eventSnapshotJson().startsWith('['));
+    }
+
+    void
+    testMetrics()
+    {
+        sNotificationCenter->resetLatency();
+        sNotificationCenter->postEvent(QtId);
+        QCoreApplication::processEvents();
+
+        const QByteArray metrics = framework::NotificationMetricsServer::metrics(*sNotificationCenter);
+        const QByteArray label = "{event=\"" + QtId.getStringId().toUtf8() + "\"";
+        CPPUNIT_ASSERT(metrics.contains("# TYPE notification_events_posted_total counter\n"));
+        CPPUNIT_ASSERT(metrics.contains("notification_event_queue_depth" + label + "} 0\n"));
+        CPPUNIT_ASSERT(metrics.contains("notification_event_queue_seconds_count" + label + "} 1\n"));
+        CPPUNIT_ASSERT(metrics.contains("notification_event_dispatch_seconds" + label + ",quantile=\"0.99\"}"));
+    }
+
     void 
     testEventIsDeferred() 
     {
@@ -331,6 +1388,7 @@ public:
 
     
     void toggleTestValue();
+    void memberCallback(const framework::Event& inEvent) { Q_UNUSED(inEvent); toggleTestValue(); }
 
     // Set up the unit tests
     CPPUNIT_TEST_SUITE(TestNotificationCenter);
@@ -338,14 +1396,41 @@ public:
     CPPUNIT_TEST(testEventRegistration);
    	CPPUNIT_TEST(testDuplicateEventRegistration);
     CPPUNIT_TEST(testDeferredEventRegistration);
+    CPPUNIT_TEST(testEventUnregistration);
+    CPPUNIT_TEST(testEventRelease);
 
     CPPUNIT_TEST(testQtEventPosting);
     CPPUNIT_TEST(testQtEventSending);
     CPPUNIT_TEST(testQtEventDisconnect);
+    CPPUNIT_TEST(testQtIndependentDisconnect);
+    CPPUNIT_TEST(testQtMemberConnection);
+    CPPUNIT_TEST(testEventSignal);
 	
     CPPUNIT_TEST(testBoostEventPosting);
     CPPUNIT_TEST(testBoostEventSending);
+    CPPUNIT_TEST(testStackEventSending);
     CPPUNIT_TEST(testBoostEventDisconnect);
+    CPPUNIT_TEST(testReentrantConnections);
+    CPPUNIT_TEST(testSealedDispatch);
+    CPPUNIT_TEST(testKeyedDispatch);
+    CPPUNIT_TEST(testTypedEventPosting);
+    CPPUNIT_TEST(testLazyEventPosting);
+    CPPUNIT_TEST(testEventDictionary);
+    CPPUNIT_TEST(testMemberEventPosting);
+    CPPUNIT_TEST(testTrace);
+    CPPUNIT_TEST(testChromeTrace);
+    CPPUNIT_TEST(testParallelDispatch);
+    CPPUNIT_TEST(testCascadeLimits);
+    CPPUNIT_TEST(testQueuedRepostIsNotCut);
+    CPPUNIT_TEST(testQueuedLoopIsCut);
+    CPPUNIT_TEST(testDeduplication);
+    CPPUNIT_TEST(testDeduplicationWithCascadeLimits);
+    CPPUNIT_TEST(testStickyEvents);
+    CPPUNIT_TEST(testStateEvents);
+    CPPUNIT_TEST(testLatency);
+    CPPUNIT_TEST(testListenerProfiling);
+    CPPUNIT_TEST(testEventSnapshot);
+    CPPUNIT_TEST(testMetrics);
 
 	CPPUNIT_TEST(testEventIsDeferred);
 	CPPUNIT_TEST(testEventIsNotDeferred);
@@ -375,6 +1460,129 @@ boostCallback(const framework::Event& inEvent)
     }    
 }
 
+//=============================================================================
+// reentrantCallback
+//=============================================================================
+void
+reentrantCallback(const framework::Event& inEvent)
+{
+    Q_UNUSED(inEvent);
+
+    ++gReentrantCount;
+    sNotificationCenter->disconnect(gReentrantId);
+    gReentrantId = sNotificationCenter->connect(ReentrantId, boostCallback);
+}
+
+//=============================================================================
+// cascadeCallback
+//=============================================================================
+void
+cascadeCallback(const framework::Event& inEvent)
+{
+    ++gCascadeCount;
+    gCascadeDepth = qMax(gCascadeDepth, inEvent.cascadeDepth);
+    sNotificationCenter->postEvent(new framework::Event(CascadeId), framework::NotificationCenter::POST_NOW);
+}
+
+//=============================================================================
+// repostCallback
+//=============================================================================
+void
+repostCallback(const framework::Event& inEvent)
+{
+    if (++gRepostCount < 10) {
+        sNotificationCenter->postEvent(inEvent.id);
+    }
+}
+
+//=============================================================================
+// pingPongCallback
+//=============================================================================
+void
+pingPongCallback(const framework::Event& inEvent)
+{
+    ++gPingPongCount;
+    sNotificationCenter->postEvent(inEvent.id == CascadeId ? CascadePeerId : CascadeId);
+}
+
+//=============================================================================
+// deduplicatedCascadeCallback
+//=============================================================================
+void
+deduplicatedCascadeCallback(const framework::Event& inEvent)
+{
+    if (++gDeduplicatedCascadeCount >= 4)
+        return;
+
+    sNotificationCenter->sendEvent(framework::Event(inEvent.id));
+
+    framework::Event* queued = new framework::Event(inEvent.id);
+    queued->dictionary["path"] = QString("/tmp/a");
+    sNotificationCenter->postEvent(queued);
+}
+
+//=============================================================================
+// keyedCallback
+//=============================================================================
+void
+keyedCallback(const framework::Event& inEvent)
+{
+    Q_UNUSED(inEvent);
+    ++gKeyedCount;
+}
+
+//=============================================================================
+// typedCallback
+//=============================================================================
+void
+typedCallback(const TypedPayload& inPayload)
+{
+    gTypedValue = inPayload.value;
+}
+
+//=============================================================================
+// untypedCallback
+//=============================================================================
+void
+untypedCallback(const framework::Event& inEvent)
+{
+    gUntypedValue = inEvent.dictionary.value("value").toInt();
+}
+
+//=============================================================================
+// stateCallback
+//=============================================================================
+void
+stateCallback(const framework::Event& inEvent)
+{
+    ++gStateCount;
+    gStateChanges = inEvent.dictionary;
+}
+
+//=============================================================================
+// buildPayload
+//=============================================================================
+void
+buildPayload(framework::EventDictionary& outDictionary)
+{
+    ++gBuildCount;
+    outDictionary["value"] = 5;
+}
+
+//=============================================================================
+// listenerProfile
+//=============================================================================
+framework::ListenerProfile
+listenerProfile(framework::ConnectionId inConnection)
+{
+    Q_FOREACH(const framework::ListenerProfile& profile, sNotificationCenter->listenerProfiles()) {
+        if (profile.connection == inConnection) {
+            return profile;
+        }
+    }
+    return framework::ListenerProfile();
+}
+
 // Register this test for execution
 CPPUNIT_TEST_SUITE_REGISTRATION(TestNotificationCenter);
 